@@ -0,0 +1,168 @@
+#include "HeadlessDevice.hpp"
+
+#include "VkIgnite/AsyncCompute.hpp"
+#include "VkIgnite/Frustum.hpp"
+#include "VkIgnite/GpuCulling.hpp"
+
+#include "Pch/Glm.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Measure how much of the GPU culling is hidden when it runs on the async compute queue while the
+// graphics queue is busy, compared to recording it in the graphics command buffer.
+//
+// The graphics work is stood in for by culling passes over another object set. In the overlapped
+// path the graphics queue only waits for the async culling at the end of the frame, like the
+// indirect draws of a real frame would after the work preceding them.
+// Usage: async-compute-benchmark [object count] [graphics passes] [frames]
+
+namespace {
+
+std::vector<vki::GpuCullObject> makeObjects(uint32_t objectCount, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::vector<vki::GpuCullObject> objects(objectCount);
+    for (vki::GpuCullObject& object : objects) {
+        object = {
+            .boundingSphere = glm::vec4(position(random), position(random), position(random), 1.0f),
+            .indexCount = 36,
+            .firstIndex = 0,
+            .vertexOffset = 0,
+        };
+    }
+    return objects;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t objectCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 1'000'000;
+    const uint32_t graphicsPasses = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 16;
+    const uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 50;
+
+    try {
+        vki::DeviceFeatureChain requiredFeatures;
+        requiredFeatures.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore = vk::True;
+        const vki::benchmarks::HeadlessDevice headlessDevice
+            = vki::benchmarks::HeadlessDevice::make("async-compute-benchmark", requiredFeatures);
+        const vk::Device device = *headlessDevice.device.handle;
+        const vki::QueueTopology& queueTopology = headlessDevice.queueTopology;
+        const vk::Queue graphicsQueue = headlessDevice.queues.graphics;
+
+        vki::AsyncCompute asyncCompute({
+            .device = device,
+            .queueTopology = queueTopology,
+            .framesInFlight = 1,
+        });
+        vki::GpuCulling culling({
+            .physicalDevice = headlessDevice.deviceInfo.handle,
+            .device = device,
+            .queue = graphicsQueue,
+            .queueFamilyIndex = queueTopology.graphics,
+            .maxObjectCount = objectCount,
+            .framesInFlight = 1,
+            .asyncCompute = &asyncCompute,
+        });
+        vki::GpuCulling graphicsLoad({
+            .physicalDevice = headlessDevice.deviceInfo.handle,
+            .device = device,
+            .queue = graphicsQueue,
+            .queueFamilyIndex = queueTopology.graphics,
+            .maxObjectCount = objectCount,
+            .framesInFlight = 1,
+        });
+        std::mt19937 random(42);
+        culling.setObjects(makeObjects(objectCount, random));
+        graphicsLoad.setObjects(makeObjects(objectCount, random));
+
+        const vki::Frustum frustum {
+            .planes = {
+                glm::vec4(1.0f, 0.0f, 0.0f, 50.0f),
+                glm::vec4(-1.0f, 0.0f, 0.0f, 50.0f),
+                glm::vec4(0.0f, 1.0f, 0.0f, 50.0f),
+                glm::vec4(0.0f, -1.0f, 0.0f, 50.0f),
+                glm::vec4(0.0f, 0.0f, 1.0f, 50.0f),
+                glm::vec4(0.0f, 0.0f, -1.0f, 50.0f),
+            },
+        };
+
+        const vk::UniqueCommandPool commandPool = device.createCommandPoolUnique({
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
+            .queueFamilyIndex = queueTopology.graphics,
+        });
+        const vk::CommandBuffer commandBuffer = device.allocateCommandBuffers({
+            .commandPool = *commandPool,
+            .level = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1,
+        })[0];
+        const vk::UniqueFence fence = device.createFenceUnique({});
+
+        auto runFrame = [&](bool overlapped) {
+            device.resetCommandPool(*commandPool);
+            commandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+            if (!overlapped) {
+                culling.recordCulling(commandBuffer, 0, frustum);
+            }
+            for (uint32_t pass = 0; pass < graphicsPasses; pass++) {
+                graphicsLoad.recordCulling(commandBuffer, 0, frustum);
+            }
+            commandBuffer.end();
+
+            if (overlapped) {
+                const vki::TimelineWait cullingWait = culling.submitCulling(0, frustum);
+                vki::submitWithTimelines(
+                    graphicsQueue,
+                    { .commandBuffers = { &commandBuffer, 1 } });
+                // The fence also covers the graphics work submitted before
+                vki::submitWithTimelines(graphicsQueue, { .waits = { &cullingWait, 1 } }, *fence);
+            } else {
+                vki::submitWithTimelines(
+                    graphicsQueue,
+                    { .commandBuffers = { &commandBuffer, 1 } },
+                    *fence);
+            }
+            if (device.waitForFences({ *fence }, vk::True, std::numeric_limits<uint64_t>::max())
+                != vk::Result::eSuccess) {
+                throw std::runtime_error("Failed to wait for the frame fence");
+            }
+            device.resetFences({ *fence });
+        };
+
+        const double serialDuration = vki::benchmarks::measureMedian(frames, [&] {
+            runFrame(false);
+        });
+        const double overlappedDuration = vki::benchmarks::measureMedian(frames, [&] {
+            runFrame(true);
+        });
+
+        std::cout << std::format(
+            "{} objects, {} graphics passes, median of {} frames\n",
+            objectCount,
+            graphicsPasses,
+            frames);
+        if (!asyncCompute.isDedicated()) {
+            std::cout << "No dedicated async compute family, both paths use the graphics queue\n";
+        }
+        std::cout << std::format("{:<24}{:>10.3f} ms\n", "culling on graphics", serialDuration);
+        std::cout << std::format(
+            "{:<24}{:>10.3f} ms {:>6.2f}x\n",
+            "culling on async",
+            overlappedDuration,
+            serialDuration / overlappedDuration);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
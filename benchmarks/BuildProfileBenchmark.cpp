@@ -0,0 +1,67 @@
+#include "HeadlessDevice.hpp"
+#include "StateCommandStream.hpp"
+
+#include "VkIgnite/BuildProfile.hpp"
+
+#include "Pch/Spdlog.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// Record the command stream of command-recording-benchmark with the default dispatcher, as the
+// application does, on an instance and device created under each build profile. The difference
+// is the CPU cost of the validation layer and of the debug messenger of the profile.
+// Usage: build-profile-benchmark [draw count] [passes]
+
+int main(int argc, char** argv)
+{
+    const uint32_t drawCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100'000;
+    const uint32_t passes = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20;
+
+    // The messages are still queued and processed by the sink, only their printing is skipped
+    spdlog::set_level(spdlog::level::warn);
+
+    constexpr std::array<vki::BuildProfile, 3> kProfiles {
+        vki::BuildProfile::Dev,
+        vki::BuildProfile::Profile,
+        vki::BuildProfile::Production,
+    };
+
+    std::cout << std::format(
+        "{} draws of 4 state commands, median of {} passes\n",
+        drawCount,
+        passes);
+    bool failed = false;
+    for (vki::BuildProfile profile : kProfiles) {
+        const std::string_view profileName = vki::getBuildProfileName(profile);
+        try {
+            const vki::benchmarks::HeadlessDevice headlessDevice
+                = vki::benchmarks::HeadlessDevice::make("build-profile-benchmark", {}, profile);
+            const vki::benchmarks::StateCommandStream commandStream
+                = vki::benchmarks::StateCommandStream::make(headlessDevice);
+
+            const double duration = vki::benchmarks::measureMedian(passes, [&] {
+                commandStream.record(drawCount, VULKAN_HPP_DEFAULT_DISPATCHER);
+            });
+
+            const vki::DebugMessageSink* sink = headlessDevice.instance.debugMessageSink.get();
+            std::cout << std::format(
+                "{:<24}{:>10.3f} ms, {} debug messages dropped\n",
+                profileName,
+                duration,
+                sink != nullptr ? sink->getDroppedMessageCount() : 0);
+        } catch (const std::exception& e) {
+            // The dev and profile builds need the validation layer to be installed
+            std::cerr << profileName << ": " << e.what() << "\n";
+            failed = true;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "HeadlessDevice.hpp"
+#include "StateCommandStream.hpp"
+
+#include "VkIgnite/DeviceDispatch.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <string>
+
+// Compare recording the state commands of many draws through the loader trampolines, with
+// function pointers queried from the instance, and through a DeviceDispatch calling the driver
+// directly. Only state commands are recorded, so no render pass nor pipeline is needed.
+// Usage: command-recording-benchmark [draw count] [passes]
+
+int main(int argc, char** argv)
+{
+    const uint32_t drawCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100'000;
+    const uint32_t passes = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20;
+
+    try {
+        const vki::benchmarks::HeadlessDevice headlessDevice
+            = vki::benchmarks::HeadlessDevice::make("command-recording-benchmark");
+        const vk::Instance instance = *headlessDevice.instance.handle;
+        const vk::Device device = *headlessDevice.device.handle;
+
+        // Device commands queried from the instance resolve to the loader trampolines
+        const vk::DispatchLoaderDynamic trampolineDispatch(
+            instance,
+            VULKAN_HPP_DEFAULT_DISPATCHER.vkGetInstanceProcAddr);
+        const vki::DeviceDispatch deviceDispatch = vki::DeviceDispatch::make(instance, device);
+
+        const vki::benchmarks::StateCommandStream commandStream
+            = vki::benchmarks::StateCommandStream::make(headlessDevice);
+
+        const double trampolineDuration = vki::benchmarks::measureMedian(passes, [&] {
+            commandStream.record(drawCount, trampolineDispatch);
+        });
+        const double directDuration = vki::benchmarks::measureMedian(passes, [&] {
+            commandStream.record(drawCount, deviceDispatch.get());
+        });
+
+        std::cout << std::format(
+            "{} draws of 4 state commands, median of {} passes\n",
+            drawCount,
+            passes);
+        std::cout << std::format("{:<24}{:>10.3f} ms\n", "loader trampolines", trampolineDuration);
+        std::cout << std::format(
+            "{:<24}{:>10.3f} ms {:>6.2f}x\n",
+            "device dispatch",
+            directDuration,
+            trampolineDuration / directDuration);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "VkIgnite/CpuCulling.hpp"
+#include "VkIgnite/Frustum.hpp"
+
+#include "Stdx/ThreadPool.hpp"
+
+#include "Pch/Glm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compare the SoA culling kernels of VkIgnite with a plain loop over an array of glm spheres.
+// Usage: cpu-culling-benchmark [sphere count] [passes]
+
+namespace {
+
+// Array of structures layout the kernels are compared with
+struct Sphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// 90 degrees field of view looking down -Z from the origin, from 0.1 to 100
+vki::Frustum makeFrustum()
+{
+    const float invSqrt2 = 1.0f / std::sqrt(2.0f);
+    return {
+        .planes = {
+            glm::vec4(invSqrt2, 0.0f, -invSqrt2, 0.0f), // Left
+            glm::vec4(-invSqrt2, 0.0f, -invSqrt2, 0.0f), // Right
+            glm::vec4(0.0f, invSqrt2, -invSqrt2, 0.0f), // Bottom
+            glm::vec4(0.0f, -invSqrt2, -invSqrt2, 0.0f), // Top
+            glm::vec4(0.0f, 0.0f, -1.0f, -0.1f), // Near
+            glm::vec4(0.0f, 0.0f, 1.0f, 100.0f), // Far
+        },
+    };
+}
+
+// Median duration of a pass in milliseconds, after a warm up pass
+double measure(uint32_t passes, const std::function<void()>& pass)
+{
+    pass();
+    std::vector<double> durations;
+    for (uint32_t i = 0; i < passes; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        pass();
+        const auto end = std::chrono::steady_clock::now();
+        durations.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::ranges::nth_element(durations, durations.begin() + durations.size() / 2);
+    return durations[durations.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t sphereCount = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    const uint32_t passes = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> radius(0.0f, 2.0f);
+    std::vector<Sphere> spheres(sphereCount);
+    vki::BoundsStore bounds;
+    for (Sphere& sphere : spheres) {
+        sphere.center = glm::vec3(position(random), position(random), position(random));
+        sphere.radius = radius(random);
+        bounds.add(sphere.center, sphere.radius);
+    }
+    const vki::Frustum frustum = makeFrustum();
+
+    // Both paths output the indices of the visible objects
+    std::vector<uint32_t> expectedVisibleObjects;
+    expectedVisibleObjects.reserve(sphereCount);
+    const double aosDuration = measure(passes, [&] {
+        expectedVisibleObjects.clear();
+        for (uint32_t objectIndex = 0; objectIndex < spheres.size(); objectIndex++) {
+            const Sphere& sphere = spheres[objectIndex];
+            if (frustum.intersectsSphere(sphere.center, sphere.radius)) {
+                expectedVisibleObjects.push_back(objectIndex);
+            }
+        }
+    });
+    std::cout << std::format(
+        "{} spheres, {} visible, median of {} passes\n",
+        sphereCount,
+        expectedVisibleObjects.size(),
+        passes);
+    std::cout << std::format("{:<24}{:>10.3f} ms\n", "glm AoS loop", aosDuration);
+
+    std::vector<uint16_t> visibilityMasks(bounds.chunks().size());
+    std::vector<uint32_t> visibleObjects;
+    visibleObjects.reserve(sphereCount);
+    stdx::ThreadPool threadPool;
+    bool mismatch = false;
+    for (vki::CullingKernel kernel : {
+             vki::CullingKernel::Scalar,
+             vki::CullingKernel::Sse,
+             vki::CullingKernel::Avx2,
+             vki::CullingKernel::Avx512,
+         }) {
+        if (static_cast<int>(kernel) > static_cast<int>(vki::getBestCullingKernel())) {
+            continue;
+        }
+        for (bool parallel : { false, true }) {
+            const double duration = measure(passes, [&] {
+                if (parallel) {
+                    vki::cullSpheresParallel(
+                        threadPool,
+                        frustum,
+                        bounds.chunks(),
+                        visibilityMasks,
+                        kernel);
+                } else {
+                    vki::cullSpheres(frustum, bounds.chunks(), visibilityMasks, kernel);
+                }
+                visibleObjects.clear();
+                vki::collectVisibleObjects(visibilityMasks, visibleObjects);
+            });
+            const bool matches = visibleObjects == expectedVisibleObjects;
+            mismatch |= !matches;
+            std::cout << std::format(
+                "{:<24}{:>10.3f} ms {:>6.1f}x{}\n",
+                std::format("{}{}", vki::getCullingKernelName(kernel), parallel ? " parallel" : ""),
+                duration,
+                aosDuration / duration,
+                matches ? "" : " MISMATCH");
+        }
+    }
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include "HeadlessDevice.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace vki::benchmarks {
+
+[[nodiscard]] HeadlessDevice HeadlessDevice::make(
+    const std::string& applicationName,
+    const DeviceFeatureChain& requiredFeatures,
+    BuildProfile buildProfile)
+{
+    InstanceCreateInfo instanceCreateInfo {
+        .applicationInfo = {
+            .applicationName = applicationName,
+            .engineName = "VkIgnite",
+        },
+    };
+    applyBuildProfile(instanceCreateInfo, buildProfile);
+    Instance instance = Instance::make(instanceCreateInfo);
+
+    for (PhysicalDeviceInfo& deviceInfo : queryPhysicalDeviceInfos(*instance.handle)) {
+        const std::optional<QueueTopology> queueTopology = findQueueTopology(deviceInfo, {});
+        if (!queueTopology.has_value() || deviceInfo.properties.apiVersion < VK_API_VERSION_1_2) {
+            continue;
+        }
+        Device device;
+        try {
+            device = Device::make(
+                deviceInfo,
+                {
+                    .queueCreateInfos = makeQueueCreateInfos(*queueTopology),
+                    .requiredFeatures = requiredFeatures,
+                });
+        } catch (const std::runtime_error& e) {
+            spdlog::info("Skipping {}: {}", deviceInfo.name(), e.what());
+            continue;
+        }
+        spdlog::info("Benchmarking on {}", deviceInfo.name());
+        const Queues queues = getQueues(*device.handle, *queueTopology);
+        return {
+            .instance = std::move(instance),
+            .deviceInfo = std::move(deviceInfo),
+            .queueTopology = *queueTopology,
+            .device = std::move(device),
+            .queues = queues,
+        };
+    }
+    throw std::runtime_error("No Vulkan 1.2 device with the required features");
+}
+
+[[nodiscard]] double measureMedian(uint32_t passes, const std::function<void()>& pass)
+{
+    // The median of no duration is undefined, a pass count of 0 still measures one pass
+    passes = std::max(passes, 1u);
+    pass();
+    std::vector<double> durations;
+    for (uint32_t i = 0; i < passes; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        pass();
+        const auto end = std::chrono::steady_clock::now();
+        durations.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::ranges::nth_element(durations, durations.begin() + durations.size() / 2);
+    return durations[durations.size() / 2];
+}
+
+} // namespace vki::benchmarks
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "VkIgnite/BuildProfile.hpp"
+#include "VkIgnite/Device.hpp"
+#include "VkIgnite/Instance.hpp"
+#include "VkIgnite/PhysicalDeviceInfo.hpp"
+#include "VkIgnite/QueueTopology.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace vki::benchmarks {
+
+// Instance and device without window nor surface, for the GPU benchmarks. The first Vulkan 1.2
+// device with a graphics and compute family and the required features is picked, and is created
+// with one queue per family of its topology and the supported performance features. The instance
+// validation and debug messenger follow the build profile, none by default.
+struct HeadlessDevice {
+    [[nodiscard]] static HeadlessDevice make(
+        const std::string& applicationName,
+        const DeviceFeatureChain& requiredFeatures = {},
+        BuildProfile buildProfile = BuildProfile::Production);
+
+    Instance instance;
+    PhysicalDeviceInfo deviceInfo;
+    QueueTopology queueTopology;
+    Device device;
+    Queues queues;
+};
+
+// Median duration of a pass in milliseconds, after a warm up pass. At least one pass is measured
+[[nodiscard]] double measureMedian(uint32_t passes, const std::function<void()>& pass);
+
+} // namespace vki::benchmarks
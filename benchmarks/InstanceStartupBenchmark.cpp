@@ -0,0 +1,115 @@
+#include "HeadlessDevice.hpp"
+
+#include "VkIgnite/Instance.hpp"
+
+#include "Pch/Spdlog.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compare the instance layer and extension checks enumerating the loader properties for each
+// check, as Instance::make used to, with the cached InstanceEnumeration, and measure a whole
+// Instance::make with the debug messenger. No physical device is needed.
+// Usage: instance-startup-benchmark [passes]
+
+namespace {
+
+// Layers and extensions the application checks before creating its instance
+constexpr std::array<std::string_view, 6> kCheckedNames {
+    "VK_LAYER_KHRONOS_validation",
+    VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+    VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME,
+    VK_KHR_SURFACE_EXTENSION_NAME,
+    VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME,
+    VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME,
+};
+
+bool isAvailableUncached(std::string_view name)
+{
+    if (name.starts_with("VK_LAYER_")) {
+        for (const vk::LayerProperties& layer : vk::enumerateInstanceLayerProperties()) {
+            if (name == layer.layerName) {
+                return true;
+            }
+        }
+        return false;
+    }
+    for (const vk::ExtensionProperties& extension : vk::enumerateInstanceExtensionProperties()) {
+        if (name == extension.extensionName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isAvailableCached(std::string_view name)
+{
+    const vki::InstanceEnumeration& enumeration = vki::InstanceEnumeration::get();
+    return name.starts_with("VK_LAYER_") ? enumeration.hasLayer(name)
+                                         : enumeration.hasExtension(name);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t passes = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 20;
+
+    // Instance::make logs its creation time on each pass
+    spdlog::set_level(spdlog::level::warn);
+
+    try {
+        // The first call enumerates the loader properties and loads the loader entry points
+        const auto startTime = std::chrono::steady_clock::now();
+        (void)vki::InstanceEnumeration::get();
+        const double firstEnumerationDuration = std::chrono::duration<double, std::milli>(
+                                                    std::chrono::steady_clock::now() - startTime)
+                                                    .count();
+
+        uint32_t availableCount = 0;
+        const double uncachedDuration = vki::benchmarks::measureMedian(passes, [&] {
+            availableCount = 0;
+            for (std::string_view name : kCheckedNames) {
+                availableCount += isAvailableUncached(name) ? 1 : 0;
+            }
+        });
+        const double cachedDuration = vki::benchmarks::measureMedian(passes, [&] {
+            for (std::string_view name : kCheckedNames) {
+                (void)isAvailableCached(name);
+            }
+        });
+        const double instanceDuration = vki::benchmarks::measureMedian(passes, [] {
+            const vki::Instance instance = vki::Instance::make({
+                .applicationInfo = { .applicationName = "instance-startup-benchmark" },
+                .optionalLayerNames = { "VK_LAYER_KHRONOS_validation" },
+                .debugUtilsMessengerEXTOption = vki::Option::Enabled,
+            });
+        });
+
+        std::cout << std::format(
+            "{} checks, {} available, median of {} passes\n",
+            kCheckedNames.size(),
+            availableCount,
+            passes);
+        std::cout << std::format("{:<32}{:>10.3f} ms\n", "enumeration per check", uncachedDuration);
+        std::cout << std::format(
+            "{:<32}{:>10.3f} ms, after {:.3f} ms for the first enumeration\n",
+            "cached enumeration",
+            cachedDuration,
+            firstEnumerationDuration);
+        std::cout << std::format("{:<32}{:>10.3f} ms\n", "Instance::make", instanceDuration);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+#include "HeadlessDevice.hpp"
+
+#include "VkIgnite/Instance.hpp"
+#include "VkIgnite/PhysicalDeviceInfo.hpp"
+
+#include "Pch/Spdlog.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compare the device checks of the picker querying the driver on each use, as
+// PhysicalDevicePicker::pick used to, with the checks reading the snapshots of
+// queryPhysicalDeviceInfos. No surface is needed, so the surface support and swapchain queries are
+// left out of both.
+// Usage: physical-device-picker-benchmark [passes]
+
+namespace {
+
+constexpr std::array<std::string_view, 3> kCheckedExtensions {
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    VK_KHR_PRESENT_ID_EXTENSION_NAME,
+    VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+};
+
+uint32_t getDeviceTypePreference(vk::PhysicalDeviceType deviceType)
+{
+    switch (deviceType) {
+    case vk::PhysicalDeviceType::eDiscreteGpu:
+        return 3;
+    case vk::PhysicalDeviceType::eIntegratedGpu:
+        return 2;
+    case vk::PhysicalDeviceType::eVirtualGpu:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+bool hasGraphicsComputeFamily(std::span<const vk::QueueFamilyProperties> families)
+{
+    constexpr vk::QueueFlags kFlags = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+    return std::ranges::any_of(families, [&](const vk::QueueFamilyProperties& family) {
+        return family.queueCount > 0 && (family.queueFlags & kFlags) == kFlags;
+    });
+}
+
+// Outcome of the checks, compared between the two paths
+struct PickSummary {
+    uint32_t compatibleCount = 0;
+    uint32_t availableExtensionCount = 0;
+
+    bool operator==(const PickSummary&) const = default;
+};
+
+// One query per use: the properties for the log, the compatibility check and each comparison of
+// the sort, and the queue families for the graphics and the presentation family lookups
+PickSummary pickUncached(vk::Instance instance)
+{
+    PickSummary summary;
+    std::vector<vk::PhysicalDevice> compatibleDevices;
+    for (vk::PhysicalDevice physicalDevice : instance.enumeratePhysicalDevices()) {
+        spdlog::debug("Device: ID={}", physicalDevice.getProperties().deviceID);
+
+        const std::vector extensions = physicalDevice.enumerateDeviceExtensionProperties();
+        for (std::string_view checkedExtension : kCheckedExtensions) {
+            const bool isAvailable
+                = std::ranges::any_of(extensions, [&](const vk::ExtensionProperties& extension) {
+                      return checkedExtension == extension.extensionName;
+                  });
+            summary.availableExtensionCount += isAvailable ? 1 : 0;
+        }
+
+        const bool hasGraphicsFamily
+            = hasGraphicsComputeFamily(physicalDevice.getQueueFamilyProperties());
+        // Without surface, any family counts as a presentation family
+        const bool hasPresentationFamily = !physicalDevice.getQueueFamilyProperties().empty();
+
+        spdlog::debug("Checking {}", std::string_view(physicalDevice.getProperties().deviceName));
+        if (hasGraphicsFamily && hasPresentationFamily) {
+            compatibleDevices.push_back(physicalDevice);
+        }
+    }
+    std::ranges::sort(
+        compatibleDevices,
+        [](vk::PhysicalDevice device1, vk::PhysicalDevice device2) {
+            return getDeviceTypePreference(device1.getProperties().deviceType)
+                > getDeviceTypePreference(device2.getProperties().deviceType);
+        });
+    summary.compatibleCount = static_cast<uint32_t>(compatibleDevices.size());
+    return summary;
+}
+
+// One snapshot per device, the checks only read it
+PickSummary pickCached(vk::Instance instance)
+{
+    PickSummary summary;
+    std::vector<vki::PhysicalDeviceInfo> compatibleDevices;
+    for (vki::PhysicalDeviceInfo& deviceInfo : vki::queryPhysicalDeviceInfos(instance)) {
+        spdlog::debug("Device: ID={}", deviceInfo.properties.deviceID);
+
+        for (std::string_view checkedExtension : kCheckedExtensions) {
+            summary.availableExtensionCount += deviceInfo.hasExtension(checkedExtension) ? 1 : 0;
+        }
+
+        spdlog::debug("Checking {}", deviceInfo.name());
+        if (hasGraphicsComputeFamily(deviceInfo.queueFamilies)
+            && !deviceInfo.queueFamilies.empty()) {
+            compatibleDevices.push_back(std::move(deviceInfo));
+        }
+    }
+    std::ranges::sort(
+        compatibleDevices,
+        std::ranges::greater {},
+        [](const vki::PhysicalDeviceInfo& deviceInfo) {
+            return getDeviceTypePreference(deviceInfo.properties.deviceType);
+        });
+    summary.compatibleCount = static_cast<uint32_t>(compatibleDevices.size());
+    return summary;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t passes = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 20;
+
+    spdlog::set_level(spdlog::level::warn);
+
+    try {
+        const vki::Instance instance = vki::Instance::make({
+            .applicationInfo = { .applicationName = "physical-device-picker-benchmark" },
+        });
+        const uint32_t deviceCount
+            = static_cast<uint32_t>(instance.handle->enumeratePhysicalDevices().size());
+
+        PickSummary uncachedSummary;
+        const double uncachedDuration = vki::benchmarks::measureMedian(passes, [&] {
+            uncachedSummary = pickUncached(*instance.handle);
+        });
+        PickSummary cachedSummary;
+        const double cachedDuration = vki::benchmarks::measureMedian(passes, [&] {
+            cachedSummary = pickCached(*instance.handle);
+        });
+        if (uncachedSummary != cachedSummary) {
+            throw std::runtime_error("The two paths disagree on the checks");
+        }
+
+        std::cout << std::format(
+            "{} devices, {} compatible, median of {} passes\n",
+            deviceCount,
+            cachedSummary.compatibleCount,
+            passes);
+        std::cout << std::format("{:<32}{:>10.3f} ms\n", "queries per check", uncachedDuration);
+        std::cout << std::format(
+            "{:<32}{:>10.3f} ms\n",
+            "queryPhysicalDeviceInfos",
+            cachedDuration);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include "StateCommandStream.hpp"
+
+#include <array>
+
+namespace vki::benchmarks {
+
+namespace {
+
+struct PushConstants {
+    std::array<float, 16> transform;
+};
+
+} // namespace
+
+[[nodiscard]] StateCommandStream StateCommandStream::make(const HeadlessDevice& headlessDevice)
+{
+    const vk::Device device = *headlessDevice.device.handle;
+
+    const vk::PushConstantRange pushConstantRange {
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    vk::UniquePipelineLayout pipelineLayout = device.createPipelineLayoutUnique({
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    });
+    Buffer vertexBuffer = Buffer::make(
+        device,
+        headlessDevice.deviceInfo.memoryProperties,
+        {
+            .size = 1024,
+            .usage = vk::BufferUsageFlagBits::eVertexBuffer,
+            .memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+        });
+    vk::UniqueCommandPool commandPool = device.createCommandPoolUnique({
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = headlessDevice.queueTopology.graphics,
+    });
+    const vk::CommandBuffer commandBuffer = device.allocateCommandBuffers({
+        .commandPool = *commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    })[0];
+    return {
+        .device = device,
+        .pipelineLayout = std::move(pipelineLayout),
+        .vertexBuffer = std::move(vertexBuffer),
+        .commandPool = std::move(commandPool),
+        .commandBuffer = commandBuffer,
+    };
+}
+
+void StateCommandStream::record(uint32_t drawCount, const vk::DispatchLoaderDynamic& dispatch) const
+{
+    device.resetCommandPool(*commandPool, {}, dispatch);
+    commandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit }, dispatch);
+    PushConstants pushConstants {};
+    for (uint32_t draw = 0; draw < drawCount; draw++) {
+        const vk::Viewport viewport {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = static_cast<float>(1 + draw % 1024),
+            .height = 768.0f,
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f,
+        };
+        const vk::Rect2D scissor {
+            .offset = { .x = 0, .y = 0 },
+            .extent = { .width = 1 + draw % 1024, .height = 768 },
+        };
+        pushConstants.transform[0] = static_cast<float>(draw);
+        commandBuffer.setViewport(0, viewport, dispatch);
+        commandBuffer.setScissor(0, scissor, dispatch);
+        commandBuffer.pushConstants(
+            *pipelineLayout,
+            vk::ShaderStageFlagBits::eVertex,
+            0,
+            sizeof(PushConstants),
+            &pushConstants,
+            dispatch);
+        commandBuffer.bindVertexBuffers(0, *vertexBuffer.handle, vk::DeviceSize { 0 }, dispatch);
+    }
+    commandBuffer.end(dispatch);
+}
+
+} // namespace vki::benchmarks
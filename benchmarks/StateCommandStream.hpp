@@ -0,0 +1,28 @@
+#pragma once
+
+#include "HeadlessDevice.hpp"
+
+#include "VkIgnite/Memory.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+
+namespace vki::benchmarks {
+
+// Command buffer recording the state commands of many draws: viewport, scissor, push constants and
+// vertex buffer. No render pass nor pipeline is needed, so only the recording cost is measured.
+struct StateCommandStream {
+    [[nodiscard]] static StateCommandStream make(const HeadlessDevice& headlessDevice);
+
+    // Reset the pool and record 4 state commands per draw
+    void record(uint32_t drawCount, const vk::DispatchLoaderDynamic& dispatch) const;
+
+    vk::Device device;
+    vk::UniquePipelineLayout pipelineLayout;
+    Buffer vertexBuffer;
+    vk::UniqueCommandPool commandPool;
+    vk::CommandBuffer commandBuffer;
+};
+
+} // namespace vki::benchmarks
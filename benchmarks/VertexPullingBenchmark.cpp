@@ -0,0 +1,429 @@
+#include "HeadlessDevice.hpp"
+
+#include "VkIgnite/AsyncCompute.hpp"
+#include "VkIgnite/Memory.hpp"
+#include "VkIgnite/Shader.hpp"
+#include "VkIgnite/VertexLayout.hpp"
+
+#include "Pch/Glm.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Check that vertex pulling decodes every attribute encoding like the fixed function vertex fetch,
+// and compare the time of both paths, for the interleaved and the separate streams. Each vertex
+// shader writes its attributes to a buffer and rasterization is discarded, so no attachment is
+// needed and the check runs on software devices like lavapipe.
+// Usage: vertex-pulling-benchmark [vertex count] [passes]
+
+namespace {
+
+template<vki::VertexStreams TStreams>
+using BenchmarkVertexLayout = vki::VertexLayout<
+    TStreams,
+    vki::vertex::Snorm16Position,
+    vki::vertex::OctahedralNormal,
+    vki::vertex::Half2,
+    vki::vertex::Unorm8Color,
+    vki::vertex::Float3>;
+
+// The implementations may round the normalized formats differently than the GLSL unpack functions
+constexpr float kTolerance = 1e-5f;
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+    glm::vec4 color;
+    glm::vec3 tangent;
+};
+
+// Addresses pushed to both vertex shaders, followed by one stream per binding
+template<uint32_t TBindingCount>
+struct PushConstants {
+    vk::DeviceAddress outputs;
+    std::array<vk::DeviceAddress, TBindingCount> streams;
+};
+
+std::vector<Vertex> makeVertices(uint32_t vertexCount, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto randomDirection = [&] {
+        return glm::normalize(
+            glm::vec3(signedUnit(random), signedUnit(random), signedUnit(random))
+            + glm::vec3(0.0f, 0.0f, 1e-3f));
+    };
+    std::vector<Vertex> vertices(vertexCount);
+    for (Vertex& vertex : vertices) {
+        vertex = {
+            .position = glm::vec3(signedUnit(random), signedUnit(random), signedUnit(random))
+                * 10.0f,
+            .normal = randomDirection(),
+            .texCoord = glm::vec2(unit(random), unit(random)),
+            .color = glm::vec4(unit(random), unit(random), unit(random), unit(random)),
+            .tangent = randomDirection(),
+        };
+    }
+    return vertices;
+}
+
+// Each attribute is written as a vec4 so that both shaders share the output layout
+std::string padToVec4(std::string_view glslType, const std::string& expression)
+{
+    if (glslType == "vec2") {
+        return std::format("vec4({}, 0.0, 0.0)", expression);
+    }
+    if (glslType == "vec3") {
+        return std::format("vec4({}, 0.0)", expression);
+    }
+    return expression;
+}
+
+template<typename TLayout>
+std::string makeVertexShaderSource(bool pulling)
+{
+    const std::array<std::string_view, TLayout::attributeCount> glslTypes
+        = []<uint32_t... TLocations>(std::integer_sequence<uint32_t, TLocations...>) {
+              return std::array<std::string_view, TLayout::attributeCount> {
+                  TLayout::template AttributeAt<TLocations>::glslType...
+              };
+          }(std::make_integer_sequence<uint32_t, TLayout::attributeCount> {});
+
+    std::string source = "#version 450\n#extension GL_EXT_buffer_reference : require\n"
+        + TLayout::pullingShaderSource();
+    source += std::format(
+        "\nlayout(buffer_reference, std430, buffer_reference_align = 16) writeonly buffer Outputs "
+        "{{\n"
+        "    vec4 values[];\n"
+        "}};\n"
+        "\nlayout(push_constant) uniform Draw {{\n"
+        "    Outputs outputs;\n"
+        "    VertexWords streams[{}];\n"
+        "}} draw;\n\n",
+        TLayout::bindingCount);
+    if (!pulling) {
+        for (uint32_t location = 0; location < TLayout::attributeCount; location++) {
+            source += std::format(
+                "layout(location = {0}) in {1} attribute{0};\n",
+                location,
+                glslTypes[location]);
+        }
+    }
+    source += "\nvoid main() {\n"
+              "    uint vertexIndex = uint(gl_VertexIndex);\n";
+    for (uint32_t location = 0; location < TLayout::attributeCount; location++) {
+        const std::string value = pulling
+            ? std::format(
+                  "fetchAttribute{}(draw.streams[{}], vertexIndex)",
+                  location,
+                  TLayout::attributes[location].binding)
+            : std::format("attribute{}", location);
+        source += std::format(
+            "    draw.outputs.values[vertexIndex * {}u + {}u] = {};\n",
+            TLayout::attributeCount,
+            location,
+            padToVec4(glslTypes[location], value));
+    }
+    source += "}\n";
+    return source;
+}
+
+// Vertex only pipeline discarding the rasterization, with or without fixed function vertex input
+vk::UniquePipeline makePipeline(
+    vk::Device device,
+    vk::PipelineLayout pipelineLayout,
+    const std::string& vertexShaderSource,
+    const vk::PipelineVertexInputStateCreateInfo& vertexInputState,
+    const char* inputIdentifier)
+{
+    const vk::UniqueShaderModule vertexShader = vki::Shader::compileGlslToSpv(
+        device,
+        vertexShaderSource.c_str(),
+        vki::ShaderCompileInfo {
+            .shaderStage = GLSLANG_STAGE_VERTEX,
+            .inputIdentifier = inputIdentifier,
+        });
+    const vk::PipelineShaderStageCreateInfo vertexShaderStage {
+        .stage = vk::ShaderStageFlagBits::eVertex,
+        .module = *vertexShader,
+        .pName = "main",
+    };
+    const vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState {
+        .topology = vk::PrimitiveTopology::ePointList,
+        .primitiveRestartEnable = vk::False,
+    };
+    const vk::PipelineRasterizationStateCreateInfo rasterizerState {
+        .depthClampEnable = vk::False,
+        .rasterizerDiscardEnable = vk::True,
+        .polygonMode = vk::PolygonMode::eFill,
+        .cullMode = vk::CullModeFlagBits::eNone,
+        .frontFace = vk::FrontFace::eClockwise,
+        .depthBiasEnable = vk::False,
+        .lineWidth = 1.0f,
+    };
+    const vk::PipelineRenderingCreateInfo renderingInfo {};
+
+    const vk::GraphicsPipelineCreateInfo pipelineCreateInfo {
+        .pNext = &renderingInfo,
+        .stageCount = 1,
+        .pStages = &vertexShaderStage,
+        .pVertexInputState = &vertexInputState,
+        .pInputAssemblyState = &inputAssemblyState,
+        .pRasterizationState = &rasterizerState,
+        .layout = pipelineLayout,
+    };
+    auto pipelineCreationResult
+        = device.createGraphicsPipelinesUnique(nullptr, { pipelineCreateInfo }, nullptr);
+    if (pipelineCreationResult.result != vk::Result::eSuccess) {
+        throw std::runtime_error(std::string("Failed to create pipeline ") + inputIdentifier);
+    }
+    return std::move(pipelineCreationResult.value[0]);
+}
+
+// Draw the vertices through both paths, then compare their outputs and durations.
+// Returns whether both paths fetched the same attributes.
+template<vki::VertexStreams TStreams>
+bool compareVertexFetch(
+    const vki::benchmarks::HeadlessDevice& headlessDevice,
+    std::string_view layoutName,
+    std::span<const Vertex> vertices,
+    uint32_t passes)
+{
+    using Layout = BenchmarkVertexLayout<TStreams>;
+    const vk::Device device = *headlessDevice.device.handle;
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties
+        = headlessDevice.deviceInfo.memoryProperties;
+    const auto vertexCount = static_cast<uint32_t>(vertices.size());
+    constexpr vk::MemoryPropertyFlags hostMemory = vk::MemoryPropertyFlagBits::eHostVisible
+        | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    glm::vec3 minPosition(std::numeric_limits<float>::max());
+    glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : vertices) {
+        minPosition = glm::min(minPosition, vertex.position);
+        maxPosition = glm::max(maxPosition, vertex.position);
+    }
+    const vki::vertex::QuantizationBounds bounds
+        = vki::vertex::QuantizationBounds::fromMinMax(minPosition, maxPosition);
+
+    std::vector<vki::Buffer> vertexBuffers;
+    std::array<std::span<std::byte>, Layout::bindingCount> streams;
+    PushConstants<Layout::bindingCount> pushConstants {};
+    for (uint32_t binding = 0; binding < Layout::bindingCount; binding++) {
+        const vk::DeviceSize size = Layout::bufferSize(binding, vertexCount);
+        vertexBuffers.push_back(vki::Buffer::make(
+            device,
+            memoryProperties,
+            {
+                .size = size,
+                .usage = vk::BufferUsageFlagBits::eVertexBuffer
+                    | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                .memoryProperties = hostMemory,
+            }));
+        streams[binding] = std::span(
+            static_cast<std::byte*>(device.mapMemory(*vertexBuffers.back().memory, 0, size)),
+            size);
+        pushConstants.streams[binding] = vertexBuffers.back().getDeviceAddress(device);
+    }
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const Vertex& vertex = vertices[i];
+        using namespace vki::vertex;
+        Layout::template write<0>(streams, i, Snorm16Position::encode(vertex.position, bounds));
+        Layout::template write<1>(streams, i, OctahedralNormal::encode(vertex.normal));
+        Layout::template write<2>(streams, i, Half2::encode(vertex.texCoord));
+        Layout::template write<3>(streams, i, Unorm8Color::encode(vertex.color));
+        Layout::template write<4>(streams, i, Float3::encode(vertex.tangent));
+    }
+    for (const vki::Buffer& vertexBuffer : vertexBuffers) {
+        device.unmapMemory(*vertexBuffer.memory);
+    }
+
+    const vk::DeviceSize outputSize
+        = vk::DeviceSize { vertexCount } * Layout::attributeCount * sizeof(glm::vec4);
+    std::array<vki::Buffer, 2> outputBuffers;
+    for (vki::Buffer& outputBuffer : outputBuffers) {
+        outputBuffer = vki::Buffer::make(
+            device,
+            memoryProperties,
+            {
+                .size = outputSize,
+                .usage = vk::BufferUsageFlagBits::eStorageBuffer
+                    | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                .memoryProperties = hostMemory,
+            });
+    }
+
+    const vk::PushConstantRange pushConstantRange {
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .offset = 0,
+        .size = sizeof(pushConstants),
+    };
+    const vk::UniquePipelineLayout pipelineLayout = device.createPipelineLayoutUnique({
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    });
+    const std::array<vk::UniquePipeline, 2> pipelines {
+        makePipeline(
+            device,
+            *pipelineLayout,
+            makeVertexShaderSource<Layout>(false),
+            Layout::inputState(),
+            "fixed function vertex shader"),
+        makePipeline(
+            device,
+            *pipelineLayout,
+            makeVertexShaderSource<Layout>(true),
+            vk::PipelineVertexInputStateCreateInfo {},
+            "vertex pulling shader"),
+    };
+
+    // One command buffer per path, recorded once and submitted on each pass
+    const vk::UniqueCommandPool commandPool = device.createCommandPoolUnique({
+        .queueFamilyIndex = headlessDevice.queueTopology.graphics,
+    });
+    const std::vector<vk::CommandBuffer> commandBuffers = device.allocateCommandBuffers({
+        .commandPool = *commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 2,
+    });
+    const std::array<vk::DeviceSize, Layout::bindingCount> offsets {};
+    std::array<vk::Buffer, Layout::bindingCount> vertexBufferHandles;
+    std::ranges::transform(vertexBuffers, vertexBufferHandles.begin(), [](const auto& buffer) {
+        return *buffer.handle;
+    });
+    for (uint32_t path = 0; path < 2; path++) {
+        const vk::CommandBuffer commandBuffer = commandBuffers[path];
+        pushConstants.outputs = outputBuffers[path].getDeviceAddress(device);
+        commandBuffer.begin(vk::CommandBufferBeginInfo {});
+        commandBuffer.beginRendering({
+            .renderArea = { .extent = { .width = 1, .height = 1 } },
+            .layerCount = 1,
+        });
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelines[path]);
+        commandBuffer.pushConstants(
+            *pipelineLayout,
+            vk::ShaderStageFlagBits::eVertex,
+            0,
+            sizeof(pushConstants),
+            &pushConstants);
+        if (path == 0) {
+            commandBuffer.bindVertexBuffers(0, vertexBufferHandles, offsets);
+        }
+        commandBuffer.draw(vertexCount, 1, 0, 0);
+        commandBuffer.endRendering();
+        commandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eVertexShader,
+            vk::PipelineStageFlagBits::eHost,
+            {},
+            vk::MemoryBarrier {
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eHostRead,
+            },
+            {},
+            {});
+        commandBuffer.end();
+    }
+
+    const vk::UniqueFence fence = device.createFenceUnique({});
+    auto runPath = [&](uint32_t path) {
+        vki::submitWithTimelines(
+            headlessDevice.queues.graphics,
+            { .commandBuffers = { &commandBuffers[path], 1 } },
+            *fence);
+        if (device.waitForFences({ *fence }, vk::True, std::numeric_limits<uint64_t>::max())
+            != vk::Result::eSuccess) {
+            throw std::runtime_error("Failed to wait for the draw fence");
+        }
+        device.resetFences({ *fence });
+    };
+    const double fixedFunctionDuration = vki::benchmarks::measureMedian(passes, [&] {
+        runPath(0);
+    });
+    const double pullingDuration = vki::benchmarks::measureMedian(passes, [&] {
+        runPath(1);
+    });
+
+    const auto* fixedFunctionOutputs
+        = static_cast<const glm::vec4*>(device.mapMemory(*outputBuffers[0].memory, 0, outputSize));
+    const auto* pullingOutputs
+        = static_cast<const glm::vec4*>(device.mapMemory(*outputBuffers[1].memory, 0, outputSize));
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < vertexCount * Layout::attributeCount; i++) {
+        const glm::vec4 difference = glm::abs(fixedFunctionOutputs[i] - pullingOutputs[i]);
+        maxDifference = std::max(
+            { maxDifference, difference.x, difference.y, difference.z, difference.w });
+    }
+    device.unmapMemory(*outputBuffers[0].memory);
+    device.unmapMemory(*outputBuffers[1].memory);
+
+    std::cout << std::format(
+        "{} streams, {} bytes per vertex, max difference {:g}\n",
+        layoutName,
+        Layout::bytesPerVertex,
+        maxDifference);
+    std::cout << std::format("{:<24}{:>10.3f} ms\n", "fixed function", fixedFunctionDuration);
+    std::cout << std::format(
+        "{:<24}{:>10.3f} ms {:>6.2f}x\n",
+        "vertex pulling",
+        pullingDuration,
+        fixedFunctionDuration / pullingDuration);
+    return maxDifference <= kTolerance;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t vertexCount = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 1'000'000;
+    const uint32_t passes = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 20;
+
+    try {
+        vki::DeviceFeatureChain requiredFeatures;
+        requiredFeatures.get<vk::PhysicalDeviceFeatures2>().features.vertexPipelineStoresAndAtomics
+            = vk::True;
+        requiredFeatures.get<vk::PhysicalDeviceVulkan12Features>().bufferDeviceAddress = vk::True;
+        requiredFeatures.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering = vk::True;
+        const vki::benchmarks::HeadlessDevice headlessDevice
+            = vki::benchmarks::HeadlessDevice::make("vertex-pulling-benchmark", requiredFeatures);
+
+        std::mt19937 random(42);
+        const std::vector<Vertex> vertices = makeVertices(vertexCount, random);
+        std::cout << std::format("{} vertices, median of {} passes\n", vertexCount, passes);
+        const bool interleavedMatches = compareVertexFetch<vki::VertexStreams::Interleaved>(
+            headlessDevice,
+            "Interleaved",
+            vertices,
+            passes);
+        const bool separateMatches = compareVertexFetch<vki::VertexStreams::Separate>(
+            headlessDevice,
+            "Separate",
+            vertices,
+            passes);
+        if (!interleavedMatches || !separateMatches) {
+            std::cerr << "Vertex pulling does not decode the attributes like the fixed function "
+                         "vertex fetch\n";
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stdx {
+
+// Bump allocator handing out memory from a list of blocks, all released at once by reset().
+// Blocks are kept across resets so that a steady workload stops allocating after warm up.
+// Objects are never destroyed, only trivially destructible types can be created.
+class LinearArena {
+public:
+    explicit LinearArena(size_t blockSize = 64 * 1024)
+        : blockSize_ { blockSize }
+    {
+    }
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+    LinearArena(LinearArena&&) = default;
+    LinearArena& operator=(LinearArena&&) = default;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        while (true) {
+            if (currentBlock_ == blocks_.size()) {
+                const size_t blockSize = std::max(blockSize_, size + alignment);
+                blocks_.push_back({
+                    .data = std::make_unique_for_overwrite<std::byte[]>(blockSize),
+                    .size = blockSize,
+                });
+            }
+            Block& block = blocks_[currentBlock_];
+            const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+            const size_t alignedOffset
+                = ((base + offset_ + alignment - 1) & ~(uintptr_t { alignment } - 1)) - base;
+            if (alignedOffset + size <= block.size) {
+                offset_ = alignedOffset + size;
+                bytesAllocated_ += size;
+                return block.data.get() + alignedOffset;
+            }
+            currentBlock_++;
+            offset_ = 0;
+        }
+    }
+
+    template<typename T, typename... TArgs>
+        requires std::is_trivially_destructible_v<T>
+    [[nodiscard]] T* create(TArgs&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T { std::forward<TArgs>(args)... };
+    }
+
+    // Allocate an array of value initialized elements
+    template<typename T>
+        requires std::is_trivially_destructible_v<T>
+    [[nodiscard]] std::span<T> createArray(size_t count)
+    {
+        T* elements = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_value_construct_n(elements, count);
+        return { elements, count };
+    }
+
+    // Release every allocation at once, keeping the blocks for reuse
+    void reset()
+    {
+        currentBlock_ = 0;
+        offset_ = 0;
+        bytesAllocated_ = 0;
+    }
+
+    // Bytes requested since the last reset, alignment padding excluded
+    [[nodiscard]] size_t bytesAllocated() const
+    {
+        return bytesAllocated_;
+    }
+
+    [[nodiscard]] size_t capacity() const
+    {
+        size_t capacity = 0;
+        for (const Block& block : blocks_) {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t currentBlock_ = 0;
+    size_t offset_ = 0;
+    size_t bytesAllocated_ = 0;
+};
+
+// std::pmr::memory_resource allocating from a LinearArena, so that standard containers can use
+// the arena. Deallocation is a no-op, memory is only reclaimed when the arena is reset.
+class LinearArenaResource : public std::pmr::memory_resource {
+public:
+    explicit LinearArenaResource(LinearArena& arena)
+        : arena_ { &arena }
+    {
+    }
+
+private:
+    void* do_allocate(size_t size, size_t alignment) override
+    {
+        return arena_->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* /*pointer*/, size_t /*size*/, size_t /*alignment*/) override
+    {
+    }
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const auto* otherArenaResource = dynamic_cast<const LinearArenaResource*>(&other);
+        return otherArenaResource != nullptr && otherArenaResource->arena_ == arena_;
+    }
+
+    LinearArena* arena_;
+};
+
+} // namespace stdx
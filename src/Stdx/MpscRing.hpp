@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace stdx {
+
+// Bounded lock-free queue for multiple producers and a single consumer. Each cell carries a
+// sequence number telling whether it is free for the producer of a given position or ready for the
+// consumer, so that producers only contend on the enqueue position. A full ring rejects the
+// element instead of blocking.
+template<typename T>
+class MpscRing {
+public:
+    // The capacity is rounded up to a power of two
+    explicit MpscRing(size_t capacity)
+        : cells_ { std::make_unique<Cell[]>(std::bit_ceil(std::max<size_t>(capacity, 2))) }
+        , mask_ { std::bit_ceil(std::max<size_t>(capacity, 2)) - 1 }
+    {
+        for (size_t index = 0; index <= mask_; index++) {
+            cells_[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Thread safe, return false if the ring is full
+    [[nodiscard]] bool tryPush(const T& value)
+    {
+        size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[position & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference
+                = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition_.compare_exchange_weak(
+                        position,
+                        position + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only, return false if the ring is empty
+    [[nodiscard]] bool tryPop(T& value)
+    {
+        Cell& cell = cells_[dequeuePosition_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(dequeuePosition_ + mask_ + 1, std::memory_order_release);
+        dequeuePosition_++;
+        return true;
+    }
+
+    [[nodiscard]] size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Keep the positions on separate cache lines so that producers do not slow down the consumer
+    static constexpr size_t kCacheLineSize = 64;
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueuePosition_ = 0;
+    alignas(kCacheLineSize) size_t dequeuePosition_ = 0;
+};
+
+} // namespace stdx
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <vector>
+
+namespace stdx {
+
+// Split [0, count) into contiguous ranges of at least minRangeSize elements and call
+// function(begin, end) on each of them, using the pool workers and the calling thread.
+// Returns once every range has been processed. Exceptions thrown by function are rethrown.
+template<typename TFunction>
+void parallel_for(ThreadPool& pool, size_t count, size_t minRangeSize, TFunction&& function)
+{
+    if (count == 0) {
+        return;
+    }
+    minRangeSize = std::max<size_t>(minRangeSize, 1);
+    const size_t maxRangeCount = (count + minRangeSize - 1) / minRangeSize;
+    const size_t rangeCount = std::clamp<size_t>(pool.threadCount() + 1, 1, maxRangeCount);
+    const size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+    std::vector<std::future<void>> pendingRanges;
+    pendingRanges.reserve(rangeCount - 1);
+    for (size_t begin = rangeSize; begin < count; begin += rangeSize) {
+        const size_t end = std::min(begin + rangeSize, count);
+        pendingRanges.push_back(pool.submit([&function, begin, end] { function(begin, end); }));
+    }
+    // The first range runs on the calling thread rather than waiting idle. Every range must be
+    // done before returning, even on error, as they reference function.
+    std::exception_ptr error;
+    try {
+        function(size_t { 0 }, std::min(rangeSize, count));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (std::future<void>& pendingRange : pendingRanges) {
+        try {
+            pendingRange.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace stdx
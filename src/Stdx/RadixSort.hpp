@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace stdx {
+
+// Stable LSD radix sort of values by the 64-bit unsigned key returned by keyOf, one byte per pass.
+// Passes where every key has the same digit are skipped, so keys using only their low bits are
+// sorted in fewer passes. scratch must be at least as large as values, the result is in values.
+template<typename TValue, typename TKeyFunction>
+void radix_sort(std::span<TValue> values, std::span<TValue> scratch, TKeyFunction keyOf)
+{
+    constexpr size_t kDigitBits = 8;
+    constexpr size_t kDigitCount = sizeof(uint64_t) * 8 / kDigitBits;
+    constexpr size_t kBucketCount = size_t { 1 } << kDigitBits;
+
+    if (scratch.size() < values.size()) {
+        throw std::invalid_argument("radix_sort scratch buffer is too small");
+    }
+    if (values.size() < 2) {
+        return;
+    }
+
+    // Histograms of every digit computed in a single pass over the keys
+    std::array<std::array<size_t, kBucketCount>, kDigitCount> histograms {};
+    for (const TValue& value : values) {
+        const uint64_t key = keyOf(value);
+        for (size_t digit = 0; digit < kDigitCount; digit++) {
+            histograms[digit][(key >> (digit * kDigitBits)) & (kBucketCount - 1)]++;
+        }
+    }
+
+    std::span<TValue> source = values;
+    std::span<TValue> destination = scratch.first(values.size());
+    for (size_t digit = 0; digit < kDigitCount; digit++) {
+        std::array<size_t, kBucketCount>& histogram = histograms[digit];
+        if (std::ranges::find(histogram, values.size()) != histogram.end()) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t& bucket : histogram) {
+            offset += std::exchange(bucket, offset);
+        }
+        for (TValue& value : source) {
+            const size_t bucket = (keyOf(value) >> (digit * kDigitBits)) & (kBucketCount - 1);
+            destination[histogram[bucket]++] = std::move(value);
+        }
+        std::swap(source, destination);
+    }
+    if (source.data() != values.data()) {
+        std::ranges::move(source, values.begin());
+    }
+}
+
+} // namespace stdx
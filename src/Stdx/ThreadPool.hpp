@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stdx {
+
+// Fixed-size pool of worker threads consuming a FIFO of tasks.
+// Pending tasks are still executed when the pool is destroyed.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = defaultThreadCount())
+    {
+        workers_.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            workers_.emplace_back([this](std::stop_token stopToken) { workerLoop(stopToken); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        for (std::jthread& worker : workers_) {
+            worker.request_stop();
+        }
+        tasksAvailable_.notify_all();
+    }
+
+    [[nodiscard]] static size_t defaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    [[nodiscard]] size_t threadCount() const
+    {
+        return workers_.size();
+    }
+
+    // Queue a callable for execution on a worker, returning a future to its result
+    template<typename TFunction>
+    [[nodiscard]] std::future<std::invoke_result_t<TFunction>> submit(TFunction&& function)
+    {
+        using Result = std::invoke_result_t<TFunction>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<TFunction>(function));
+        std::future<Result> result = task->get_future();
+        {
+            std::scoped_lock lock(mutex_);
+            tasks_.emplace_back([task] { (*task)(); });
+        }
+        tasksAvailable_.notify_one();
+        return result;
+    }
+
+private:
+    void workerLoop(std::stop_token stopToken)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                tasksAvailable_.wait(lock, stopToken, [this] { return !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    // Stop requested and nothing left to do
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable_any tasksAvailable_;
+    std::deque<std::function<void()>> tasks_;
+    // Declared last so workers are joined before the queue and its mutex are destroyed
+    std::vector<std::jthread> workers_;
+};
+
+} // namespace stdx
@@ -0,0 +1,227 @@
+#include "AsyncCompute.hpp"
+
+#include "Stdx/Algorithm.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace vki {
+
+[[nodiscard]] TimelineSemaphore TimelineSemaphore::make(vk::Device device, uint64_t initialValue)
+{
+    vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo {
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = initialValue,
+    };
+    return {
+        .handle = device.createSemaphoreUnique({ .pNext = &semaphoreTypeCreateInfo }),
+    };
+}
+
+void TimelineSemaphore::wait(uint64_t value) const
+{
+    vk::Semaphore semaphore = *handle;
+    vk::Result waitResult = handle.getOwner().waitSemaphores(
+        {
+            .semaphoreCount = 1,
+            .pSemaphores = &semaphore,
+            .pValues = &value,
+        },
+        std::numeric_limits<uint64_t>::max());
+    if (waitResult != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to wait for the timeline semaphore");
+    }
+}
+
+[[nodiscard]] uint64_t TimelineSemaphore::getValue() const
+{
+    return handle.getOwner().getSemaphoreCounterValue(*handle);
+}
+
+void submitWithTimelines(
+    vk::Queue queue,
+    const TimelineSubmitInfo& timelineSubmitInfo,
+    vk::Fence fence)
+{
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<uint64_t> waitValues;
+    std::vector<vk::PipelineStageFlags> waitStageMasks;
+    for (const TimelineWait& wait : timelineSubmitInfo.waits) {
+        waitSemaphores.push_back(wait.semaphore);
+        waitValues.push_back(wait.value);
+        waitStageMasks.push_back(wait.stageMask);
+    }
+    std::vector<vk::Semaphore> signalSemaphores;
+    std::vector<uint64_t> signalValues;
+    for (const TimelineSignal& signal : timelineSubmitInfo.signals) {
+        signalSemaphores.push_back(signal.semaphore);
+        signalValues.push_back(signal.value);
+    }
+
+    vk::TimelineSemaphoreSubmitInfo semaphoreValues {
+        .waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+        .pWaitSemaphoreValues = waitValues.data(),
+        .signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size()),
+        .pSignalSemaphoreValues = signalValues.data(),
+    };
+    queue.submit(
+        { vk::SubmitInfo {
+            .pNext = &semaphoreValues,
+            .waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+            .pWaitSemaphores = waitSemaphores.data(),
+            .pWaitDstStageMask = waitStageMasks.data(),
+            .commandBufferCount = static_cast<uint32_t>(timelineSubmitInfo.commandBuffers.size()),
+            .pCommandBuffers = timelineSubmitInfo.commandBuffers.data(),
+            .signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()),
+            .pSignalSemaphores = signalSemaphores.data(),
+        } },
+        fence);
+}
+
+static void recordOwnershipBarriers(
+    vk::CommandBuffer commandBuffer,
+    std::span<const BufferOwnershipTransfer> transfers,
+    bool release)
+{
+    std::vector<vk::BufferMemoryBarrier> barriers;
+    vk::PipelineStageFlags srcStageMask;
+    vk::PipelineStageFlags dstStageMask;
+    for (const BufferOwnershipTransfer& transfer : transfers) {
+        if (transfer.srcQueueFamilyIndex == transfer.dstQueueFamilyIndex) {
+            continue;
+        }
+        // The access mask of the other half is ignored, as is its stage which is replaced by the
+        // semaphore ordering both submissions
+        barriers.push_back({
+            .srcAccessMask = release ? transfer.srcAccessMask : vk::AccessFlags {},
+            .dstAccessMask = release ? vk::AccessFlags {} : transfer.dstAccessMask,
+            .srcQueueFamilyIndex = transfer.srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = transfer.dstQueueFamilyIndex,
+            .buffer = transfer.buffer,
+            .offset = 0,
+            .size = vk::WholeSize,
+        });
+        if (release) {
+            srcStageMask |= transfer.srcStageMask;
+        } else {
+            dstStageMask |= transfer.dstStageMask;
+        }
+    }
+    if (barriers.empty()) {
+        return;
+    }
+    commandBuffer.pipelineBarrier(
+        release ? srcStageMask : vk::PipelineStageFlagBits::eTopOfPipe,
+        release ? vk::PipelineStageFlagBits::eBottomOfPipe : dstStageMask,
+        {},
+        {},
+        barriers,
+        {});
+}
+
+void recordOwnershipRelease(
+    vk::CommandBuffer commandBuffer,
+    std::span<const BufferOwnershipTransfer> transfers)
+{
+    recordOwnershipBarriers(commandBuffer, transfers, true);
+}
+
+void recordOwnershipAcquire(
+    vk::CommandBuffer commandBuffer,
+    std::span<const BufferOwnershipTransfer> transfers)
+{
+    recordOwnershipBarriers(commandBuffer, transfers, false);
+}
+
+AsyncCompute::AsyncCompute(const AsyncComputeCreateInfo& asyncComputeCreateInfo)
+    : device_ { asyncComputeCreateInfo.device }
+    , graphicsQueueFamilyIndex_ { asyncComputeCreateInfo.queueTopology.graphics }
+    , queueFamilyIndex_ { asyncComputeCreateInfo.queueTopology.asyncCompute.value_or(
+          graphicsQueueFamilyIndex_) }
+    , sharingQueueFamilies_ { graphicsQueueFamilyIndex_, queueFamilyIndex_ }
+    , queue_ { device_.getQueue(queueFamilyIndex_, 0) }
+    , timeline_ { TimelineSemaphore::make(device_) }
+{
+    stdx::ranges::sort_unique(sharingQueueFamilies_);
+
+    for (uint32_t frameIndex = 0; frameIndex < asyncComputeCreateInfo.framesInFlight;
+         frameIndex++) {
+        FrameResources frame {
+            .commandPool = device_.createCommandPoolUnique({
+                .flags = vk::CommandPoolCreateFlagBits::eTransient,
+                .queueFamilyIndex = queueFamilyIndex_,
+            }),
+        };
+        std::vector<vk::CommandBuffer> commandBuffers = device_.allocateCommandBuffers({
+            .commandPool = *frame.commandPool,
+            .level = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1,
+        });
+        frame.commandBuffer = commandBuffers.front();
+        frames_.push_back(std::move(frame));
+    }
+}
+
+[[nodiscard]] vk::CommandBuffer AsyncCompute::begin(uint32_t frameIndex)
+{
+    FrameResources& frame = frames_[frameIndex];
+    timeline_.wait(frame.submittedValue);
+    device_.resetCommandPool(*frame.commandPool);
+    frame.commandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    return frame.commandBuffer;
+}
+
+uint64_t AsyncCompute::submit(uint32_t frameIndex, std::span<const TimelineWait> waits)
+{
+    FrameResources& frame = frames_[frameIndex];
+    frame.commandBuffer.end();
+
+    const uint64_t signalValue = ++lastSubmittedValue_;
+    const TimelineSignal signal {
+        .semaphore = *timeline_.handle,
+        .value = signalValue,
+    };
+    submitWithTimelines(
+        queue_,
+        {
+            .waits = waits,
+            .commandBuffers = { &frame.commandBuffer, 1 },
+            .signals = { &signal, 1 },
+        });
+
+    frame.submittedValue = signalValue;
+    return signalValue;
+}
+
+[[nodiscard]] TimelineWait AsyncCompute::makeWait(
+    uint64_t value,
+    vk::PipelineStageFlags stageMask) const
+{
+    return {
+        .semaphore = *timeline_.handle,
+        .value = value,
+        .stageMask = stageMask,
+    };
+}
+
+[[nodiscard]] bool AsyncCompute::isDedicated() const
+{
+    return queueFamilyIndex_ != graphicsQueueFamilyIndex_;
+}
+
+[[nodiscard]] QueueFamilyIndex AsyncCompute::getQueueFamilyIndex() const
+{
+    return queueFamilyIndex_;
+}
+
+[[nodiscard]] std::span<const QueueFamilyIndex> AsyncCompute::getSharingQueueFamilies() const
+{
+    return sharingQueueFamilies_;
+}
+
+[[nodiscard]] const TimelineSemaphore& AsyncCompute::getTimeline() const
+{
+    return timeline_;
+}
+
+} // namespace vki
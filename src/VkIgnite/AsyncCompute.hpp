@@ -0,0 +1,139 @@
+#pragma once
+
+#include "QueueTopology.hpp"
+#include "Types.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vki {
+
+// Semaphore whose payload is a monotonically increasing counter. A single one can order any
+// number of submissions across queues, and the host can wait on or query its value directly.
+class TimelineSemaphore {
+public:
+    [[nodiscard]] static TimelineSemaphore make(vk::Device device, uint64_t initialValue = 0);
+
+    // Block until the counter reaches value
+    void wait(uint64_t value) const;
+
+    [[nodiscard]] uint64_t getValue() const;
+
+    vk::UniqueSemaphore handle;
+};
+
+// Wait of a submission on a timeline semaphore value. Binary semaphores, such as the swapchain
+// ones, can be waited with the same structure, their value being ignored.
+struct TimelineWait {
+    vk::Semaphore semaphore;
+    uint64_t value = 0;
+    vk::PipelineStageFlags stageMask;
+};
+
+// Signal of a timeline semaphore value, or of a binary semaphore whose value is ignored
+struct TimelineSignal {
+    vk::Semaphore semaphore;
+    uint64_t value = 0;
+};
+
+struct TimelineSubmitInfo {
+    std::span<const TimelineWait> waits = {};
+    std::span<const vk::CommandBuffer> commandBuffers = {};
+    std::span<const TimelineSignal> signals = {};
+};
+
+// Submit to a queue mixing timeline and binary semaphores, building the
+// vk::TimelineSemaphoreSubmitInfo holding their values. Typically the graphics submission of a
+// frame, waiting for the swapchain image and for the AsyncCompute work it consumes.
+void submitWithTimelines(
+    vk::Queue queue,
+    const TimelineSubmitInfo& timelineSubmitInfo,
+    vk::Fence fence = {});
+
+// Buffer written by one queue family and read by another
+struct BufferOwnershipTransfer {
+    vk::Buffer buffer;
+    QueueFamilyIndex srcQueueFamilyIndex = 0;
+    QueueFamilyIndex dstQueueFamilyIndex = 0;
+    vk::PipelineStageFlags srcStageMask;
+    vk::AccessFlags srcAccessMask;
+    vk::PipelineStageFlags dstStageMask;
+    vk::AccessFlags dstAccessMask;
+};
+
+// Record the release half of the ownership transfers, on a command buffer of the source family.
+// Transfers between identical families need no barrier and are skipped.
+void recordOwnershipRelease(
+    vk::CommandBuffer commandBuffer,
+    std::span<const BufferOwnershipTransfer> transfers);
+
+// Record the acquire half of the ownership transfers, on a command buffer of the destination
+// family submitted after the release one
+void recordOwnershipAcquire(
+    vk::CommandBuffer commandBuffer,
+    std::span<const BufferOwnershipTransfer> transfers);
+
+struct AsyncComputeCreateInfo {
+    vk::Device device;
+    QueueTopology queueTopology;
+    uint32_t framesInFlight;
+};
+
+// Submission path for compute work overlapping the graphics queue.
+//
+// Work is recorded into per-frame command pools of the async compute family, or of the graphics
+// family when the device has no dedicated one, and each submission signals the next value of a
+// timeline semaphore. The graphics submission consuming the results waits on that value, while
+// the rest of the frame runs concurrently.
+//
+// Buffers shared with the graphics queue should either be created with getSharingQueueFamilies()
+// for concurrent sharing, or go through recordOwnershipRelease() and recordOwnershipAcquire().
+//
+// Requires the timelineSemaphore feature (Vulkan 1.2) to be enabled.
+class AsyncCompute {
+public:
+    explicit AsyncCompute(const AsyncComputeCreateInfo& asyncComputeCreateInfo);
+
+    // Begin recording the compute work of a frame. Waits until the previous submission of the
+    // frame slot has completed, so that its command pool can be recycled.
+    [[nodiscard]] vk::CommandBuffer begin(uint32_t frameIndex);
+
+    // Submit the commands recorded since begin() and return the timeline value signaled once
+    // they complete
+    uint64_t submit(uint32_t frameIndex, std::span<const TimelineWait> waits = {});
+
+    // Wait to add to a submission consuming the results of the given submit() value
+    [[nodiscard]] TimelineWait makeWait(uint64_t value, vk::PipelineStageFlags stageMask) const;
+
+    // Whether compute work runs on a family distinct from the graphics one
+    [[nodiscard]] bool isDedicated() const;
+
+    [[nodiscard]] QueueFamilyIndex getQueueFamilyIndex() const;
+
+    // Distinct families of the graphics and compute queues, for buffers shared between them
+    [[nodiscard]] std::span<const QueueFamilyIndex> getSharingQueueFamilies() const;
+
+    [[nodiscard]] const TimelineSemaphore& getTimeline() const;
+
+private:
+    struct FrameResources {
+        vk::UniqueCommandPool commandPool;
+        vk::CommandBuffer commandBuffer;
+        // Timeline value signaled by the last submission of the frame slot
+        uint64_t submittedValue = 0;
+    };
+
+    vk::Device device_;
+    QueueFamilyIndex graphicsQueueFamilyIndex_;
+    QueueFamilyIndex queueFamilyIndex_;
+    std::vector<QueueFamilyIndex> sharingQueueFamilies_;
+    vk::Queue queue_;
+    TimelineSemaphore timeline_;
+    uint64_t lastSubmittedValue_ = 0;
+    std::vector<FrameResources> frames_;
+};
+
+} // namespace vki
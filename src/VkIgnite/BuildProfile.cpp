@@ -0,0 +1,102 @@
+#include "BuildProfile.hpp"
+#include "DefaultBuildProfile.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace vki {
+
+[[nodiscard]] std::string_view getBuildProfileName(BuildProfile profile)
+{
+    switch (profile) {
+    case BuildProfile::Dev:
+        return "dev";
+    case BuildProfile::Profile:
+        return "profile";
+    case BuildProfile::Production:
+        return "production";
+    }
+    return "unknown";
+}
+
+[[nodiscard]] std::optional<BuildProfile> parseBuildProfile(std::string_view name)
+{
+    for (BuildProfile profile :
+         { BuildProfile::Dev, BuildProfile::Profile, BuildProfile::Production }) {
+        if (name == getBuildProfileName(profile)) {
+            return profile;
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] BuildProfile getActiveBuildProfile()
+{
+    const char* profileName = std::getenv("VKIGNITE_PROFILE");
+    if (profileName != nullptr) {
+        std::optional<BuildProfile> profile = parseBuildProfile(profileName);
+        if (profile.has_value()) {
+            return *profile;
+        }
+        spdlog::warn("Unknown VKIGNITE_PROFILE {}, using the default profile", profileName);
+    }
+
+    std::optional<BuildProfile> defaultProfile = parseBuildProfile(DEFAULT_BUILD_PROFILE_NAME);
+    if (!defaultProfile.has_value()) {
+        throw std::runtime_error(
+            "Unknown default build profile " + std::string(DEFAULT_BUILD_PROFILE_NAME));
+    }
+    return *defaultProfile;
+}
+
+void applyBuildProfile(InstanceCreateInfo& instanceCreateInfo, BuildProfile profile)
+{
+    using enum vk::DebugUtilsMessageSeverityFlagBitsEXT;
+    using enum vk::DebugUtilsMessageTypeFlagBitsEXT;
+
+    switch (profile) {
+    case BuildProfile::Dev:
+        instanceCreateInfo.validationLayerKHROption = Option::Enabled;
+        instanceCreateInfo.debugUtilsMessengerEXTOption = Option::Enabled;
+        instanceCreateInfo.debugMessageSeverity = eVerbose | eInfo | eWarning | eError;
+        instanceCreateInfo.debugMessageType = eGeneral | eValidation | ePerformance;
+        break;
+    case BuildProfile::Profile:
+        // The layer still intercepts every call, but without the costly state tracking of the
+        // core checks. The messenger is only woken up by warnings and errors, best practices
+        // reporting its findings as either performance or validation messages.
+        instanceCreateInfo.validationLayerKHROption = Option::Enabled;
+        instanceCreateInfo.debugUtilsMessengerEXTOption = Option::Enabled;
+        instanceCreateInfo.enabledValidationFeatures = {
+            vk::ValidationFeatureEnableEXT::eBestPractices,
+        };
+        instanceCreateInfo.disabledValidationFeatures = {
+            vk::ValidationFeatureDisableEXT::eCoreChecks,
+            vk::ValidationFeatureDisableEXT::eThreadSafety,
+            vk::ValidationFeatureDisableEXT::eObjectLifetimes,
+            vk::ValidationFeatureDisableEXT::eApiParameters,
+            vk::ValidationFeatureDisableEXT::eUniqueHandles,
+        };
+        instanceCreateInfo.debugMessageSeverity = eWarning | eError;
+        instanceCreateInfo.debugMessageType = ePerformance | eValidation;
+        // Buffers and images each get a dedicated allocation, which best practices reports on
+        // every resource creation. The ids are the MessageID values printed with the messages.
+        instanceCreateInfo.debugMessageSinkCreateInfo.mutedMessageIds = {
+            // UNASSIGNED-BestPractices-vkAllocateMemory-small-allocation
+            static_cast<int32_t>(0xfd92477a),
+            // UNASSIGNED-BestPractices-vkBindMemory-small-dedicated-allocation
+            static_cast<int32_t>(0xb3d4c0cb),
+        };
+        break;
+    case BuildProfile::Production:
+        instanceCreateInfo.validationLayerKHROption = Option::Disabled;
+        instanceCreateInfo.debugUtilsMessengerEXTOption = Option::Disabled;
+        break;
+    }
+}
+
+} // namespace vki
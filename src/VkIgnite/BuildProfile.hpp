@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Instance.hpp"
+
+#include <optional>
+#include <string_view>
+
+namespace vki {
+
+enum class BuildProfile {
+    // Full validation, every debug message is logged
+    Dev,
+    // Validation restricted to the best practices layer checks, only performance warnings and
+    // errors are logged
+    Profile,
+    // No validation layer and no debug messenger
+    Production,
+};
+
+[[nodiscard]] std::string_view getBuildProfileName(BuildProfile profile);
+
+[[nodiscard]] std::optional<BuildProfile> parseBuildProfile(std::string_view name);
+
+// Profile selected by the VKIGNITE_PROFILE environment variable, else by the VKIGNITE_PROFILE
+// CMake option
+[[nodiscard]] BuildProfile getActiveBuildProfile();
+
+// Set the validation and debug messenger options of the instance according to the profile
+void applyBuildProfile(InstanceCreateInfo& instanceCreateInfo, BuildProfile profile);
+
+} // namespace vki
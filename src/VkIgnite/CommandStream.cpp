@@ -0,0 +1,171 @@
+#include "CommandStream.hpp"
+
+#include "Stdx/RadixSort.hpp"
+
+namespace vki {
+
+void RenderStateTracker::reset()
+{
+    *this = {};
+}
+
+void RenderStateTracker::apply(vk::CommandBuffer commandBuffer, const DrawPacket& packet)
+{
+    if (packet.pipeline && packet.pipeline != pipeline_) {
+        if (commandBuffer) {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, packet.pipeline);
+        }
+        pipeline_ = packet.pipeline;
+        stats_.pipelineBinds++;
+    } else if (packet.pipeline) {
+        stats_.elidedCalls++;
+    }
+
+    // Binding with a different pipeline layout may disturb previously bound sets, so the layout is
+    // part of the descriptor set state
+    if (packet.descriptorSet
+        && (packet.descriptorSet != descriptorSet_
+            || packet.descriptorSetIndex != descriptorSetIndex_
+            || packet.pipelineLayout != pipelineLayout_)) {
+        if (commandBuffer) {
+            commandBuffer.bindDescriptorSets(
+                vk::PipelineBindPoint::eGraphics,
+                packet.pipelineLayout,
+                packet.descriptorSetIndex,
+                { packet.descriptorSet },
+                {});
+        }
+        descriptorSet_ = packet.descriptorSet;
+        descriptorSetIndex_ = packet.descriptorSetIndex;
+        pipelineLayout_ = packet.pipelineLayout;
+        stats_.descriptorSetBinds++;
+    } else if (packet.descriptorSet) {
+        stats_.elidedCalls++;
+    }
+
+    if (packet.viewport != viewport_) {
+        if (commandBuffer) {
+            commandBuffer.setViewport(0, { packet.viewport });
+        }
+        viewport_ = packet.viewport;
+        stats_.viewportSets++;
+    } else {
+        stats_.elidedCalls++;
+    }
+
+    if (packet.scissor != scissor_) {
+        if (commandBuffer) {
+            commandBuffer.setScissor(0, { packet.scissor });
+        }
+        scissor_ = packet.scissor;
+        stats_.scissorSets++;
+    } else {
+        stats_.elidedCalls++;
+    }
+
+    if (packet.vertexBuffer
+        && (packet.vertexBuffer != vertexBuffer_
+            || packet.vertexBufferOffset != vertexBufferOffset_)) {
+        if (commandBuffer) {
+            commandBuffer.bindVertexBuffers(
+                0,
+                { packet.vertexBuffer },
+                { packet.vertexBufferOffset });
+        }
+        vertexBuffer_ = packet.vertexBuffer;
+        vertexBufferOffset_ = packet.vertexBufferOffset;
+        stats_.vertexBufferBinds++;
+    } else if (packet.vertexBuffer) {
+        stats_.elidedCalls++;
+    }
+
+    if (packet.indexBuffer
+        && (packet.indexBuffer != indexBuffer_ || packet.indexBufferOffset != indexBufferOffset_
+            || packet.indexType != indexType_)) {
+        if (commandBuffer) {
+            commandBuffer.bindIndexBuffer(
+                packet.indexBuffer,
+                packet.indexBufferOffset,
+                packet.indexType);
+        }
+        indexBuffer_ = packet.indexBuffer;
+        indexBufferOffset_ = packet.indexBufferOffset;
+        indexType_ = packet.indexType;
+        stats_.indexBufferBinds++;
+    } else if (packet.indexBuffer) {
+        stats_.elidedCalls++;
+    }
+
+    // Push constants are kept across pipelines with the same layout
+    if (packet.vertexDataAddress != 0
+        && (packet.vertexDataAddress != vertexDataAddress_
+            || packet.pipelineLayout != vertexDataLayout_)) {
+        if (commandBuffer) {
+            commandBuffer.pushConstants(
+                packet.pipelineLayout,
+                vk::ShaderStageFlagBits::eVertex,
+                0,
+                sizeof(vk::DeviceAddress),
+                &packet.vertexDataAddress);
+        }
+        vertexDataAddress_ = packet.vertexDataAddress;
+        vertexDataLayout_ = packet.pipelineLayout;
+        stats_.vertexDataPushes++;
+    } else if (packet.vertexDataAddress != 0) {
+        stats_.elidedCalls++;
+    }
+
+    if (commandBuffer) {
+        if (packet.indexBuffer) {
+            commandBuffer.drawIndexed(
+                packet.elementCount,
+                packet.instanceCount,
+                packet.firstElement,
+                packet.vertexOffset,
+                packet.firstInstance);
+        } else {
+            commandBuffer.draw(
+                packet.elementCount,
+                packet.instanceCount,
+                packet.firstElement,
+                packet.firstInstance);
+        }
+    }
+    stats_.draws++;
+}
+
+void CommandStream::push(uint64_t sortKey, const DrawPacket& packet)
+{
+    entries_.push_back({
+        .sortKey = sortKey,
+        .packet = arena_->create<DrawPacket>(packet),
+    });
+}
+
+void CommandStream::append(const CommandStream& other)
+{
+    entries_.insert(entries_.end(), other.entries_.begin(), other.entries_.end());
+}
+
+void CommandStream::sort()
+{
+    sortScratch_.resize(entries_.size());
+    stdx::radix_sort(
+        std::span(entries_),
+        std::span(sortScratch_),
+        [](const Entry& entry) { return entry.sortKey; });
+}
+
+void CommandStream::replay(vk::CommandBuffer commandBuffer, RenderStateTracker& stateTracker) const
+{
+    for (const Entry& entry : entries_) {
+        stateTracker.apply(commandBuffer, *entry.packet);
+    }
+}
+
+void CommandStream::clear()
+{
+    entries_.clear();
+}
+
+} // namespace vki
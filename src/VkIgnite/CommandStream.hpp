@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Stdx/LinearArena.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace vki {
+
+// Complete state of a draw call, as plain data. A null handle leaves the corresponding state
+// untouched, e.g. for draws without index buffer or descriptor set.
+struct DrawPacket {
+    vk::Pipeline pipeline;
+    vk::PipelineLayout pipelineLayout;
+    vk::DescriptorSet descriptorSet;
+    uint32_t descriptorSetIndex = 0;
+    vk::Viewport viewport;
+    vk::Rect2D scissor;
+    vk::Buffer vertexBuffer;
+    vk::DeviceSize vertexBufferOffset = 0;
+    vk::Buffer indexBuffer;
+    vk::DeviceSize indexBufferOffset = 0;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    // Address of the vertices for vertex pulling pipelines, pushed at offset 0 of the vertex stage
+    // push constants. 0 for pipelines using vertex buffers.
+    vk::DeviceAddress vertexDataAddress = 0;
+    // Index count for indexed draws, vertex count otherwise
+    uint32_t elementCount = 0;
+    uint32_t instanceCount = 1;
+    // First index for indexed draws, first vertex otherwise
+    uint32_t firstElement = 0;
+    int32_t vertexOffset = 0;
+    uint32_t firstInstance = 0;
+};
+static_assert(std::is_trivially_copyable_v<DrawPacket>);
+static_assert(std::is_trivially_destructible_v<DrawPacket>);
+
+// Vulkan calls issued and elided by a RenderStateTracker since its last reset
+struct RenderStateStats {
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t viewportSets = 0;
+    uint32_t scissorSets = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint32_t vertexDataPushes = 0;
+    // State changes skipped because they matched the current state
+    uint32_t elidedCalls = 0;
+};
+
+// Translate draw packets into Vulkan calls, skipping the ones matching the current state of the
+// command buffer. Must be reset whenever the command buffer state is lost, at least once per
+// command buffer.
+class RenderStateTracker {
+public:
+    void reset();
+
+    // Record the state changes and the draw of the packet. A null command buffer only updates the
+    // tracked state and the statistics, to evaluate command streams without a device.
+    void apply(vk::CommandBuffer commandBuffer, const DrawPacket& packet);
+
+    [[nodiscard]] const RenderStateStats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    vk::Pipeline pipeline_;
+    vk::PipelineLayout pipelineLayout_;
+    vk::DescriptorSet descriptorSet_;
+    uint32_t descriptorSetIndex_ = 0;
+    std::optional<vk::Viewport> viewport_;
+    std::optional<vk::Rect2D> scissor_;
+    vk::Buffer vertexBuffer_;
+    vk::DeviceSize vertexBufferOffset_ = 0;
+    vk::Buffer indexBuffer_;
+    vk::DeviceSize indexBufferOffset_ = 0;
+    vk::IndexType indexType_ = vk::IndexType::eUint32;
+    vk::DeviceAddress vertexDataAddress_ = 0;
+    vk::PipelineLayout vertexDataLayout_;
+    RenderStateStats stats_;
+};
+
+// List of draw packets ordered by a user defined 64-bit sort key.
+//
+// Packets are written in a frame linear arena, so building a stream does not touch Vulkan and
+// several streams can be built in parallel, each with its own arena, then appended together.
+// The arena must outlive the stream contents, typically by being reset with it once per frame.
+class CommandStream {
+public:
+    struct Entry {
+        uint64_t sortKey;
+        const DrawPacket* packet;
+    };
+
+    explicit CommandStream(stdx::LinearArena& arena)
+        : arena_ { &arena }
+    {
+    }
+
+    void push(uint64_t sortKey, const DrawPacket& packet);
+
+    // Append the entries of another stream, whose arena must stay alive as long as this stream
+    void append(const CommandStream& other);
+
+    // Stable sort of the entries by key, so packets with equal keys keep their submission order
+    void sort();
+
+    // Apply every packet in order through the state tracker
+    void replay(vk::CommandBuffer commandBuffer, RenderStateTracker& stateTracker) const;
+
+    // Remove every entry. The arena is not reset, as it may be shared with other streams.
+    void clear();
+
+    [[nodiscard]] std::span<const Entry> entries() const
+    {
+        return entries_;
+    }
+
+private:
+    stdx::LinearArena* arena_;
+    std::vector<Entry> entries_;
+    std::vector<Entry> sortScratch_;
+};
+
+} // namespace vki
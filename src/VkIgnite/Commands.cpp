@@ -0,0 +1,78 @@
+#include "Commands.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vki {
+
+void submitImmediate(
+    vk::Device device,
+    vk::Queue queue,
+    QueueFamilyIndex queueFamilyIndex,
+    const std::function<void(vk::CommandBuffer)>& record)
+{
+    vk::UniqueCommandPool commandPool = device.createCommandPoolUnique({
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = queueFamilyIndex,
+    });
+
+    std::vector<vk::UniqueCommandBuffer> commandBuffers = device.allocateCommandBuffersUnique({
+        .commandPool = *commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    });
+    vk::CommandBuffer commandBuffer = *commandBuffers.front();
+
+    commandBuffer.begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    record(commandBuffer);
+    commandBuffer.end();
+
+    vk::UniqueFence fence = device.createFenceUnique({});
+    queue.submit(
+        { vk::SubmitInfo {
+            .commandBufferCount = 1,
+            .pCommandBuffers = &commandBuffer,
+        } },
+        *fence);
+    vk::Result waitResult
+        = device.waitForFences({ *fence }, vk::True, std::numeric_limits<uint64_t>::max());
+    if (waitResult != vk::Result::eSuccess) {
+        throw std::runtime_error(
+            "Failed to wait for immediate submission: " + vk::to_string(waitResult));
+    }
+}
+
+void transitionMipLevels(
+    vk::CommandBuffer commandBuffer,
+    vk::Image image,
+    uint32_t baseMipLevel,
+    uint32_t levelCount,
+    vk::ImageLayout oldLayout,
+    vk::ImageLayout newLayout,
+    vk::AccessFlags srcAccessMask,
+    vk::AccessFlags dstAccessMask,
+    vk::PipelineStageFlags srcStageMask,
+    vk::PipelineStageFlags dstStageMask)
+{
+    vk::ImageMemoryBarrier barrier {
+        .srcAccessMask = srcAccessMask,
+        .dstAccessMask = dstAccessMask,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+        .image = image,
+        .subresourceRange = {
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = baseMipLevel,
+            .levelCount = levelCount,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    commandBuffer.pipelineBarrier(srcStageMask, dstStageMask, {}, {}, {}, { barrier });
+}
+
+} // namespace vki
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <functional>
+
+namespace vki {
+
+// Record commands into a transient command buffer, submit them and wait for their completion.
+// Meant for setup work like uploads, not for per-frame rendering.
+void submitImmediate(
+    vk::Device device,
+    vk::Queue queue,
+    QueueFamilyIndex queueFamilyIndex,
+    const std::function<void(vk::CommandBuffer)>& record);
+
+// Record a layout transition of a range of mip levels of a single layer color image
+void transitionMipLevels(
+    vk::CommandBuffer commandBuffer,
+    vk::Image image,
+    uint32_t baseMipLevel,
+    uint32_t levelCount,
+    vk::ImageLayout oldLayout,
+    vk::ImageLayout newLayout,
+    vk::AccessFlags srcAccessMask,
+    vk::AccessFlags dstAccessMask,
+    vk::PipelineStageFlags srcStageMask,
+    vk::PipelineStageFlags dstStageMask);
+
+} // namespace vki
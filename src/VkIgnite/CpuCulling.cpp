@@ -0,0 +1,351 @@
+#include "CpuCulling.hpp"
+
+#include "Stdx/ParallelFor.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VKI_CULLING_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+// Compile a function for an instruction set not enabled for the whole target, so that it can be
+// selected at runtime. MSVC allows intrinsics of any instruction set without annotation.
+#if defined(__GNUC__) || defined(__clang__)
+#define VKI_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VKI_TARGET(isa)
+#endif
+
+namespace vki {
+
+namespace {
+
+void initChunk(BoundsChunk& chunk)
+{
+    // A negative infinite radius makes the sphere fail every plane test
+    chunk.centerX.fill(0.0f);
+    chunk.centerY.fill(0.0f);
+    chunk.centerZ.fill(0.0f);
+    chunk.radius.fill(-std::numeric_limits<float>::infinity());
+}
+
+uint16_t cullChunkScalar(const Frustum& frustum, const BoundsChunk& chunk)
+{
+    uint16_t visibilityMask = 0;
+    for (size_t lane = 0; lane < kBoundsChunkSize; lane++) {
+        const glm::vec3 center { chunk.centerX[lane], chunk.centerY[lane], chunk.centerZ[lane] };
+        if (frustum.intersectsSphere(center, chunk.radius[lane])) {
+            visibilityMask |= static_cast<uint16_t>(1u << lane);
+        }
+    }
+    return visibilityMask;
+}
+
+void cullScalar(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks)
+{
+    for (size_t i = 0; i < chunks.size(); i++) {
+        visibilityMasks[i] = cullChunkScalar(frustum, chunks[i]);
+    }
+}
+
+#if VKI_CULLING_X86
+
+// SSE2 is part of the x86-64 baseline, no target annotation needed
+void cullSse(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks)
+{
+    // Plain array as std::array drops the alignment attributes of vector types
+    __m128 planes[6][4];
+    for (size_t p = 0; p < 6; p++) {
+        for (glm::length_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const BoundsChunk& chunk = chunks[i];
+        uint32_t visibilityMask = 0;
+        for (size_t lane = 0; lane < kBoundsChunkSize; lane += 4) {
+            const __m128 x = _mm_load_ps(&chunk.centerX[lane]);
+            const __m128 y = _mm_load_ps(&chunk.centerY[lane]);
+            const __m128 z = _mm_load_ps(&chunk.centerZ[lane]);
+            const __m128 negRadius
+                = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&chunk.radius[lane]));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const __m128(&plane)[4] : planes) {
+                const __m128 xy = _mm_add_ps(_mm_mul_ps(plane[0], x), _mm_mul_ps(plane[1], y));
+                const __m128 distance
+                    = _mm_add_ps(_mm_add_ps(xy, _mm_mul_ps(plane[2], z)), plane[3]);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+            visibilityMask |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << lane;
+        }
+        visibilityMasks[i] = static_cast<uint16_t>(visibilityMask);
+    }
+}
+
+VKI_TARGET("avx2")
+void cullAvx2(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks)
+{
+    // Plain array as std::array drops the alignment attributes of vector types
+    __m256 planes[6][4];
+    for (size_t p = 0; p < 6; p++) {
+        for (glm::length_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const BoundsChunk& chunk = chunks[i];
+        uint32_t visibilityMask = 0;
+        for (size_t lane = 0; lane < kBoundsChunkSize; lane += 8) {
+            const __m256 x = _mm256_load_ps(&chunk.centerX[lane]);
+            const __m256 y = _mm256_load_ps(&chunk.centerY[lane]);
+            const __m256 z = _mm256_load_ps(&chunk.centerZ[lane]);
+            const __m256 negRadius
+                = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(&chunk.radius[lane]));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const __m256(&plane)[4] : planes) {
+                const __m256 xy
+                    = _mm256_add_ps(_mm256_mul_ps(plane[0], x), _mm256_mul_ps(plane[1], y));
+                const __m256 distance
+                    = _mm256_add_ps(_mm256_add_ps(xy, _mm256_mul_ps(plane[2], z)), plane[3]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+            }
+            visibilityMask |= static_cast<uint32_t>(_mm256_movemask_ps(inside)) << lane;
+        }
+        visibilityMasks[i] = static_cast<uint16_t>(visibilityMask);
+    }
+}
+
+VKI_TARGET("avx512f")
+void cullAvx512(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks)
+{
+    // Plain array as std::array drops the alignment attributes of vector types
+    __m512 planes[6][4];
+    for (size_t p = 0; p < 6; p++) {
+        for (glm::length_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm512_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const BoundsChunk& chunk = chunks[i];
+        const __m512 x = _mm512_load_ps(chunk.centerX.data());
+        const __m512 y = _mm512_load_ps(chunk.centerY.data());
+        const __m512 z = _mm512_load_ps(chunk.centerZ.data());
+        const __m512 negRadius
+            = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_load_ps(chunk.radius.data()));
+        __mmask16 inside = 0xFFFF;
+        for (const __m512(&plane)[4] : planes) {
+            const __m512 xy = _mm512_add_ps(_mm512_mul_ps(plane[0], x), _mm512_mul_ps(plane[1], y));
+            const __m512 distance
+                = _mm512_add_ps(_mm512_add_ps(xy, _mm512_mul_ps(plane[2], z)), plane[3]);
+            inside = _mm512_mask_cmp_ps_mask(inside, distance, negRadius, _CMP_GE_OQ);
+        }
+        visibilityMasks[i] = static_cast<uint16_t>(inside);
+    }
+}
+
+CullingKernel detectCullingKernel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    std::array<int, 4> registers;
+    __cpuid(registers.data(), 1);
+    const bool osSavesYmm = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x06) == 0x06;
+    const bool osSavesZmm = osSavesYmm && (_xgetbv(0) & 0xE6) == 0xE6;
+    __cpuidex(registers.data(), 7, 0);
+    if (osSavesZmm && (registers[1] & (1 << 16))) {
+        return CullingKernel::Avx512;
+    }
+    if (osSavesYmm && (registers[1] & (1 << 5))) {
+        return CullingKernel::Avx2;
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return CullingKernel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return CullingKernel::Avx2;
+    }
+#endif
+    return CullingKernel::Sse;
+}
+
+#else
+
+CullingKernel detectCullingKernel()
+{
+    return CullingKernel::Scalar;
+}
+
+#endif
+
+} // namespace
+
+uint32_t BoundsStore::add(const glm::vec3& center, float radius)
+{
+    if (size_ % kBoundsChunkSize == 0) {
+        initChunk(chunks_.emplace_back());
+    }
+    const auto objectIndex = static_cast<uint32_t>(size_++);
+    set(objectIndex, center, radius);
+    return objectIndex;
+}
+
+void BoundsStore::set(uint32_t objectIndex, const glm::vec3& center, float radius)
+{
+    BoundsChunk& chunk = chunks_[objectIndex / kBoundsChunkSize];
+    const size_t lane = objectIndex % kBoundsChunkSize;
+    chunk.centerX[lane] = center.x;
+    chunk.centerY[lane] = center.y;
+    chunk.centerZ[lane] = center.z;
+    chunk.radius[lane] = radius;
+}
+
+void BoundsStore::clear()
+{
+    chunks_.clear();
+    size_ = 0;
+}
+
+std::string_view getCullingKernelName(CullingKernel kernel)
+{
+    switch (kernel) {
+    case CullingKernel::Scalar:
+        return "Scalar";
+    case CullingKernel::Sse:
+        return "SSE";
+    case CullingKernel::Avx2:
+        return "AVX2";
+    case CullingKernel::Avx512:
+        return "AVX-512";
+    }
+    return "Unknown";
+}
+
+CullingKernel getBestCullingKernel()
+{
+    static const CullingKernel bestKernel = [] {
+        CullingKernel kernel = detectCullingKernel();
+        spdlog::info("CPU culling kernel: {}", getCullingKernelName(kernel));
+        return kernel;
+    }();
+    return bestKernel;
+}
+
+void cullSpheres(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks,
+    CullingKernel kernel)
+{
+    if (visibilityMasks.size() < chunks.size()) {
+        throw std::invalid_argument("Not enough visibility masks for the bounds chunks");
+    }
+    switch (kernel) {
+    case CullingKernel::Scalar:
+        cullScalar(frustum, chunks, visibilityMasks);
+        return;
+#if VKI_CULLING_X86
+    case CullingKernel::Sse:
+        cullSse(frustum, chunks, visibilityMasks);
+        return;
+    case CullingKernel::Avx2:
+        cullAvx2(frustum, chunks, visibilityMasks);
+        return;
+    case CullingKernel::Avx512:
+        cullAvx512(frustum, chunks, visibilityMasks);
+        return;
+#endif
+    default:
+        throw std::invalid_argument(
+            fmt::format("Unsupported culling kernel {}", getCullingKernelName(kernel)));
+    }
+}
+
+void cullSpheresParallel(
+    stdx::ThreadPool& threadPool,
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks,
+    CullingKernel kernel,
+    size_t minChunksPerTask)
+{
+    if (visibilityMasks.size() < chunks.size()) {
+        throw std::invalid_argument("Not enough visibility masks for the bounds chunks");
+    }
+    stdx::parallel_for(threadPool, chunks.size(), minChunksPerTask, [&](size_t begin, size_t end) {
+        cullSpheres(
+            frustum,
+            chunks.subspan(begin, end - begin),
+            visibilityMasks.subspan(begin, end - begin),
+            kernel);
+    });
+}
+
+namespace {
+
+// Call function(objectIndex) for each visible object, in increasing order
+template<typename TFunction>
+void forEachVisibleObject(std::span<const uint16_t> visibilityMasks, TFunction&& function)
+{
+    for (size_t chunkIndex = 0; chunkIndex < visibilityMasks.size(); chunkIndex++) {
+        uint32_t visibilityMask = visibilityMasks[chunkIndex];
+        while (visibilityMask != 0) {
+            const auto lane = static_cast<uint32_t>(std::countr_zero(visibilityMask));
+            function(static_cast<uint32_t>(chunkIndex * kBoundsChunkSize) + lane);
+            visibilityMask &= visibilityMask - 1;
+        }
+    }
+}
+
+} // namespace
+
+void collectVisibleObjects(
+    std::span<const uint16_t> visibilityMasks,
+    std::vector<uint32_t>& visibleObjects)
+{
+    forEachVisibleObject(visibilityMasks, [&](uint32_t objectIndex) {
+        visibleObjects.push_back(objectIndex);
+    });
+}
+
+std::span<uint32_t> collectVisibleObjects(
+    std::span<const uint16_t> visibilityMasks,
+    stdx::LinearArena& arena)
+{
+    size_t visibleObjectCount = 0;
+    for (uint16_t visibilityMask : visibilityMasks) {
+        visibleObjectCount += static_cast<size_t>(std::popcount(visibilityMask));
+    }
+    std::span<uint32_t> visibleObjects = arena.createArray<uint32_t>(visibleObjectCount);
+    size_t i = 0;
+    forEachVisibleObject(visibilityMasks, [&](uint32_t objectIndex) {
+        visibleObjects[i++] = objectIndex;
+    });
+    return visibleObjects;
+}
+
+} // namespace vki
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Frustum.hpp"
+
+#include "Stdx/LinearArena.hpp"
+#include "Stdx/ThreadPool.hpp"
+
+#include "Pch/Glm.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace vki {
+
+// Number of spheres per chunk, matching the width of the widest culling kernel (AVX-512)
+constexpr size_t kBoundsChunkSize = 16;
+
+// Bounding spheres of kBoundsChunkSize objects stored as structure of arrays, so that each
+// component fills exactly one 64-byte cache line and can be loaded with aligned vector loads
+struct alignas(64) BoundsChunk {
+    std::array<float, kBoundsChunkSize> centerX;
+    std::array<float, kBoundsChunkSize> centerY;
+    std::array<float, kBoundsChunkSize> centerZ;
+    std::array<float, kBoundsChunkSize> radius;
+};
+static_assert(sizeof(BoundsChunk) == 4 * 64);
+
+// World space bounding spheres of the scene objects, addressed by object index.
+// Unused slots of the last chunk hold degenerate spheres always culled by the kernels.
+class BoundsStore {
+public:
+    // Append a sphere and return its object index
+    uint32_t add(const glm::vec3& center, float radius);
+    void set(uint32_t objectIndex, const glm::vec3& center, float radius);
+    void clear();
+
+    [[nodiscard]] size_t size() const
+    {
+        return size_;
+    }
+
+    [[nodiscard]] std::span<const BoundsChunk> chunks() const
+    {
+        return chunks_;
+    }
+
+private:
+    std::vector<BoundsChunk> chunks_;
+    size_t size_ = 0;
+};
+
+enum class CullingKernel {
+    Scalar, // Reference implementation, one sphere at a time
+    Sse, // 4 spheres per iteration
+    Avx2, // 8 spheres per iteration
+    Avx512, // 16 spheres per iteration
+};
+
+[[nodiscard]] std::string_view getCullingKernelName(CullingKernel kernel);
+
+// Widest kernel supported by the CPU, detected once on first call
+[[nodiscard]] CullingKernel getBestCullingKernel();
+
+// Test the spheres of each chunk against the frustum. Bit i of visibilityMasks[c] is set if the
+// object c * kBoundsChunkSize + i is visible. visibilityMasks must hold one mask per chunk.
+void cullSpheres(
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks,
+    CullingKernel kernel = getBestCullingKernel());
+
+// Same as cullSpheres, with the chunks split across the pool workers and the calling thread
+void cullSpheresParallel(
+    stdx::ThreadPool& threadPool,
+    const Frustum& frustum,
+    std::span<const BoundsChunk> chunks,
+    std::span<uint16_t> visibilityMasks,
+    CullingKernel kernel = getBestCullingKernel(),
+    size_t minChunksPerTask = 64);
+
+// Append the indices of the visible objects, in increasing order, to visibleObjects
+void collectVisibleObjects(
+    std::span<const uint16_t> visibilityMasks,
+    std::vector<uint32_t>& visibleObjects);
+
+// Indices of the visible objects, in increasing order, allocated from a frame arena
+[[nodiscard]] std::span<uint32_t> collectVisibleObjects(
+    std::span<const uint16_t> visibilityMasks,
+    stdx::LinearArena& arena);
+
+} // namespace vki
@@ -0,0 +1,134 @@
+#include "DebugMessageSink.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace vki {
+
+DebugMessageSink::DebugMessageSink(const DebugMessageSinkCreateInfo& debugMessageSinkCreateInfo)
+    : mutedMessageIds_ { debugMessageSinkCreateInfo.mutedMessageIds }
+    , maxMessagesPerIdPerSecond_ { debugMessageSinkCreateInfo.maxMessagesPerIdPerSecond }
+    , ring_ { debugMessageSinkCreateInfo.capacity }
+    , thread_ { [this](std::stop_token stopToken) { run(stopToken); } }
+{
+    std::ranges::sort(mutedMessageIds_);
+}
+
+DebugMessageSink::~DebugMessageSink()
+{
+    thread_.request_stop();
+    pushCount_.fetch_add(1, std::memory_order_release);
+    pushCount_.notify_one();
+    thread_.join();
+}
+
+void DebugMessageSink::push(
+    vk::DebugUtilsMessageSeverityFlagBitsEXT severity,
+    int32_t messageId,
+    const char* text)
+{
+    if (std::ranges::binary_search(mutedMessageIds_, messageId)) {
+        return;
+    }
+
+    Message message;
+    message.severity = severity;
+    message.messageId = messageId;
+    message.length = static_cast<uint32_t>(std::min(std::strlen(text), kMaxMessageLength));
+    std::memcpy(message.text.data(), text, message.length);
+    if (!ring_.tryPush(message)) {
+        droppedCount_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pushCount_.fetch_add(1, std::memory_order_release);
+    pushCount_.notify_one();
+}
+
+[[nodiscard]] uint64_t DebugMessageSink::getDroppedMessageCount() const
+{
+    return droppedCount_.load(std::memory_order_relaxed);
+}
+
+void DebugMessageSink::run(std::stop_token stopToken)
+{
+    while (!stopToken.stop_requested()) {
+        const uint32_t pushCount = pushCount_.load(std::memory_order_acquire);
+        drain();
+        // The destructor requests the stop before bumping the count
+        if (stopToken.stop_requested()) {
+            break;
+        }
+        pushCount_.wait(pushCount, std::memory_order_acquire);
+    }
+    drain();
+
+    for (auto& [messageId, state] : messageIdStates_) {
+        reportSuppressed(messageId, state);
+    }
+}
+
+void DebugMessageSink::drain()
+{
+    Message message;
+    while (ring_.tryPop(message)) {
+        process(message);
+    }
+
+    const uint64_t droppedCount = droppedCount_.load(std::memory_order_relaxed);
+    if (droppedCount != reportedDroppedCount_) {
+        spdlog::warn(
+            "Dropped {} debug messages, the ring buffer was full",
+            droppedCount - reportedDroppedCount_);
+        reportedDroppedCount_ = droppedCount;
+    }
+}
+
+void DebugMessageSink::process(const Message& message)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const std::string_view text { message.text.data(), message.length };
+
+    MessageIdState& state = messageIdStates_[message.messageId];
+    if (now - state.windowStart >= std::chrono::seconds(1)) {
+        reportSuppressed(message.messageId, state);
+        state.windowStart = now;
+        state.loggedCount = 0;
+    }
+
+    const size_t messageHash = std::hash<std::string_view> {}(text);
+    const bool isDuplicate = state.loggedCount > 0 && messageHash == state.lastMessageHash;
+    if (isDuplicate || state.loggedCount >= maxMessagesPerIdPerSecond_) {
+        state.suppressedCount++;
+        return;
+    }
+    state.loggedCount++;
+    state.lastMessageHash = messageHash;
+
+    using enum vk::DebugUtilsMessageSeverityFlagBitsEXT;
+    if /*  */ (message.severity & eError) {
+        spdlog::error(text);
+    } else if (message.severity & eWarning) {
+        spdlog::warn(text);
+    } else if (message.severity & eInfo) {
+        spdlog::info(text);
+    } else if (message.severity & eVerbose) {
+        spdlog::debug(text);
+    }
+}
+
+void DebugMessageSink::reportSuppressed(int32_t messageId, MessageIdState& state)
+{
+    if (state.suppressedCount == 0) {
+        return;
+    }
+    spdlog::info(
+        "Suppressed {} repeated debug messages with id {:#x}",
+        state.suppressedCount,
+        static_cast<uint32_t>(messageId));
+    state.suppressedCount = 0;
+}
+
+} // namespace vki
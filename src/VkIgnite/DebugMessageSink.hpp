@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Stdx/MpscRing.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vki {
+
+struct DebugMessageSinkCreateInfo {
+    // Messages that can wait for the logger thread before new ones get dropped
+    uint32_t capacity = 256;
+    // Messages logged per message id and per second, the others are counted and summarized
+    uint32_t maxMessagesPerIdPerSecond = 10;
+    // Ids of the messages dropped without being queued
+    std::vector<int32_t> mutedMessageIds = {};
+};
+
+// Destination of the default debug messenger.
+//
+// The messenger callback runs on whatever thread made the Vulkan call, so it only copies the
+// message into a lock-free ring and returns. A background thread formats and logs the messages,
+// skipping a message identical to the previous one of the same id and limiting the rate of each
+// message id. Messages arriving while the ring is full are dropped and counted.
+class DebugMessageSink {
+public:
+    explicit DebugMessageSink(const DebugMessageSinkCreateInfo& debugMessageSinkCreateInfo);
+    ~DebugMessageSink();
+
+    DebugMessageSink(const DebugMessageSink&) = delete;
+    DebugMessageSink& operator=(const DebugMessageSink&) = delete;
+
+    // Thread safe and never blocks, messages longer than the slots are truncated
+    void push(
+        vk::DebugUtilsMessageSeverityFlagBitsEXT severity,
+        int32_t messageId,
+        const char* text);
+
+    // Messages lost because the ring was full
+    [[nodiscard]] uint64_t getDroppedMessageCount() const;
+
+private:
+    static constexpr size_t kMaxMessageLength = 1024;
+
+    struct Message {
+        vk::DebugUtilsMessageSeverityFlagBitsEXT severity;
+        int32_t messageId = 0;
+        uint32_t length = 0;
+        // Zeroed, the ring copies the whole message and not only the first length characters
+        std::array<char, kMaxMessageLength> text {};
+    };
+
+    struct MessageIdState {
+        std::chrono::steady_clock::time_point windowStart;
+        uint32_t loggedCount = 0;
+        uint32_t suppressedCount = 0;
+        size_t lastMessageHash = 0;
+    };
+
+    void run(std::stop_token stopToken);
+    void drain();
+    void process(const Message& message);
+    void reportSuppressed(int32_t messageId, MessageIdState& state);
+
+    std::vector<int32_t> mutedMessageIds_;
+    uint32_t maxMessagesPerIdPerSecond_;
+    stdx::MpscRing<Message> ring_;
+    // Bumped after each push so that the logger thread can sleep on it
+    std::atomic<uint32_t> pushCount_ = 0;
+    std::atomic<uint64_t> droppedCount_ = 0;
+    // Logger thread only
+    uint64_t reportedDroppedCount_ = 0;
+    std::unordered_map<int32_t, MessageIdState> messageIdStates_;
+    // Started last, as it uses all the members above
+    std::jthread thread_;
+};
+
+} // namespace vki
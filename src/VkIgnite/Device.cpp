@@ -1,11 +1,298 @@
 #include "Device.hpp"
+#include "DeviceDispatch.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 namespace vki {
 
-[[nodiscard]] static vk::UniqueDevice makeDeviceUnique(
-    const DeviceCreateInfo& deviceCreateInfo,
-    vk::PhysicalDevice physicalDevice)
+// Name of each feature member, walked to resolve the features and report the unsupported ones
+template<typename TFeatures>
+struct FeatureName {
+    std::string_view name;
+    vk::Bool32 TFeatures::*member;
+};
+
+template<typename TFeatures>
+using FeatureNames = std::span<const FeatureName<TFeatures>>;
+
+#define VKI_FEATURE(member) { #member, &TFeatures::member }
+
+[[nodiscard]] static FeatureNames<vk::PhysicalDeviceFeatures> getFeatureNames(
+    const vk::PhysicalDeviceFeatures&)
+{
+    using TFeatures = vk::PhysicalDeviceFeatures;
+    static constexpr FeatureName<TFeatures> kNames[] = {
+        VKI_FEATURE(robustBufferAccess),
+        VKI_FEATURE(fullDrawIndexUint32),
+        VKI_FEATURE(imageCubeArray),
+        VKI_FEATURE(independentBlend),
+        VKI_FEATURE(geometryShader),
+        VKI_FEATURE(tessellationShader),
+        VKI_FEATURE(sampleRateShading),
+        VKI_FEATURE(dualSrcBlend),
+        VKI_FEATURE(logicOp),
+        VKI_FEATURE(multiDrawIndirect),
+        VKI_FEATURE(drawIndirectFirstInstance),
+        VKI_FEATURE(depthClamp),
+        VKI_FEATURE(depthBiasClamp),
+        VKI_FEATURE(fillModeNonSolid),
+        VKI_FEATURE(depthBounds),
+        VKI_FEATURE(wideLines),
+        VKI_FEATURE(largePoints),
+        VKI_FEATURE(alphaToOne),
+        VKI_FEATURE(multiViewport),
+        VKI_FEATURE(samplerAnisotropy),
+        VKI_FEATURE(textureCompressionETC2),
+        VKI_FEATURE(textureCompressionASTC_LDR),
+        VKI_FEATURE(textureCompressionBC),
+        VKI_FEATURE(occlusionQueryPrecise),
+        VKI_FEATURE(pipelineStatisticsQuery),
+        VKI_FEATURE(vertexPipelineStoresAndAtomics),
+        VKI_FEATURE(fragmentStoresAndAtomics),
+        VKI_FEATURE(shaderTessellationAndGeometryPointSize),
+        VKI_FEATURE(shaderImageGatherExtended),
+        VKI_FEATURE(shaderStorageImageExtendedFormats),
+        VKI_FEATURE(shaderStorageImageMultisample),
+        VKI_FEATURE(shaderStorageImageReadWithoutFormat),
+        VKI_FEATURE(shaderStorageImageWriteWithoutFormat),
+        VKI_FEATURE(shaderUniformBufferArrayDynamicIndexing),
+        VKI_FEATURE(shaderSampledImageArrayDynamicIndexing),
+        VKI_FEATURE(shaderStorageBufferArrayDynamicIndexing),
+        VKI_FEATURE(shaderStorageImageArrayDynamicIndexing),
+        VKI_FEATURE(shaderClipDistance),
+        VKI_FEATURE(shaderCullDistance),
+        VKI_FEATURE(shaderFloat64),
+        VKI_FEATURE(shaderInt64),
+        VKI_FEATURE(shaderInt16),
+        VKI_FEATURE(shaderResourceResidency),
+        VKI_FEATURE(shaderResourceMinLod),
+        VKI_FEATURE(sparseBinding),
+        VKI_FEATURE(sparseResidencyBuffer),
+        VKI_FEATURE(sparseResidencyImage2D),
+        VKI_FEATURE(sparseResidencyImage3D),
+        VKI_FEATURE(sparseResidency2Samples),
+        VKI_FEATURE(sparseResidency4Samples),
+        VKI_FEATURE(sparseResidency8Samples),
+        VKI_FEATURE(sparseResidency16Samples),
+        VKI_FEATURE(sparseResidencyAliased),
+        VKI_FEATURE(variableMultisampleRate),
+        VKI_FEATURE(inheritedQueries),
+    };
+    return kNames;
+}
+
+[[nodiscard]] static FeatureNames<vk::PhysicalDeviceVulkan11Features> getFeatureNames(
+    const vk::PhysicalDeviceVulkan11Features&)
+{
+    using TFeatures = vk::PhysicalDeviceVulkan11Features;
+    static constexpr FeatureName<TFeatures> kNames[] = {
+        VKI_FEATURE(storageBuffer16BitAccess),
+        VKI_FEATURE(uniformAndStorageBuffer16BitAccess),
+        VKI_FEATURE(storagePushConstant16),
+        VKI_FEATURE(storageInputOutput16),
+        VKI_FEATURE(multiview),
+        VKI_FEATURE(multiviewGeometryShader),
+        VKI_FEATURE(multiviewTessellationShader),
+        VKI_FEATURE(variablePointersStorageBuffer),
+        VKI_FEATURE(variablePointers),
+        VKI_FEATURE(protectedMemory),
+        VKI_FEATURE(samplerYcbcrConversion),
+        VKI_FEATURE(shaderDrawParameters),
+    };
+    return kNames;
+}
+
+[[nodiscard]] static FeatureNames<vk::PhysicalDeviceVulkan12Features> getFeatureNames(
+    const vk::PhysicalDeviceVulkan12Features&)
+{
+    using TFeatures = vk::PhysicalDeviceVulkan12Features;
+    static constexpr FeatureName<TFeatures> kNames[] = {
+        VKI_FEATURE(samplerMirrorClampToEdge),
+        VKI_FEATURE(drawIndirectCount),
+        VKI_FEATURE(storageBuffer8BitAccess),
+        VKI_FEATURE(uniformAndStorageBuffer8BitAccess),
+        VKI_FEATURE(storagePushConstant8),
+        VKI_FEATURE(shaderBufferInt64Atomics),
+        VKI_FEATURE(shaderSharedInt64Atomics),
+        VKI_FEATURE(shaderFloat16),
+        VKI_FEATURE(shaderInt8),
+        VKI_FEATURE(descriptorIndexing),
+        VKI_FEATURE(shaderInputAttachmentArrayDynamicIndexing),
+        VKI_FEATURE(shaderUniformTexelBufferArrayDynamicIndexing),
+        VKI_FEATURE(shaderStorageTexelBufferArrayDynamicIndexing),
+        VKI_FEATURE(shaderUniformBufferArrayNonUniformIndexing),
+        VKI_FEATURE(shaderSampledImageArrayNonUniformIndexing),
+        VKI_FEATURE(shaderStorageBufferArrayNonUniformIndexing),
+        VKI_FEATURE(shaderStorageImageArrayNonUniformIndexing),
+        VKI_FEATURE(shaderInputAttachmentArrayNonUniformIndexing),
+        VKI_FEATURE(shaderUniformTexelBufferArrayNonUniformIndexing),
+        VKI_FEATURE(shaderStorageTexelBufferArrayNonUniformIndexing),
+        VKI_FEATURE(descriptorBindingUniformBufferUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingSampledImageUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingStorageImageUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingStorageBufferUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingUniformTexelBufferUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingStorageTexelBufferUpdateAfterBind),
+        VKI_FEATURE(descriptorBindingUpdateUnusedWhilePending),
+        VKI_FEATURE(descriptorBindingPartiallyBound),
+        VKI_FEATURE(descriptorBindingVariableDescriptorCount),
+        VKI_FEATURE(runtimeDescriptorArray),
+        VKI_FEATURE(samplerFilterMinmax),
+        VKI_FEATURE(scalarBlockLayout),
+        VKI_FEATURE(imagelessFramebuffer),
+        VKI_FEATURE(uniformBufferStandardLayout),
+        VKI_FEATURE(shaderSubgroupExtendedTypes),
+        VKI_FEATURE(separateDepthStencilLayouts),
+        VKI_FEATURE(hostQueryReset),
+        VKI_FEATURE(timelineSemaphore),
+        VKI_FEATURE(bufferDeviceAddress),
+        VKI_FEATURE(bufferDeviceAddressCaptureReplay),
+        VKI_FEATURE(bufferDeviceAddressMultiDevice),
+        VKI_FEATURE(vulkanMemoryModel),
+        VKI_FEATURE(vulkanMemoryModelDeviceScope),
+        VKI_FEATURE(vulkanMemoryModelAvailabilityVisibilityChains),
+        VKI_FEATURE(shaderOutputViewportIndex),
+        VKI_FEATURE(shaderOutputLayer),
+        VKI_FEATURE(subgroupBroadcastDynamicId),
+    };
+    return kNames;
+}
+
+[[nodiscard]] static FeatureNames<vk::PhysicalDeviceVulkan13Features> getFeatureNames(
+    const vk::PhysicalDeviceVulkan13Features&)
+{
+    using TFeatures = vk::PhysicalDeviceVulkan13Features;
+    static constexpr FeatureName<TFeatures> kNames[] = {
+        VKI_FEATURE(robustImageAccess),
+        VKI_FEATURE(inlineUniformBlock),
+        VKI_FEATURE(descriptorBindingInlineUniformBlockUpdateAfterBind),
+        VKI_FEATURE(pipelineCreationCacheControl),
+        VKI_FEATURE(privateData),
+        VKI_FEATURE(shaderDemoteToHelperInvocation),
+        VKI_FEATURE(shaderTerminateInvocation),
+        VKI_FEATURE(subgroupSizeControl),
+        VKI_FEATURE(computeFullSubgroups),
+        VKI_FEATURE(synchronization2),
+        VKI_FEATURE(textureCompressionASTC_HDR),
+        VKI_FEATURE(shaderZeroInitializeWorkgroupMemory),
+        VKI_FEATURE(dynamicRendering),
+        VKI_FEATURE(shaderIntegerDotProduct),
+        VKI_FEATURE(maintenance4),
+    };
+    return kNames;
+}
+
+#undef VKI_FEATURE
+
+// Enable the required features and the supported optional ones of a structure, collecting the
+// required ones the device does not support
+template<typename TFeatures>
+static void resolveFeatures(
+    std::string_view structureName,
+    TFeatures& enabled,
+    const TFeatures& required,
+    const TFeatures& optional,
+    const TFeatures& supported,
+    std::vector<std::string>& unsupportedFeatures)
 {
+    for (const auto& [name, member] : getFeatureNames(enabled)) {
+        const bool isRequired = required.*member;
+        const bool isOptional = optional.*member;
+        const bool isSupported = supported.*member;
+        if (isRequired && !isSupported) {
+            unsupportedFeatures.push_back(std::format("{}::{}", structureName, name));
+        } else if (isOptional && !isSupported) {
+            spdlog::debug("Optional device feature {}::{} is not supported", structureName, name);
+        }
+        enabled.*member = isRequired || (isOptional && isSupported) ? vk::True : vk::False;
+    }
+}
+
+[[nodiscard]] DeviceFeatureChain getPerformanceFeatures()
+{
+    DeviceFeatureChain features;
+
+    vk::PhysicalDeviceFeatures& features10 = features.get<vk::PhysicalDeviceFeatures2>().features;
+    features10.multiDrawIndirect = vk::True;
+    features10.drawIndirectFirstInstance = vk::True;
+    features10.samplerAnisotropy = vk::True;
+
+    auto& features12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+    features12.drawIndirectCount = vk::True;
+    features12.timelineSemaphore = vk::True;
+    features12.bufferDeviceAddress = vk::True;
+    features12.descriptorIndexing = vk::True;
+    features12.runtimeDescriptorArray = vk::True;
+    features12.descriptorBindingPartiallyBound = vk::True;
+    features12.shaderSampledImageArrayNonUniformIndexing = vk::True;
+
+    auto& features13 = features.get<vk::PhysicalDeviceVulkan13Features>();
+    features13.synchronization2 = vk::True;
+    features13.dynamicRendering = vk::True;
+
+    return features;
+}
+
+[[nodiscard]] Device Device::make(
+    const PhysicalDeviceInfo& physicalDeviceInfo,
+    const DeviceCreateInfo& deviceCreateInfo)
+{
+    const DeviceFeatureChain& required = deviceCreateInfo.requiredFeatures;
+    const DeviceFeatureChain& optional = deviceCreateInfo.optionalFeatures;
+
+    DeviceFeatureChain enabledFeatures;
+    std::vector<std::string> unsupportedFeatures;
+    resolveFeatures(
+        "PhysicalDeviceFeatures",
+        enabledFeatures.get<vk::PhysicalDeviceFeatures2>().features,
+        required.get<vk::PhysicalDeviceFeatures2>().features,
+        optional.get<vk::PhysicalDeviceFeatures2>().features,
+        physicalDeviceInfo.features,
+        unsupportedFeatures);
+    resolveFeatures(
+        "PhysicalDeviceVulkan11Features",
+        enabledFeatures.get<vk::PhysicalDeviceVulkan11Features>(),
+        required.get<vk::PhysicalDeviceVulkan11Features>(),
+        optional.get<vk::PhysicalDeviceVulkan11Features>(),
+        physicalDeviceInfo.features11,
+        unsupportedFeatures);
+    resolveFeatures(
+        "PhysicalDeviceVulkan12Features",
+        enabledFeatures.get<vk::PhysicalDeviceVulkan12Features>(),
+        required.get<vk::PhysicalDeviceVulkan12Features>(),
+        optional.get<vk::PhysicalDeviceVulkan12Features>(),
+        physicalDeviceInfo.features12,
+        unsupportedFeatures);
+    resolveFeatures(
+        "PhysicalDeviceVulkan13Features",
+        enabledFeatures.get<vk::PhysicalDeviceVulkan13Features>(),
+        required.get<vk::PhysicalDeviceVulkan13Features>(),
+        optional.get<vk::PhysicalDeviceVulkan13Features>(),
+        physicalDeviceInfo.features13,
+        unsupportedFeatures);
+    if (!unsupportedFeatures.empty()) {
+        std::string message = "Required device features are not supported:";
+        for (const std::string& feature : unsupportedFeatures) {
+            message += " " + feature;
+        }
+        throw std::runtime_error(message);
+    }
+
+    // The features of the unlinked structures are all disabled, as the snapshot leaves them
+    // value initialized
+    unlinkUnsupportedVersionStructures<
+        vk::PhysicalDeviceVulkan11Features,
+        vk::PhysicalDeviceVulkan12Features,
+        vk::PhysicalDeviceVulkan13Features>(
+        enabledFeatures,
+        physicalDeviceInfo.properties.apiVersion);
+
     // Prepare the creation of each desired device queues
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
     for (const QueueCreateInfo& queueCreateInfo : deviceCreateInfo.queueCreateInfos) {
@@ -17,8 +304,18 @@ namespace vki {
         });
     }
 
+    // Chain the structures of the user after the core features for the creation only
+    auto* chainTail = reinterpret_cast<vk::BaseOutStructure*>(
+        &enabledFeatures.get<vk::PhysicalDeviceFeatures2>());
+    while (chainTail->pNext != nullptr) {
+        chainTail = chainTail->pNext;
+    }
+    chainTail->pNext
+        = static_cast<vk::BaseOutStructure*>(const_cast<void*>(deviceCreateInfo.pNext));
+
     // Create a logical device associated to the physical device
-    return physicalDevice.createDeviceUnique({
+    vk::UniqueDevice device = physicalDeviceInfo.handle.createDeviceUnique({
+        .pNext = &enabledFeatures.get<vk::PhysicalDeviceFeatures2>(),
         .flags = deviceCreateInfo.flags,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
@@ -28,23 +325,16 @@ namespace vki {
         = static_cast<uint32_t>(deviceCreateInfo.enabledExtensionNames.size()),
         .ppEnabledExtensionNames = deviceCreateInfo.enabledExtensionNames.data(),
     });
-}
+    chainTail->pNext = nullptr;
 
-[[nodiscard]] Device Device::make(
-    const DeviceCreateInfo& deviceCreateInfo,
-    vk::PhysicalDevice physicalDevice)
-{
-    vk::UniqueDevice device = vki::makeDeviceUnique(deviceCreateInfo, physicalDevice);
-
-    { // Load device extension procedure addresses if requested by the user for this device
-        using enum LoadDeviceExtensions;
-        if (deviceCreateInfo.dispatchLoaderOptions.loadDeviceExtensions == Yes) {
-            VULKAN_HPP_DEFAULT_DISPATCHER.init(*device);
-        }
+    // Otherwise the calls on the device objects go through the loader trampolines
+    if (deviceCreateInfo.defaultDispatcherOption == Option::Enabled) {
+        loadDefaultDeviceDispatch(*device);
     }
 
     return {
         .handle = std::move(device),
+        .enabledFeatures = enabledFeatures,
     };
 }
 
@@ -1,19 +1,14 @@
 #pragma once
 
+#include "Instance.hpp"
+#include "PhysicalDeviceInfo.hpp"
 #include "Types.hpp"
 
 #include "Pch/Vulkan.hpp"
 
-namespace vki {
-
-enum class LoadDeviceExtensions {
-    No,
-    Yes,
-};
+#include <vector>
 
-struct DefaultDispatchLoaderDynamicOptions {
-    LoadDeviceExtensions loadDeviceExtensions;
-};
+namespace vki {
 
 struct QueueCreateInfo {
     vk::DeviceQueueCreateFlags flags = {};
@@ -21,35 +16,46 @@ struct QueueCreateInfo {
     std::vector<float> queuePriorities = {};
 };
 
+// Core features a device is created with. The Vulkan 1.2 and 1.3 structures are left out of the
+// creation when the device does not support these versions.
+using DeviceFeatureChain = vk::StructureChain<
+    vk::PhysicalDeviceFeatures2,
+    vk::PhysicalDeviceVulkan11Features,
+    vk::PhysicalDeviceVulkan12Features,
+    vk::PhysicalDeviceVulkan13Features>;
+
+// Features the VkIgnite subsystems rely on for performance: indirect draws for GpuCulling,
+// timeline semaphores for AsyncCompute, synchronization2 for FrameGraph, dynamic rendering,
+// descriptor indexing, buffer device address and sampler anisotropy
+[[nodiscard]] DeviceFeatureChain getPerformanceFeatures();
+
 struct DeviceCreateInfo {
     vk::DeviceCreateFlags flags = {};
-    // List of queues to create per family
     std::vector<QueueCreateInfo> queueCreateInfos = {};
-    // List of device layers to enable
     std::vector<LayerName> enabledLayerNames = {};
-    // List of device extensions to enable
     std::vector<ExtensionName> enabledExtensionNames = {};
-    // Options related to the default distpatch loader dynamic if used
-    DefaultDispatchLoaderDynamicOptions dispatchLoaderOptions = {};
+    // Features the creation fails without
+    DeviceFeatureChain requiredFeatures = {};
+    // Features enabled when the device supports them
+    DeviceFeatureChain optionalFeatures = getPerformanceFeatures();
+    // Structures chained after the core features, such as extension features
+    const void* pNext = nullptr;
+    // Whether to load the device functions into the default dispatcher. Must only be enabled for
+    // one device, the others using their own DeviceDispatch.
+    Option defaultDispatcherOption = Option::Enabled;
 };
 
-namespace ppdp {
-// Polymorphic Physical Device Picker
-
-}
-
 class Device {
 public:
+    // Check the requested features against the device, then create it with the required
+    // features and the supported optional ones
     [[nodiscard]] static Device make(
-        const DeviceCreateInfo& deviceCreateInfo,
-        vk::PhysicalDevice physicalDevice);
-
-    template<typename TPhysicalDevicePicker>
-    [[nodiscard]] static Device make(
-        const DeviceCreateInfo& deviceCreateInfo,
-        const TPhysicalDevicePicker& physicalDevicePicker);
+        const PhysicalDeviceInfo& physicalDeviceInfo,
+        const DeviceCreateInfo& deviceCreateInfo);
 
     vk::UniqueDevice handle;
+    // Features the device has been created with, not linked to the structures of pNext
+    DeviceFeatureChain enabledFeatures;
 };
 
 } // namespace vki
@@ -0,0 +1,31 @@
+#include "DeviceDispatch.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+namespace vki {
+
+[[nodiscard]] DeviceDispatch DeviceDispatch::make(vk::Instance instance, vk::Device device)
+{
+    // The default dispatcher has been initialized by the instance creation, it provides the
+    // entry point of the loader
+    return {
+        .table = std::make_unique<vk::DispatchLoaderDynamic>(
+            instance,
+            VULKAN_HPP_DEFAULT_DISPATCHER.vkGetInstanceProcAddr,
+            device,
+            VULKAN_HPP_DEFAULT_DISPATCHER.vkGetDeviceProcAddr),
+    };
+}
+
+[[nodiscard]] const vk::DispatchLoaderDynamic& DeviceDispatch::get() const
+{
+    return *table;
+}
+
+void loadDefaultDeviceDispatch(vk::Device device)
+{
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
+    spdlog::debug("Loaded the device level functions into the default dispatcher");
+}
+
+} // namespace vki
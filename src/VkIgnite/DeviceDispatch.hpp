@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <memory>
+
+namespace vki {
+
+// Device level function pointers queried with vkGetDeviceProcAddr. Calling them reaches the driver
+// directly, while pointers queried from the instance go through loader trampolines looking up the
+// dispatch table of the device on every call, which adds up on command recording.
+//
+// Each device gets its own table, so several devices can be driven at once by passing it as the
+// dispatch argument of the vulkan-hpp calls. A single device can instead be loaded into the default
+// dispatcher by Device::make.
+class DeviceDispatch {
+public:
+    [[nodiscard]] static DeviceDispatch make(vk::Instance instance, vk::Device device);
+
+    [[nodiscard]] const vk::DispatchLoaderDynamic& get() const;
+
+    // On the heap so that its address, kept by the unique handles created with it, is stable
+    std::unique_ptr<vk::DispatchLoaderDynamic> table;
+};
+
+// Load the device level functions into the default dispatcher, so that calls without an explicit
+// dispatch argument skip the loader trampolines. Only valid for objects of that device.
+void loadDefaultDeviceDispatch(vk::Device device);
+
+} // namespace vki
@@ -0,0 +1,57 @@
+#include "Format.hpp"
+
+#include <array>
+#include <stdexcept>
+
+namespace vki {
+
+[[nodiscard]] std::optional<vk::Format> findSupportedFormat(
+    vk::PhysicalDevice physicalDevice,
+    std::span<const vk::Format> candidates,
+    vk::ImageTiling tiling,
+    vk::FormatFeatureFlags requiredFeatures)
+{
+    for (vk::Format format : candidates) {
+        const vk::FormatProperties properties = physicalDevice.getFormatProperties(format);
+        const vk::FormatFeatureFlags features = tiling == vk::ImageTiling::eLinear
+            ? properties.linearTilingFeatures
+            : properties.optimalTilingFeatures;
+        if ((features & requiredFeatures) == requiredFeatures) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] vk::Format chooseDepthFormat(vk::PhysicalDevice physicalDevice)
+{
+    constexpr std::array candidates {
+        vk::Format::eD32Sfloat,
+        vk::Format::eD24UnormS8Uint,
+        vk::Format::eD16Unorm,
+    };
+    std::optional<vk::Format> format = findSupportedFormat(
+        physicalDevice,
+        candidates,
+        vk::ImageTiling::eOptimal,
+        vk::FormatFeatureFlagBits::eDepthStencilAttachment);
+    if (!format.has_value()) {
+        throw std::runtime_error("No supported depth attachment format found");
+    }
+    return *format;
+}
+
+[[nodiscard]] bool hasStencilComponent(vk::Format format)
+{
+    switch (format) {
+    case vk::Format::eS8Uint:
+    case vk::Format::eD16UnormS8Uint:
+    case vk::Format::eD24UnormS8Uint:
+    case vk::Format::eD32SfloatS8Uint:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace vki
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <optional>
+#include <span>
+
+namespace vki {
+
+// Find the first candidate format providing the required features with the given tiling
+[[nodiscard]] std::optional<vk::Format> findSupportedFormat(
+    vk::PhysicalDevice physicalDevice,
+    std::span<const vk::Format> candidates,
+    vk::ImageTiling tiling,
+    vk::FormatFeatureFlags requiredFeatures);
+
+// Most precise format usable as an optimally tiled depth attachment, D32 then D24S8 then D16
+[[nodiscard]] vk::Format chooseDepthFormat(vk::PhysicalDevice physicalDevice);
+
+[[nodiscard]] bool hasStencilComponent(vk::Format format);
+
+} // namespace vki
@@ -0,0 +1,672 @@
+#include "FrameGraph.hpp"
+#include "Memory.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+namespace vki {
+
+namespace {
+
+constexpr vk::AccessFlags2 kWriteAccessMask = vk::AccessFlagBits2::eShaderWrite
+    | vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eColorAttachmentWrite
+    | vk::AccessFlagBits2::eDepthStencilAttachmentWrite | vk::AccessFlagBits2::eTransferWrite
+    | vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+
+constexpr vk::ImageUsageFlags kAttachmentUsageMask = vk::ImageUsageFlagBits::eColorAttachment
+    | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+
+// Synchronization state of a resource while walking the compiled passes
+struct ResourceState {
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    // Stages and accesses of the last write, or layout transition, of the resource
+    vk::PipelineStageFlags2 writeStageMask;
+    vk::AccessFlags2 writeAccessMask;
+    // Stages reading the resource since the last write
+    vk::PipelineStageFlags2 readStageMask;
+    // Stages and accesses the last write has already been made visible to
+    vk::PipelineStageFlags2 visibleStageMask;
+    vk::AccessFlags2 visibleAccessMask;
+    bool used = false;
+};
+
+void addMemoryDependency(
+    FrameGraphBarrierBatch& batch,
+    vk::PipelineStageFlags2 srcStageMask,
+    vk::AccessFlags2 srcAccessMask,
+    vk::PipelineStageFlags2 dstStageMask,
+    vk::AccessFlags2 dstAccessMask)
+{
+    if (!batch.memoryBarrier) {
+        batch.memoryBarrier = vk::MemoryBarrier2 {};
+    }
+    batch.memoryBarrier->srcStageMask |= srcStageMask;
+    batch.memoryBarrier->srcAccessMask |= srcAccessMask;
+    batch.memoryBarrier->dstStageMask |= dstStageMask;
+    batch.memoryBarrier->dstAccessMask |= dstAccessMask;
+}
+
+} // namespace
+
+FrameGraph::PassBuilder::PassBuilder(FrameGraph& graph, FrameGraphPassId pass)
+    : graph_ { graph }
+    , pass_ { pass }
+{
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::read(
+    FrameGraphResourceId resource,
+    const ResourceAccess& access)
+{
+    graph_.addAccess(pass_, resource, access, true, false);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::write(
+    FrameGraphResourceId resource,
+    const ResourceAccess& access)
+{
+    graph_.addAccess(pass_, resource, access, false, true);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::readWrite(
+    FrameGraphResourceId resource,
+    const ResourceAccess& access)
+{
+    graph_.addAccess(pass_, resource, access, true, true);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::sideEffects()
+{
+    graph_.passes_[pass_].sideEffects = true;
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::execute(FrameGraphPassCallback callback)
+{
+    graph_.passes_[pass_].callback = std::move(callback);
+    return *this;
+}
+
+FrameGraphResourceId FrameGraph::createImage(std::string name, const FrameGraphImageInfo& info)
+{
+    resources_.push_back({
+        .name = std::move(name),
+        .kind = ResourceKind::TransientImage,
+        .imageInfo = info,
+    });
+    return static_cast<FrameGraphResourceId>(resources_.size() - 1);
+}
+
+FrameGraphResourceId FrameGraph::importImage(
+    std::string name,
+    const FrameGraphImageInfo& info,
+    const FrameGraphImportInfo& importInfo)
+{
+    resources_.push_back({
+        .name = std::move(name),
+        .kind = ResourceKind::ImportedImage,
+        .imageInfo = info,
+        .importInfo = importInfo,
+    });
+    return static_cast<FrameGraphResourceId>(resources_.size() - 1);
+}
+
+FrameGraphResourceId FrameGraph::importBuffer(
+    std::string name,
+    const FrameGraphImportInfo& importInfo)
+{
+    resources_.push_back({
+        .name = std::move(name),
+        .kind = ResourceKind::ImportedBuffer,
+        .importInfo = importInfo,
+    });
+    return static_cast<FrameGraphResourceId>(resources_.size() - 1);
+}
+
+FrameGraph::PassBuilder FrameGraph::addPass(std::string name)
+{
+    passes_.push_back({ .name = std::move(name) });
+    return PassBuilder(*this, static_cast<FrameGraphPassId>(passes_.size() - 1));
+}
+
+void FrameGraph::addAccess(
+    FrameGraphPassId pass,
+    FrameGraphResourceId resource,
+    const ResourceAccess& access,
+    bool reads,
+    bool writes)
+{
+    const Resource& declaredResource = resources_.at(resource);
+    if (declaredResource.kind != ResourceKind::ImportedBuffer
+        && access.layout == vk::ImageLayout::eUndefined) {
+        throw std::invalid_argument("Image " + declaredResource.name + " accessed without layout");
+    }
+
+    // Accesses of a pass to the same resource are merged, they must agree on the image layout
+    std::vector<PassAccess>& accesses = passes_.at(pass).accesses;
+    auto existingAccess = std::ranges::find(accesses, resource, &PassAccess::resource);
+    if (existingAccess == accesses.end()) {
+        accesses.push_back({
+            .resource = resource,
+            .access = access,
+            .reads = reads,
+            .writes = writes,
+        });
+        return;
+    }
+    if (existingAccess->access.layout != access.layout) {
+        throw std::invalid_argument(
+            "Pass " + passes_[pass].name + " uses " + declaredResource.name
+            + " in different layouts");
+    }
+    existingAccess->access.stageMask |= access.stageMask;
+    existingAccess->access.accessMask |= access.accessMask;
+    existingAccess->reads = existingAccess->reads || reads;
+    existingAccess->writes = existingAccess->writes || writes;
+}
+
+void FrameGraph::compile()
+{
+    compiledPasses_.clear();
+    finalBarriers_ = {};
+    transientLifetimes_.clear();
+
+    const std::vector<bool> livePasses = cullPasses();
+    for (FrameGraphPassId pass = 0; pass < passes_.size(); pass++) {
+        if (livePasses[pass]) {
+            compiledPasses_.push_back({ .pass = pass });
+        } else {
+            spdlog::debug("Frame graph: culled pass {}", passes_[pass].name);
+        }
+    }
+    scheduleBarriers();
+}
+
+std::vector<bool> FrameGraph::cullPasses() const
+{
+    // Walk the passes backwards, tracking the resources whose current contents are still needed.
+    // Imported resources are needed after the graph executes.
+    std::vector<bool> neededResources(resources_.size());
+    for (FrameGraphResourceId resource = 0; resource < resources_.size(); resource++) {
+        neededResources[resource] = resources_[resource].kind != ResourceKind::TransientImage;
+    }
+
+    std::vector<bool> livePasses(passes_.size());
+    for (size_t i = passes_.size(); i-- > 0;) {
+        const Pass& pass = passes_[i];
+        const bool producesNeededResource
+            = std::ranges::any_of(pass.accesses, [&](const PassAccess& passAccess) {
+                  return passAccess.writes && neededResources[passAccess.resource];
+              });
+        if (!pass.sideEffects && !producesNeededResource) {
+            continue;
+        }
+        livePasses[i] = true;
+        // Contents overwritten by the pass are not needed before it, contents it reads are
+        for (const PassAccess& passAccess : pass.accesses) {
+            if (passAccess.writes && !passAccess.reads) {
+                neededResources[passAccess.resource] = false;
+            }
+        }
+        for (const PassAccess& passAccess : pass.accesses) {
+            if (passAccess.reads) {
+                neededResources[passAccess.resource] = true;
+            }
+        }
+    }
+    return livePasses;
+}
+
+void FrameGraph::scheduleBarriers()
+{
+    std::vector<ResourceState> states(resources_.size());
+    for (FrameGraphResourceId resource = 0; resource < resources_.size(); resource++) {
+        const Resource& declaredResource = resources_[resource];
+        if (declaredResource.kind != ResourceKind::TransientImage) {
+            const ResourceAccess& initialAccess = declaredResource.importInfo.initialAccess;
+            states[resource] = {
+                .layout = initialAccess.layout,
+                .writeStageMask = initialAccess.stageMask,
+                .writeAccessMask = initialAccess.accessMask & kWriteAccessMask,
+                .used = true,
+            };
+        }
+    }
+
+    // Last use of each transient image, to find out when their memory can be reused
+    std::vector<uint32_t> lastUses(resources_.size());
+    std::vector<uint32_t> firstUses(resources_.size(), std::numeric_limits<uint32_t>::max());
+    for (uint32_t compiledIndex = 0; compiledIndex < compiledPasses_.size(); compiledIndex++) {
+        const Pass& pass = passes_[compiledPasses_[compiledIndex].pass];
+        for (const PassAccess& passAccess : pass.accesses) {
+            uint32_t& firstUse = firstUses[passAccess.resource];
+            firstUse = std::min(firstUse, compiledIndex);
+            lastUses[passAccess.resource] = compiledIndex;
+        }
+    }
+
+    // Stages and writes of the transient images no longer used, whose memory may be aliased by the
+    // transient images used for the first time
+    vk::PipelineStageFlags2 retiredStageMask;
+    vk::AccessFlags2 retiredAccessMask;
+
+    for (uint32_t compiledIndex = 0; compiledIndex < compiledPasses_.size(); compiledIndex++) {
+        FrameGraphCompiledPass& compiledPass = compiledPasses_[compiledIndex];
+        FrameGraphBarrierBatch& batch = compiledPass.barriers;
+
+        for (const PassAccess& passAccess : passes_[compiledPass.pass].accesses) {
+            const Resource& resource = resources_[passAccess.resource];
+            ResourceState& state = states[passAccess.resource];
+            const ResourceAccess& access = passAccess.access;
+            const bool isImage = resource.kind != ResourceKind::ImportedBuffer;
+            const bool layoutChanges = isImage && access.layout != state.layout;
+
+            vk::PipelineStageFlags2 srcStageMask;
+            vk::AccessFlags2 srcAccessMask;
+            if (layoutChanges || passAccess.writes) {
+                // Wait for the previous write (RAW, WAW) and the reads since then (WAR)
+                srcStageMask = state.writeStageMask | state.readStageMask;
+                srcAccessMask = state.writeAccessMask;
+                if (!state.used) {
+                    srcStageMask |= retiredStageMask;
+                    srcAccessMask |= retiredAccessMask;
+                }
+            } else if ((access.stageMask & ~state.visibleStageMask)
+                       || (access.accessMask & ~state.visibleAccessMask)) {
+                // Read of a write not yet visible to this stage or access (RAW)
+                srcStageMask = state.writeStageMask;
+                srcAccessMask = state.writeAccessMask;
+            }
+
+            if (layoutChanges) {
+                batch.imageBarriers.push_back({
+                    .image = passAccess.resource,
+                    .srcStageMask = srcStageMask,
+                    .srcAccessMask = srcAccessMask,
+                    .dstStageMask = access.stageMask,
+                    .dstAccessMask = access.accessMask,
+                    // Contents about to be overwritten do not need to be preserved
+                    .oldLayout = passAccess.reads ? state.layout : vk::ImageLayout::eUndefined,
+                    .newLayout = access.layout,
+                });
+            } else if (srcStageMask) {
+                addMemoryDependency(
+                    batch,
+                    srcStageMask,
+                    srcAccessMask,
+                    access.stageMask,
+                    access.accessMask);
+            }
+
+            if (passAccess.writes || layoutChanges) {
+                // A layout transition acts as a write at the destination stages
+                state.writeStageMask = access.stageMask;
+                state.writeAccessMask = access.accessMask & kWriteAccessMask;
+                state.readStageMask = {};
+                state.visibleStageMask = access.stageMask;
+                state.visibleAccessMask = access.accessMask;
+            } else {
+                state.visibleStageMask |= access.stageMask;
+                state.visibleAccessMask |= access.accessMask;
+            }
+            if (passAccess.reads) {
+                state.readStageMask |= access.stageMask;
+            }
+            state.layout = access.layout;
+            state.used = true;
+        }
+
+        for (const PassAccess& passAccess : passes_[compiledPass.pass].accesses) {
+            if (resources_[passAccess.resource].kind == ResourceKind::TransientImage
+                && lastUses[passAccess.resource] == compiledIndex) {
+                const ResourceState& state = states[passAccess.resource];
+                retiredStageMask |= state.writeStageMask | state.readStageMask;
+                retiredAccessMask |= state.writeAccessMask;
+            }
+        }
+    }
+
+    for (FrameGraphResourceId resource = 0; resource < resources_.size(); resource++) {
+        const Resource& declaredResource = resources_[resource];
+        const ResourceState& state = states[resource];
+        if (declaredResource.kind == ResourceKind::TransientImage) {
+            if (state.used) {
+                transientLifetimes_.push_back({
+                    .image = resource,
+                    .firstPass = firstUses[resource],
+                    .lastPass = lastUses[resource],
+                });
+            }
+            continue;
+        }
+        if (!declaredResource.importInfo.finalAccess) {
+            continue;
+        }
+        const ResourceAccess& finalAccess = *declaredResource.importInfo.finalAccess;
+        if (declaredResource.kind == ResourceKind::ImportedImage
+            && finalAccess.layout != state.layout) {
+            finalBarriers_.imageBarriers.push_back({
+                .image = resource,
+                .srcStageMask = state.writeStageMask | state.readStageMask,
+                .srcAccessMask = state.writeAccessMask,
+                .dstStageMask = finalAccess.stageMask,
+                .dstAccessMask = finalAccess.accessMask,
+                .oldLayout = state.layout,
+                .newLayout = finalAccess.layout,
+            });
+        } else if (state.writeAccessMask && finalAccess.stageMask) {
+            addMemoryDependency(
+                finalBarriers_,
+                state.writeStageMask | state.readStageMask,
+                state.writeAccessMask,
+                finalAccess.stageMask,
+                finalAccess.accessMask);
+        }
+    }
+}
+
+const std::string& FrameGraph::getPassName(FrameGraphPassId pass) const
+{
+    return passes_.at(pass).name;
+}
+
+const std::string& FrameGraph::getResourceName(FrameGraphResourceId resource) const
+{
+    return resources_.at(resource).name;
+}
+
+const FrameGraphImageInfo& FrameGraph::getImageInfo(FrameGraphResourceId image) const
+{
+    return resources_.at(image).imageInfo;
+}
+
+bool FrameGraph::isTransient(FrameGraphResourceId resource) const
+{
+    return resources_.at(resource).kind == ResourceKind::TransientImage;
+}
+
+vk::ImageUsageFlags FrameGraph::getImageUsage(FrameGraphResourceId image) const
+{
+    using enum vk::AccessFlagBits2;
+    vk::ImageUsageFlags usage;
+    for (const Pass& pass : passes_) {
+        for (const PassAccess& passAccess : pass.accesses) {
+            if (passAccess.resource != image) {
+                continue;
+            }
+            const vk::AccessFlags2 accessMask = passAccess.access.accessMask;
+            if (accessMask & (eColorAttachmentRead | eColorAttachmentWrite)) {
+                usage |= vk::ImageUsageFlagBits::eColorAttachment;
+            }
+            if (accessMask & (eDepthStencilAttachmentRead | eDepthStencilAttachmentWrite)) {
+                usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment;
+            }
+            if (accessMask & eInputAttachmentRead) {
+                usage |= vk::ImageUsageFlagBits::eInputAttachment;
+            }
+            if (accessMask & (eShaderSampledRead | eShaderRead)) {
+                usage |= vk::ImageUsageFlagBits::eSampled;
+            }
+            if (accessMask & (eShaderStorageRead | eShaderStorageWrite | eShaderWrite)) {
+                usage |= vk::ImageUsageFlagBits::eStorage;
+            }
+            if (accessMask & eTransferRead) {
+                usage |= vk::ImageUsageFlagBits::eTransferSrc;
+            }
+            if (accessMask & eTransferWrite) {
+                usage |= vk::ImageUsageFlagBits::eTransferDst;
+            }
+        }
+    }
+    return usage;
+}
+
+void FrameGraph::bindImage(FrameGraphResourceId image, vk::Image handle, vk::ImageView view)
+{
+    Resource& resource = resources_.at(image);
+    resource.image = handle;
+    resource.view = view;
+}
+
+vk::Image FrameGraph::getImage(FrameGraphResourceId image) const
+{
+    return resources_.at(image).image;
+}
+
+vk::ImageView FrameGraph::getImageView(FrameGraphResourceId image) const
+{
+    return resources_.at(image).view;
+}
+
+void FrameGraph::recordBarriers(
+    vk::CommandBuffer commandBuffer,
+    const FrameGraphBarrierBatch& batch) const
+{
+    if (batch.empty()) {
+        return;
+    }
+    std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+    imageBarriers.reserve(batch.imageBarriers.size());
+    for (const FrameGraphImageBarrier& barrier : batch.imageBarriers) {
+        const Resource& resource = resources_[barrier.image];
+        imageBarriers.push_back({
+            .srcStageMask = barrier.srcStageMask,
+            .srcAccessMask = barrier.srcAccessMask,
+            .dstStageMask = barrier.dstStageMask,
+            .dstAccessMask = barrier.dstAccessMask,
+            .oldLayout = barrier.oldLayout,
+            .newLayout = barrier.newLayout,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .image = resource.image,
+            .subresourceRange {
+                .aspectMask = resource.imageInfo.aspectMask,
+                .baseMipLevel = 0,
+                .levelCount = vk::RemainingMipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = vk::RemainingArrayLayers,
+            },
+        });
+    }
+    commandBuffer.pipelineBarrier2({
+        .memoryBarrierCount = batch.memoryBarrier ? 1u : 0u,
+        .pMemoryBarriers = batch.memoryBarrier ? &*batch.memoryBarrier : nullptr,
+        .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+        .pImageMemoryBarriers = imageBarriers.data(),
+    });
+}
+
+void FrameGraph::execute(vk::CommandBuffer commandBuffer) const
+{
+    for (const FrameGraphCompiledPass& compiledPass : compiledPasses_) {
+        recordBarriers(commandBuffer, compiledPass.barriers);
+        const Pass& pass = passes_[compiledPass.pass];
+        if (pass.callback) {
+            pass.callback(commandBuffer, *this);
+        }
+    }
+    recordBarriers(commandBuffer, finalBarriers_);
+}
+
+TransientAliasingPlan planTransientAliasing(std::span<const TransientAllocationRequest> requests)
+{
+    TransientAliasingPlan plan { .offsets = std::vector<vk::DeviceSize>(requests.size()) };
+
+    std::vector<size_t> placementOrder(requests.size());
+    std::iota(placementOrder.begin(), placementOrder.end(), 0);
+    std::ranges::stable_sort(placementOrder, std::ranges::greater {}, [&](size_t request) {
+        return requests[request].size;
+    });
+
+    struct Range {
+        vk::DeviceSize begin;
+        vk::DeviceSize end;
+    };
+    std::vector<size_t> placedRequests;
+    std::vector<Range> occupiedRanges;
+    for (size_t request : placementOrder) {
+        const TransientAllocationRequest& allocation = requests[request];
+
+        // Memory ranges used by placed requests alive at the same time
+        occupiedRanges.clear();
+        for (size_t placedRequest : placedRequests) {
+            const TransientAllocationRequest& placed = requests[placedRequest];
+            const bool lifetimesOverlap = placed.firstPass <= allocation.lastPass
+                && allocation.firstPass <= placed.lastPass;
+            if (lifetimesOverlap) {
+                occupiedRanges.push_back({
+                    plan.offsets[placedRequest],
+                    plan.offsets[placedRequest] + placed.size,
+                });
+            }
+        }
+        std::ranges::sort(occupiedRanges, {}, &Range::begin);
+
+        // First gap large enough, after aligning its start
+        const vk::DeviceSize alignment = std::max<vk::DeviceSize>(allocation.alignment, 1);
+        vk::DeviceSize offset = 0;
+        for (const Range& occupied : occupiedRanges) {
+            if (offset + allocation.size <= occupied.begin) {
+                break;
+            }
+            offset = std::max(offset, (occupied.end + alignment - 1) / alignment * alignment);
+        }
+        plan.offsets[request] = offset;
+        plan.size = std::max(plan.size, offset + allocation.size);
+        placedRequests.push_back(request);
+    }
+    return plan;
+}
+
+FrameGraphTransientImages FrameGraphTransientImages::make(
+    vk::Device device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    FrameGraph& frameGraph)
+{
+    FrameGraphTransientImages transientImages;
+
+    struct Placement {
+        size_t image;
+        vk::MemoryRequirements memoryRequirements;
+        FrameGraphLifetime lifetime;
+    };
+    // Images sharing a memory type are aliased together
+    std::map<uint32_t, std::vector<Placement>> placementsByMemoryType;
+
+    for (const FrameGraphLifetime& lifetime : frameGraph.transientLifetimes()) {
+        const FrameGraphImageInfo& info = frameGraph.getImageInfo(lifetime.image);
+        vk::ImageUsageFlags usage = frameGraph.getImageUsage(lifetime.image);
+        // Attachments living within a single pass are never loaded nor stored, their contents can
+        // stay in tile memory and their backing memory be lazily allocated
+        const bool isTransientAttachment
+            = !(usage & ~kAttachmentUsageMask) && lifetime.firstPass == lifetime.lastPass;
+        if (isTransientAttachment) {
+            usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+        }
+        vk::UniqueImage image = device.createImageUnique({
+            .imageType = vk::ImageType::e2D,
+            .format = info.format,
+            .extent { .width = info.extent.width, .height = info.extent.height, .depth = 1 },
+            .mipLevels = info.mipLevels,
+            .arrayLayers = 1,
+            .samples = info.samples,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = usage,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        });
+        const vk::MemoryRequirements memoryRequirements
+            = device.getImageMemoryRequirements(*image);
+        std::optional<uint32_t> memoryTypeIndex = findMemoryTypeIndex(
+            memoryProperties,
+            memoryRequirements.memoryTypeBits,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            isTransientAttachment
+                ? vk::MemoryPropertyFlags { vk::MemoryPropertyFlagBits::eLazilyAllocated }
+                : vk::MemoryPropertyFlags {});
+        if (!memoryTypeIndex) {
+            throw std::runtime_error(
+                "No memory type for transient image "
+                + frameGraph.getResourceName(lifetime.image));
+        }
+        placementsByMemoryType[*memoryTypeIndex].push_back({
+            .image = transientImages.images.size(),
+            .memoryRequirements = memoryRequirements,
+            .lifetime = lifetime,
+        });
+        transientImages.unaliasedSize += memoryRequirements.size;
+        transientImages.images.push_back(std::move(image));
+    }
+
+    for (const auto& [memoryTypeIndex, placements] : placementsByMemoryType) {
+        std::vector<TransientAllocationRequest> requests;
+        for (const Placement& placement : placements) {
+            requests.push_back({
+                .size = placement.memoryRequirements.size,
+                .alignment = placement.memoryRequirements.alignment,
+                .firstPass = placement.lifetime.firstPass,
+                .lastPass = placement.lifetime.lastPass,
+            });
+        }
+        const TransientAliasingPlan plan = planTransientAliasing(requests);
+
+        vk::UniqueDeviceMemory memory = device.allocateMemoryUnique({
+            .allocationSize = plan.size,
+            .memoryTypeIndex = memoryTypeIndex,
+        });
+        for (size_t i = 0; i < placements.size(); i++) {
+            device.bindImageMemory(
+                *transientImages.images[placements[i].image],
+                *memory,
+                plan.offsets[i]);
+        }
+        transientImages.allocatedSize += plan.size;
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags
+            & vk::MemoryPropertyFlagBits::eLazilyAllocated) {
+            transientImages.lazilyAllocatedSize += plan.size;
+            transientImages.lazilyAllocatedImageCount += static_cast<uint32_t>(placements.size());
+        }
+        transientImages.memories.push_back(std::move(memory));
+    }
+
+    const std::span<const FrameGraphLifetime> lifetimes = frameGraph.transientLifetimes();
+    for (size_t i = 0; i < lifetimes.size(); i++) {
+        const FrameGraphImageInfo& info = frameGraph.getImageInfo(lifetimes[i].image);
+        vk::UniqueImageView view = device.createImageViewUnique({
+            .image = *transientImages.images[i],
+            .viewType = vk::ImageViewType::e2D,
+            .format = info.format,
+            .subresourceRange {
+                .aspectMask = info.aspectMask,
+                .baseMipLevel = 0,
+                .levelCount = info.mipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        });
+        frameGraph.bindImage(lifetimes[i].image, *transientImages.images[i], *view);
+        transientImages.views.push_back(std::move(view));
+    }
+
+    constexpr double MiB = 1024.0 * 1024.0;
+    spdlog::info(
+        "Frame graph: {} transient images in {:.2f} MiB instead of {:.2f} MiB, {:.2f} MiB saved by "
+        "aliasing, {} images in {:.2f} MiB of lazily allocated memory",
+        transientImages.images.size(),
+        static_cast<double>(transientImages.allocatedSize) / MiB,
+        static_cast<double>(transientImages.unaliasedSize) / MiB,
+        static_cast<double>(transientImages.unaliasedSize - transientImages.allocatedSize) / MiB,
+        transientImages.lazilyAllocatedImageCount,
+        static_cast<double>(transientImages.lazilyAllocatedSize) / MiB);
+    return transientImages;
+}
+
+} // namespace vki
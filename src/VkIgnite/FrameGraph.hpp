@@ -0,0 +1,320 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vki {
+
+using FrameGraphResourceId = uint32_t;
+using FrameGraphPassId = uint32_t;
+
+// How a pass accesses a resource: the pipeline stages and memory accesses involved and, for
+// images, the layout the image must be in
+struct ResourceAccess {
+    vk::PipelineStageFlags2 stageMask = {};
+    vk::AccessFlags2 accessMask = {};
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+};
+
+// Common resource accesses
+namespace access {
+
+inline constexpr ResourceAccess ColorAttachment {
+    .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+    .accessMask = vk::AccessFlagBits2::eColorAttachmentRead
+        | vk::AccessFlagBits2::eColorAttachmentWrite,
+    .layout = vk::ImageLayout::eColorAttachmentOptimal,
+};
+inline constexpr ResourceAccess DepthStencilAttachment {
+    .stageMask = vk::PipelineStageFlagBits2::eEarlyFragmentTests
+        | vk::PipelineStageFlagBits2::eLateFragmentTests,
+    .accessMask = vk::AccessFlagBits2::eDepthStencilAttachmentRead
+        | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+    .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+};
+inline constexpr ResourceAccess DepthStencilReadOnly {
+    .stageMask = vk::PipelineStageFlagBits2::eEarlyFragmentTests
+        | vk::PipelineStageFlagBits2::eLateFragmentTests,
+    .accessMask = vk::AccessFlagBits2::eDepthStencilAttachmentRead,
+    .layout = vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+};
+inline constexpr ResourceAccess FragmentShaderSampled {
+    .stageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+    .accessMask = vk::AccessFlagBits2::eShaderSampledRead,
+    .layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+};
+inline constexpr ResourceAccess ComputeShaderSampled {
+    .stageMask = vk::PipelineStageFlagBits2::eComputeShader,
+    .accessMask = vk::AccessFlagBits2::eShaderSampledRead,
+    .layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+};
+inline constexpr ResourceAccess ComputeShaderStorageRead {
+    .stageMask = vk::PipelineStageFlagBits2::eComputeShader,
+    .accessMask = vk::AccessFlagBits2::eShaderStorageRead,
+    .layout = vk::ImageLayout::eGeneral,
+};
+inline constexpr ResourceAccess ComputeShaderStorageWrite {
+    .stageMask = vk::PipelineStageFlagBits2::eComputeShader,
+    .accessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+    .layout = vk::ImageLayout::eGeneral,
+};
+inline constexpr ResourceAccess TransferRead {
+    .stageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+    .accessMask = vk::AccessFlagBits2::eTransferRead,
+    .layout = vk::ImageLayout::eTransferSrcOptimal,
+};
+inline constexpr ResourceAccess TransferWrite {
+    .stageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+    .accessMask = vk::AccessFlagBits2::eTransferWrite,
+    .layout = vk::ImageLayout::eTransferDstOptimal,
+};
+inline constexpr ResourceAccess IndirectCommandRead {
+    .stageMask = vk::PipelineStageFlagBits2::eDrawIndirect,
+    .accessMask = vk::AccessFlagBits2::eIndirectCommandRead,
+};
+// Swapchain image acquired through a semaphore waited at the color attachment output stage
+inline constexpr ResourceAccess Acquire {
+    .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+    .layout = vk::ImageLayout::eUndefined,
+};
+inline constexpr ResourceAccess Present {
+    .layout = vk::ImageLayout::ePresentSrcKHR,
+};
+
+} // namespace access
+
+struct FrameGraphImageInfo {
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent = {};
+    uint32_t mipLevels = 1;
+    vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+    vk::ImageAspectFlags aspectMask = vk::ImageAspectFlagBits::eColor;
+};
+
+struct FrameGraphImportInfo {
+    // Last access to the resource before the graph executes
+    ResourceAccess initialAccess = {};
+    // Access the resource must be ready for once the graph has executed, if any
+    std::optional<ResourceAccess> finalAccess = {};
+};
+
+// Barrier on an image of the graph, referenced by its resource identifier
+struct FrameGraphImageBarrier {
+    FrameGraphResourceId image;
+    vk::PipelineStageFlags2 srcStageMask;
+    vk::AccessFlags2 srcAccessMask;
+    vk::PipelineStageFlags2 dstStageMask;
+    vk::AccessFlags2 dstAccessMask;
+    vk::ImageLayout oldLayout;
+    vk::ImageLayout newLayout;
+
+    bool operator==(const FrameGraphImageBarrier&) const = default;
+};
+
+// Barriers recorded with a single pipelineBarrier2 call. Dependencies without layout transition,
+// including all buffer ones, are merged into one global memory barrier.
+struct FrameGraphBarrierBatch {
+    std::vector<FrameGraphImageBarrier> imageBarriers;
+    std::optional<vk::MemoryBarrier2> memoryBarrier;
+
+    [[nodiscard]] bool empty() const
+    {
+        return imageBarriers.empty() && !memoryBarrier.has_value();
+    }
+};
+
+struct FrameGraphCompiledPass {
+    FrameGraphPassId pass;
+    // Barriers to record before the pass
+    FrameGraphBarrierBatch barriers;
+};
+
+// Range of compiled passes, as indices in FrameGraph::compiledPasses(), using a transient image
+struct FrameGraphLifetime {
+    FrameGraphResourceId image;
+    uint32_t firstPass;
+    uint32_t lastPass;
+};
+
+class FrameGraph;
+
+using FrameGraphPassCallback = std::function<void(vk::CommandBuffer, const FrameGraph&)>;
+
+// Frame graph scheduling the synchronization between passes.
+//
+// Passes are declared in execution order along with the resources they read and write. Compiling
+// the graph culls the passes whose outputs are never used, computes the minimal set of
+// synchronization2 barriers and image layout transitions between the remaining passes, batched
+// per pass, and the lifetime of the transient images so that non overlapping ones can share
+// memory. Compilation only produces plain data, so the scheduling can be inspected without a
+// device. Executing the graph requires the synchronization2 feature.
+//
+// Transient images are created by the graph. Imported resources, such as the swapchain images,
+// are owned by the caller and are always considered used after the graph executes.
+class FrameGraph {
+public:
+    class PassBuilder {
+    public:
+        // The pass reads the current contents of the resource
+        PassBuilder& read(FrameGraphResourceId resource, const ResourceAccess& access);
+        // The pass overwrites the resource, its previous contents are discarded
+        PassBuilder& write(FrameGraphResourceId resource, const ResourceAccess& access);
+        // The pass reads and updates the resource
+        PassBuilder& readWrite(FrameGraphResourceId resource, const ResourceAccess& access);
+        // The pass has effects outside of the graph and must never be culled
+        PassBuilder& sideEffects();
+        PassBuilder& execute(FrameGraphPassCallback callback);
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph& graph, FrameGraphPassId pass);
+
+        FrameGraph& graph_;
+        FrameGraphPassId pass_;
+    };
+
+    [[nodiscard]] FrameGraphResourceId createImage(
+        std::string name,
+        const FrameGraphImageInfo& info);
+    [[nodiscard]] FrameGraphResourceId importImage(
+        std::string name,
+        const FrameGraphImageInfo& info,
+        const FrameGraphImportInfo& importInfo);
+    [[nodiscard]] FrameGraphResourceId importBuffer(
+        std::string name,
+        const FrameGraphImportInfo& importInfo);
+
+    PassBuilder addPass(std::string name);
+
+    // Cull the unused passes and schedule the barriers
+    void compile();
+
+    [[nodiscard]] std::span<const FrameGraphCompiledPass> compiledPasses() const
+    {
+        return compiledPasses_;
+    }
+
+    // Barriers bringing the imported resources to their final access, recorded after the passes
+    [[nodiscard]] const FrameGraphBarrierBatch& finalBarriers() const
+    {
+        return finalBarriers_;
+    }
+
+    [[nodiscard]] std::span<const FrameGraphLifetime> transientLifetimes() const
+    {
+        return transientLifetimes_;
+    }
+
+    [[nodiscard]] const std::string& getPassName(FrameGraphPassId pass) const;
+    [[nodiscard]] const std::string& getResourceName(FrameGraphResourceId resource) const;
+    [[nodiscard]] const FrameGraphImageInfo& getImageInfo(FrameGraphResourceId image) const;
+    [[nodiscard]] bool isTransient(FrameGraphResourceId resource) const;
+
+    // Image usage flags required by the accesses declared on an image
+    [[nodiscard]] vk::ImageUsageFlags getImageUsage(FrameGraphResourceId image) const;
+
+    // Set the handles of a transient or imported image, used when executing the graph
+    void bindImage(FrameGraphResourceId image, vk::Image handle, vk::ImageView view);
+
+    [[nodiscard]] vk::Image getImage(FrameGraphResourceId image) const;
+    [[nodiscard]] vk::ImageView getImageView(FrameGraphResourceId image) const;
+
+    // Record the compiled passes along with their barriers
+    void execute(vk::CommandBuffer commandBuffer) const;
+
+private:
+    enum class ResourceKind {
+        TransientImage,
+        ImportedImage,
+        ImportedBuffer,
+    };
+
+    struct Resource {
+        std::string name;
+        ResourceKind kind;
+        FrameGraphImageInfo imageInfo;
+        FrameGraphImportInfo importInfo;
+        vk::Image image;
+        vk::ImageView view;
+    };
+
+    struct PassAccess {
+        FrameGraphResourceId resource;
+        ResourceAccess access;
+        bool reads;
+        bool writes;
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<PassAccess> accesses;
+        bool sideEffects = false;
+        FrameGraphPassCallback callback;
+    };
+
+    void addAccess(
+        FrameGraphPassId pass,
+        FrameGraphResourceId resource,
+        const ResourceAccess& access,
+        bool reads,
+        bool writes);
+    [[nodiscard]] std::vector<bool> cullPasses() const;
+    void scheduleBarriers();
+    void recordBarriers(vk::CommandBuffer commandBuffer, const FrameGraphBarrierBatch& batch) const;
+
+    std::vector<Resource> resources_;
+    std::vector<Pass> passes_;
+    std::vector<FrameGraphCompiledPass> compiledPasses_;
+    FrameGraphBarrierBatch finalBarriers_;
+    std::vector<FrameGraphLifetime> transientLifetimes_;
+};
+
+struct TransientAllocationRequest {
+    vk::DeviceSize size;
+    vk::DeviceSize alignment;
+    uint32_t firstPass;
+    uint32_t lastPass;
+};
+
+struct TransientAliasingPlan {
+    // Offset of each request in the shared allocation
+    std::vector<vk::DeviceSize> offsets;
+    vk::DeviceSize size = 0;
+};
+
+// Place the requests in a single allocation, so that requests whose pass ranges do not overlap can
+// share memory. Largest requests are placed first, each at the lowest offset free during its
+// lifetime.
+[[nodiscard]] TransientAliasingPlan planTransientAliasing(
+    std::span<const TransientAllocationRequest> requests);
+
+// Images and memory backing the transient images of a compiled frame graph. Images of the same
+// memory type share an allocation, aliasing the ones with non overlapping lifetimes. Images only
+// used as attachments within a single pass are created as transient attachments, backed by lazily
+// allocated memory when the device provides it.
+class FrameGraphTransientImages {
+public:
+    // Create the transient images and bind them to the graph
+    [[nodiscard]] static FrameGraphTransientImages make(
+        vk::Device device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        FrameGraph& frameGraph);
+
+    std::vector<vk::UniqueImage> images;
+    std::vector<vk::UniqueImageView> views;
+    std::vector<vk::UniqueDeviceMemory> memories;
+    // Memory allocated for the images, and the memory they would require without aliasing
+    vk::DeviceSize allocatedSize = 0;
+    vk::DeviceSize unaliasedSize = 0;
+    // Part of the allocated memory that is lazily allocated, possibly never committed
+    vk::DeviceSize lazilyAllocatedSize = 0;
+    uint32_t lazilyAllocatedImageCount = 0;
+};
+
+} // namespace vki
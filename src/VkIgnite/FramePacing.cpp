@@ -0,0 +1,164 @@
+#include "FramePacing.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace vki {
+
+std::string_view getPresentPolicyName(PresentPolicy policy)
+{
+    switch (policy) {
+    case PresentPolicy::LowLatency:
+        return "low latency";
+    case PresentPolicy::PowerSaving:
+        return "power saving";
+    case PresentPolicy::Throughput:
+        return "throughput";
+    }
+    return "unknown";
+}
+
+[[nodiscard]] static std::span<const vk::PresentModeKHR> getPreferredPresentModes(
+    PresentPolicy policy)
+{
+    static constexpr vk::PresentModeKHR kLowLatencyPresentModes[] = {
+        vk::PresentModeKHR::eMailbox,
+        vk::PresentModeKHR::eImmediate,
+    };
+    static constexpr vk::PresentModeKHR kThroughputPresentModes[] = {
+        vk::PresentModeKHR::eImmediate,
+        vk::PresentModeKHR::eMailbox,
+        vk::PresentModeKHR::eFifoRelaxed,
+    };
+    switch (policy) {
+    case PresentPolicy::LowLatency:
+        return kLowLatencyPresentModes;
+    case PresentPolicy::PowerSaving:
+        return {};
+    case PresentPolicy::Throughput:
+        return kThroughputPresentModes;
+    }
+    return {};
+}
+
+vk::PresentModeKHR choosePresentMode(
+    PresentPolicy policy,
+    std::span<const vk::PresentModeKHR> availablePresentModes)
+{
+    for (vk::PresentModeKHR presentMode : getPreferredPresentModes(policy)) {
+        if (std::ranges::find(availablePresentModes, presentMode) != availablePresentModes.end()) {
+            return presentMode;
+        }
+    }
+    // Fifo is guaranteed to be available
+    return vk::PresentModeKHR::eFifo;
+}
+
+uint32_t chooseImageCount(
+    PresentPolicy policy,
+    vk::PresentModeKHR presentMode,
+    const vk::SurfaceCapabilitiesKHR& capabilities)
+{
+    uint32_t imageCount = capabilities.minImageCount;
+    switch (policy) {
+    case PresentPolicy::LowLatency:
+        // Mailbox needs an image being displayed, one queued and one being rendered to
+        if (presentMode == vk::PresentModeKHR::eMailbox) {
+            imageCount = std::max(imageCount, 3u);
+        }
+        break;
+    case PresentPolicy::PowerSaving:
+        break;
+    case PresentPolicy::Throughput:
+        imageCount++;
+        break;
+    }
+    // Ensure the maximum number of image supported by the driver is not exceeded
+    if (capabilities.maxImageCount > 0) {
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    }
+    spdlog::info(
+        "Present policy {}: {} with {} images",
+        getPresentPolicyName(policy),
+        vk::to_string(presentMode),
+        imageCount);
+    return imageCount;
+}
+
+FramePacer::FramePacer(std::chrono::nanoseconds targetFrameDuration)
+    : targetFrameDuration_ { targetFrameDuration }
+{
+}
+
+FramePacer::Clock::time_point FramePacer::waitForNextFrame()
+{
+    if (lastFrameStart_.has_value() && targetFrameDuration_ > std::chrono::nanoseconds::zero()) {
+        Clock::time_point wakeUpTime = *lastFrameStart_ + targetFrameDuration_;
+        if (lastCompletion_.has_value()) {
+            // Complete one target duration after each frame still in flight
+            const Clock::time_point targetCompletion = *lastCompletion_
+                + targetFrameDuration_ * (framesInFlight_ + 1);
+            wakeUpTime = targetCompletion - cpuTime_ - gpuTime_;
+        }
+        std::this_thread::sleep_until(wakeUpTime);
+    }
+    lastFrameStart_ = Clock::now();
+    return *lastFrameStart_;
+}
+
+// Exponential moving average, smoothing the frame to frame noise of the measured times
+static void updateEstimate(std::chrono::nanoseconds& estimate, std::chrono::nanoseconds sample)
+{
+    constexpr int kSmoothingFactor = 8;
+    estimate = estimate == std::chrono::nanoseconds::zero()
+        ? sample
+        : estimate + (sample - estimate) / kSmoothingFactor;
+}
+
+void FramePacer::onFrameSubmitted(Clock::time_point frameStart, Clock::time_point submission)
+{
+    framesInFlight_++;
+    updateEstimate(
+        cpuTime_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(submission - frameStart));
+}
+
+void FramePacer::onFrameCompleted(
+    Clock::time_point frameStart,
+    Clock::time_point submission,
+    Clock::time_point completion)
+{
+    if (framesInFlight_ > 0) {
+        framesInFlight_--;
+    }
+    // The GPU starts the frame once submitted and done with the previous one
+    const Clock::time_point gpuStart = lastCompletion_.has_value()
+        ? std::max(submission, *lastCompletion_)
+        : submission;
+    updateEstimate(
+        gpuTime_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::max(completion - gpuStart, Clock::duration::zero())));
+    lastCompletion_ = completion;
+
+    const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        completion - frameStart);
+    stats_.frameCount++;
+    stats_.maxLatency = std::max(stats_.maxLatency, latency);
+    totalLatency_ += latency;
+}
+
+FramePacerStats FramePacer::takeStats()
+{
+    FramePacerStats stats = stats_;
+    if (stats.frameCount > 0) {
+        stats.averageLatency = totalLatency_ / stats.frameCount;
+    }
+    stats_ = {};
+    totalLatency_ = {};
+    return stats;
+}
+
+} // namespace vki
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace vki {
+
+enum class PresentPolicy {
+    // Mailbox, else Immediate which may tear, else FIFO, with as few images as possible
+    LowLatency,
+    // FIFO, so that both the CPU and the GPU idle while waiting for the vertical blank
+    PowerSaving,
+    // Immediate, else Mailbox, else FIFO relaxed, else FIFO, with a spare image so that the GPU
+    // never waits for the presentation engine
+    Throughput,
+};
+
+[[nodiscard]] std::string_view getPresentPolicyName(PresentPolicy policy);
+
+[[nodiscard]] vk::PresentModeKHR choosePresentMode(
+    PresentPolicy policy,
+    std::span<const vk::PresentModeKHR> availablePresentModes);
+
+[[nodiscard]] uint32_t chooseImageCount(
+    PresentPolicy policy,
+    vk::PresentModeKHR presentMode,
+    const vk::SurfaceCapabilitiesKHR& capabilities);
+
+// Frame statistics gathered by a FramePacer
+struct FramePacerStats {
+    uint32_t frameCount = 0;
+    // Time from the start of a frame, when it samples its input, to the GPU completing it. The
+    // completion is observed through the frame fence, so this is an upper bound.
+    std::chrono::nanoseconds averageLatency = {};
+    std::chrono::nanoseconds maxLatency = {};
+};
+
+// CPU side frame limiter and latency meter.
+//
+// Frames are scheduled from the observed GPU completions: a new frame starts so that, given the
+// CPU and GPU times measured for the previous frames, it completes one target duration after the
+// frames already in flight. Frames therefore do not queue up behind a busy GPU, and a late frame
+// is not followed by a burst of frames catching up. Waiting for the frame fence before sleeping,
+// and sampling the input after, keeps the input as fresh as possible instead of sampling it and
+// then blocking in acquireNextImageKHR.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A null target duration disables the limiter, only measuring the latency
+    explicit FramePacer(std::chrono::nanoseconds targetFrameDuration = {});
+
+    // Sleep until the next frame should start and return its start time
+    Clock::time_point waitForNextFrame();
+
+    // Report the submission of a frame started at frameStart
+    void onFrameSubmitted(Clock::time_point frameStart, Clock::time_point submission);
+
+    // Report the GPU completion of a submitted frame
+    void onFrameCompleted(
+        Clock::time_point frameStart,
+        Clock::time_point submission,
+        Clock::time_point completion);
+
+    // Statistics of the frames completed since the previous call
+    [[nodiscard]] FramePacerStats takeStats();
+
+private:
+    std::chrono::nanoseconds targetFrameDuration_;
+    std::optional<Clock::time_point> lastFrameStart_;
+    std::optional<Clock::time_point> lastCompletion_;
+    uint32_t framesInFlight_ = 0;
+    // Smoothed time from a frame start to its submission, and GPU time of a frame. The GPU time
+    // runs from the later of the submission and the previous completion to the completion.
+    std::chrono::nanoseconds cpuTime_ = {};
+    std::chrono::nanoseconds gpuTime_ = {};
+    FramePacerStats stats_;
+    std::chrono::nanoseconds totalLatency_ = {};
+};
+
+} // namespace vki
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Pch/Glm.hpp"
+
+#include <array>
+
+namespace vki {
+
+// View frustum as 6 planes (a, b, c, d) whose normals point inside, so that a point p is inside the
+// frustum if dot(plane.xyz, p) + plane.w >= 0 for every plane
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    // Extract the frustum planes from a view-projection matrix using Vulkan clip space conventions
+    // (depth in [0, 1]). Refer to "Fast Extraction of Viewing Frustum Planes from the
+    // World-View-Projection Matrix" from G. Gribb and K. Hartmann.
+    [[nodiscard]] static Frustum fromViewProjection(const glm::mat4& viewProjection)
+    {
+        const glm::mat4 m = glm::transpose(viewProjection);
+        Frustum frustum {
+            .planes = {
+                m[3] + m[0], // Left
+                m[3] - m[0], // Right
+                m[3] + m[1], // Bottom
+                m[3] - m[1], // Top
+                m[2], // Near
+                m[3] - m[2], // Far
+            },
+        };
+        for (glm::vec4& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    [[nodiscard]] bool intersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (const glm::vec4& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace vki
@@ -0,0 +1,306 @@
+#include "GpuCulling.hpp"
+#include "Commands.hpp"
+#include "Pipeline.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace vki {
+
+constexpr uint32_t kCullingWorkGroupSize = 64;
+
+constexpr const char kCullingShaderSource[] = R"computeShader(
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct CullObject {
+    vec4 boundingSphere;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint padding;
+};
+
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    CullObject objects[];
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer DrawCommands {
+    DrawCommand drawCommands[];
+};
+
+layout(std430, set = 0, binding = 2) buffer DrawCount {
+    uint drawCount;
+};
+
+layout(push_constant) uniform Culling {
+    vec4 frustumPlanes[6];
+    uint objectCount;
+} culling;
+
+void main() {
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if (objectIndex >= culling.objectCount) {
+        return;
+    }
+
+    CullObject object = objects[objectIndex];
+    vec3 center = object.boundingSphere.xyz;
+    float radius = object.boundingSphere.w;
+    for (int i = 0; i < 6; i++) {
+        if (dot(culling.frustumPlanes[i].xyz, center) + culling.frustumPlanes[i].w < -radius) {
+            return;
+        }
+    }
+
+    uint drawIndex = atomicAdd(drawCount, 1);
+    drawCommands[drawIndex] = DrawCommand(
+        object.indexCount, 1, object.firstIndex, object.vertexOffset, objectIndex);
+}
+)computeShader";
+
+GpuCulling::GpuCulling(const GpuCullingCreateInfo& gpuCullingCreateInfo)
+    : memoryProperties_ { gpuCullingCreateInfo.physicalDevice.getMemoryProperties() }
+    , device_ { gpuCullingCreateInfo.device }
+    , queue_ { gpuCullingCreateInfo.queue }
+    , queueFamilyIndex_ { gpuCullingCreateInfo.queueFamilyIndex }
+    , asyncCompute_ { gpuCullingCreateInfo.asyncCompute }
+    , maxObjectCount_ { gpuCullingCreateInfo.maxObjectCount }
+{
+    const std::span<const QueueFamilyIndex> sharingQueueFamilies = asyncCompute_ != nullptr
+        ? asyncCompute_->getSharingQueueFamilies()
+        : std::span<const QueueFamilyIndex> {};
+
+    using enum vk::BufferUsageFlagBits;
+    objects_ = Buffer::make(
+        device_,
+        memoryProperties_,
+        {
+            .size = sizeof(GpuCullObject) * maxObjectCount_,
+            .usage = eStorageBuffer | eTransferDst,
+            .memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+            .queueFamilyIndices = sharingQueueFamilies,
+        });
+
+    std::array<vk::DescriptorSetLayoutBinding, 3> bindings;
+    for (uint32_t binding = 0; binding < bindings.size(); binding++) {
+        bindings[binding] = {
+            .binding = binding,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        };
+    }
+    descriptorSetLayout_ = device_.createDescriptorSetLayoutUnique({
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    });
+
+    vk::DescriptorPoolSize poolSize {
+        .type = vk::DescriptorType::eStorageBuffer,
+        .descriptorCount
+        = static_cast<uint32_t>(bindings.size()) * gpuCullingCreateInfo.framesInFlight,
+    };
+    descriptorPool_ = device_.createDescriptorPoolUnique({
+        .maxSets = gpuCullingCreateInfo.framesInFlight,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    });
+
+    vk::PushConstantRange pushConstantRange {
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    pipelineLayout_ = device_.createPipelineLayoutUnique({
+        .setLayoutCount = 1,
+        .pSetLayouts = &*descriptorSetLayout_,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    });
+
+    pipeline_ = makeComputePipelineUnique(
+        device_,
+        {
+            .sourceText = kCullingShaderSource,
+            .inputIdentifier = "culling compute shader",
+            .layout = *pipelineLayout_,
+        });
+
+    std::vector<vk::DescriptorSetLayout> setLayouts(
+        gpuCullingCreateInfo.framesInFlight,
+        *descriptorSetLayout_);
+    std::vector<vk::DescriptorSet> descriptorSets = device_.allocateDescriptorSets({
+        .descriptorPool = *descriptorPool_,
+        .descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+    });
+
+    for (vk::DescriptorSet descriptorSet : descriptorSets) {
+        FrameResources frame {
+            .drawCommands = Buffer::make(
+                device_,
+                memoryProperties_,
+                {
+                    .size = sizeof(vk::DrawIndexedIndirectCommand) * maxObjectCount_,
+                    .usage = eStorageBuffer | eIndirectBuffer,
+                    .memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+                    .queueFamilyIndices = sharingQueueFamilies,
+                }),
+            .drawCount = Buffer::make(
+                device_,
+                memoryProperties_,
+                {
+                    .size = sizeof(uint32_t),
+                    .usage = eStorageBuffer | eIndirectBuffer | eTransferDst,
+                    .memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+                    .queueFamilyIndices = sharingQueueFamilies,
+                }),
+            .descriptorSet = descriptorSet,
+        };
+
+        std::array<vk::DescriptorBufferInfo, 3> bufferInfos {
+            vk::DescriptorBufferInfo { *objects_.handle, 0, vk::WholeSize },
+            vk::DescriptorBufferInfo { *frame.drawCommands.handle, 0, vk::WholeSize },
+            vk::DescriptorBufferInfo { *frame.drawCount.handle, 0, vk::WholeSize },
+        };
+        std::array<vk::WriteDescriptorSet, 3> writes;
+        for (uint32_t binding = 0; binding < writes.size(); binding++) {
+            writes[binding] = {
+                .dstSet = descriptorSet,
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo = &bufferInfos[binding],
+            };
+        }
+        device_.updateDescriptorSets(writes, {});
+
+        frames_.push_back(std::move(frame));
+    }
+}
+
+void GpuCulling::setObjects(std::span<const GpuCullObject> objects)
+{
+    if (objects.size() > maxObjectCount_) {
+        throw std::runtime_error("Too many objects to cull");
+    }
+    objectCount_ = static_cast<uint32_t>(objects.size());
+    if (objects.empty()) {
+        return;
+    }
+
+    using enum vk::MemoryPropertyFlagBits;
+    Buffer stagingBuffer = Buffer::make(
+        device_,
+        memoryProperties_,
+        {
+            .size = objects.size_bytes(),
+            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+            .memoryProperties = eHostVisible | eHostCoherent,
+        });
+    void* stagingData = device_.mapMemory(*stagingBuffer.memory, 0, objects.size_bytes());
+    std::memcpy(stagingData, objects.data(), objects.size_bytes());
+    device_.unmapMemory(*stagingBuffer.memory);
+
+    submitImmediate(device_, queue_, queueFamilyIndex_, [&](vk::CommandBuffer commandBuffer) {
+        commandBuffer.copyBuffer(
+            *stagingBuffer.handle,
+            *objects_.handle,
+            { vk::BufferCopy { .srcOffset = 0, .dstOffset = 0, .size = objects.size_bytes() } });
+    });
+}
+
+void GpuCulling::recordCulling(
+    vk::CommandBuffer commandBuffer,
+    uint32_t frameIndex,
+    const Frustum& frustum) const
+{
+    const FrameResources& frame = frames_[frameIndex];
+
+    using Stage = vk::PipelineStageFlagBits;
+    using enum vk::AccessFlagBits;
+
+    commandBuffer.fillBuffer(*frame.drawCount.handle, 0, sizeof(uint32_t), 0);
+    commandBuffer.pipelineBarrier(
+        Stage::eTransfer,
+        Stage::eComputeShader,
+        {},
+        { vk::MemoryBarrier {
+            .srcAccessMask = eTransferWrite,
+            .dstAccessMask = eShaderRead | eShaderWrite,
+        } },
+        {},
+        {});
+
+    PushConstants pushConstants {
+        .frustumPlanes = frustum.planes,
+        .objectCount = objectCount_,
+    };
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline_);
+    commandBuffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute,
+        *pipelineLayout_,
+        0,
+        { frame.descriptorSet },
+        {});
+    commandBuffer.pushConstants(
+        *pipelineLayout_,
+        vk::ShaderStageFlagBits::eCompute,
+        0,
+        sizeof(PushConstants),
+        &pushConstants);
+    commandBuffer.dispatch(
+        (objectCount_ + kCullingWorkGroupSize - 1) / kCullingWorkGroupSize,
+        1,
+        1);
+
+    // Make the generated draws visible to the indirect draw
+    commandBuffer.pipelineBarrier(
+        Stage::eComputeShader,
+        Stage::eDrawIndirect,
+        {},
+        { vk::MemoryBarrier {
+            .srcAccessMask = eShaderWrite,
+            .dstAccessMask = eIndirectCommandRead,
+        } },
+        {},
+        {});
+}
+
+[[nodiscard]] TimelineWait GpuCulling::submitCulling(
+    uint32_t frameIndex,
+    const Frustum& frustum) const
+{
+    if (asyncCompute_ == nullptr) {
+        throw std::runtime_error("GpuCulling was created without async compute");
+    }
+    const vk::CommandBuffer commandBuffer = asyncCompute_->begin(frameIndex);
+    recordCulling(commandBuffer, frameIndex, frustum);
+    const uint64_t value = asyncCompute_->submit(frameIndex);
+    return asyncCompute_->makeWait(value, vk::PipelineStageFlagBits::eDrawIndirect);
+}
+
+void GpuCulling::recordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+    const FrameResources& frame = frames_[frameIndex];
+    commandBuffer.drawIndexedIndirectCount(
+        *frame.drawCommands.handle,
+        0,
+        *frame.drawCount.handle,
+        0,
+        objectCount_,
+        sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+} // namespace vki
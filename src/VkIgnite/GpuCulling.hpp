@@ -0,0 +1,105 @@
+#pragma once
+
+#include "AsyncCompute.hpp"
+#include "Frustum.hpp"
+#include "Memory.hpp"
+#include "Types.hpp"
+
+#include "Pch/Glm.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <array>
+#include <span>
+#include <vector>
+
+namespace vki {
+
+// Object as read by the culling shader (std430 layout): a world space bounding sphere and the
+// indexed draw to issue when it is visible
+struct GpuCullObject {
+    // xyz: center, w: radius
+    glm::vec4 boundingSphere;
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t padding = 0;
+};
+static_assert(sizeof(GpuCullObject) == 32, "GpuCullObject must match the shader layout");
+
+struct GpuCullingCreateInfo {
+    vk::PhysicalDevice physicalDevice;
+    vk::Device device;
+    // Queue used to upload the objects
+    vk::Queue queue;
+    QueueFamilyIndex queueFamilyIndex;
+    uint32_t maxObjectCount;
+    uint32_t framesInFlight;
+    // When set, the culling can be submitted to this async compute queue with submitCulling().
+    // The buffers are then shared concurrently between its family and the graphics one, so that
+    // no queue family ownership transfer is needed.
+    AsyncCompute* asyncCompute = nullptr;
+};
+
+// GPU-driven frustum culling generating the draw calls of the visible objects.
+//
+// The objects are uploaded once, then each frame a compute shader tests their bounding spheres
+// against the frustum and appends a VkDrawIndexedIndirectCommand per visible object, along with
+// the number of draws. The graphics pass consumes them with a single drawIndexedIndirectCount, so
+// the CPU cost no longer depends on the number of objects.
+//
+// The index of the object is passed as firstInstance, so vertex shaders can fetch per object data
+// with gl_InstanceIndex.
+//
+// Requires the drawIndirectCount (Vulkan 1.2), multiDrawIndirect and drawIndirectFirstInstance
+// features to be enabled, and a queue family supporting both graphics and compute.
+class GpuCulling {
+public:
+    explicit GpuCulling(const GpuCullingCreateInfo& gpuCullingCreateInfo);
+
+    // Upload the objects to cull, replacing the previous ones
+    void setObjects(std::span<const GpuCullObject> objects);
+
+    // Record the culling dispatch. Must be recorded outside of a render pass, before the draws
+    // consuming its output.
+    void recordCulling(
+        vk::CommandBuffer commandBuffer,
+        uint32_t frameIndex,
+        const Frustum& frustum) const;
+
+    // Record the culling on the async compute queue and submit it. The graphics submission
+    // recording the draws of the frame must include the returned wait, see submitWithTimelines().
+    [[nodiscard]] TimelineWait submitCulling(uint32_t frameIndex, const Frustum& frustum) const;
+
+    // Record the draws of the visible objects. The graphics pipeline, the vertex and index
+    // buffers must already be bound.
+    void recordDraws(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+private:
+    struct PushConstants {
+        std::array<glm::vec4, 6> frustumPlanes;
+        uint32_t objectCount;
+    };
+
+    struct FrameResources {
+        Buffer drawCommands;
+        Buffer drawCount;
+        vk::DescriptorSet descriptorSet;
+    };
+
+    vk::PhysicalDeviceMemoryProperties memoryProperties_;
+    vk::Device device_;
+    vk::Queue queue_;
+    QueueFamilyIndex queueFamilyIndex_;
+    AsyncCompute* asyncCompute_;
+    uint32_t maxObjectCount_;
+    uint32_t objectCount_ = 0;
+
+    Buffer objects_;
+    vk::UniqueDescriptorSetLayout descriptorSetLayout_;
+    vk::UniqueDescriptorPool descriptorPool_;
+    vk::UniquePipelineLayout pipelineLayout_;
+    vk::UniquePipeline pipeline_;
+    std::vector<FrameResources> frames_;
+};
+
+} // namespace vki
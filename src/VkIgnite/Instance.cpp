@@ -3,107 +3,172 @@
 #include "Pch/Spdlog.hpp"
 #include "Pch/Vulkan.hpp"
 
-VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <stdexcept>
 
-static bool defaultDebugCallbackCpp(
-    vk::DebugUtilsMessageSeverityFlagBitsEXT severity,
-    vk::DebugUtilsMessageTypeFlagsEXT /*type*/,
-    const vk::DebugUtilsMessengerCallbackDataEXT& cbData,
-    void* /*userdata*/)
-{
-    using enum vk::DebugUtilsMessageSeverityFlagBitsEXT;
-    if /*  */ (severity & eError) {
-        spdlog::error(cbData.pMessage);
-    } else if (severity & eWarning) {
-        spdlog::warn(cbData.pMessage);
-    } else if (severity & eInfo) {
-        spdlog::info(cbData.pMessage);
-    } else if (severity & eVerbose) {
-        spdlog::debug(cbData.pMessage);
-    }
-    return false;
-}
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
+// Runs on the thread making the Vulkan call, so the message is handed over to the sink
 static VKAPI_ATTR VkBool32 VKAPI_CALL defaultDebugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT severity,
-    VkDebugUtilsMessageTypeFlagsEXT type,
+    VkDebugUtilsMessageTypeFlagsEXT /*type*/,
     const VkDebugUtilsMessengerCallbackDataEXT* cbData,
     void* userdata)
 {
-    vk::DebugUtilsMessengerCallbackDataEXT callbackData;
-    callbackData = *cbData;
-    return defaultDebugCallbackCpp(
-               static_cast<vk::DebugUtilsMessageSeverityFlagBitsEXT>(severity),
-               static_cast<vk::DebugUtilsMessageTypeFlagBitsEXT>(type),
-               callbackData,
-               userdata)
-        ? VK_TRUE
-        : VK_FALSE;
+    static_cast<vki::DebugMessageSink*>(userdata)->push(
+        static_cast<vk::DebugUtilsMessageSeverityFlagBitsEXT>(severity),
+        cbData->messageIdNumber,
+        cbData->pMessage);
+    return VK_FALSE;
 }
 
 namespace vki {
 
-[[nodiscard]] static bool isValidationLayerSupported(std::string_view layer)
+[[nodiscard]] const InstanceEnumeration& InstanceEnumeration::get()
 {
-    std::vector<vk::LayerProperties> layerProperties = vk::enumerateInstanceLayerProperties();
-    for (const vk::LayerProperties& properties : layerProperties) {
-        if (layer == properties.layerName) {
-            return true;
-        }
-    }
-    return false;
+    static const InstanceEnumeration enumeration = [] {
+        // The loader entry points must be available before the instance exists
+        VULKAN_HPP_DEFAULT_DISPATCHER.init();
+
+        const auto startTime = std::chrono::steady_clock::now();
+        InstanceEnumeration enumeration {
+            .layers = vk::enumerateInstanceLayerProperties(),
+            .extensions = vk::enumerateInstanceExtensionProperties(),
+        };
+        std::ranges::sort(enumeration.layers, {}, [](const vk::LayerProperties& layer) {
+            return std::string_view(layer.layerName);
+        });
+        std::ranges::sort(enumeration.extensions, {}, [](const vk::ExtensionProperties& extension) {
+            return std::string_view(extension.extensionName);
+        });
+        spdlog::debug(
+            "Enumerated {} instance layers and {} instance extensions in {:.3f} ms",
+            enumeration.layers.size(),
+            enumeration.extensions.size(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime)
+                .count());
+        return enumeration;
+    }();
+    return enumeration;
 }
 
-[[nodiscard]] static bool isInstanceExtensionSupported(std::string_view extension)
+[[nodiscard]] bool InstanceEnumeration::hasLayer(std::string_view layerName) const
 {
-    std::vector<vk::ExtensionProperties> extensionProperties
-        = vk::enumerateInstanceExtensionProperties();
-    for (const vk::ExtensionProperties& properties : extensionProperties) {
-        if (extension == properties.extensionName) {
-            return true;
-        }
-    }
-    return false;
+    return std::ranges::binary_search(layers, layerName, {}, [](const vk::LayerProperties& layer) {
+        return std::string_view(layer.layerName);
+    });
 }
 
-[[nodiscard]] static vk::UniqueInstance makeInstanceUnique(InstanceCreateInfo instanceCreateInfo)
+[[nodiscard]] bool InstanceEnumeration::hasExtension(std::string_view extensionName) const
 {
-    vk::ApplicationInfo appInfo {
-        .pApplicationName = instanceCreateInfo.applicationInfo.applicationName.c_str(),
-        .applicationVersion = value_of(instanceCreateInfo.applicationInfo.applicationVersion),
-        .pEngineName = instanceCreateInfo.applicationInfo.engineName.c_str(),
-        .engineVersion = value_of(instanceCreateInfo.applicationInfo.engineVersion),
-        .apiVersion = instanceCreateInfo.applicationInfo.vkApiVersion.value(),
-    };
+    return std::ranges::binary_search(
+        extensions,
+        extensionName,
+        {},
+        [](const vk::ExtensionProperties& extension) {
+            return std::string_view(extension.extensionName);
+        });
+}
+
+[[nodiscard]] static bool hasValidationFeatures(const InstanceCreateInfo& instanceCreateInfo)
+{
+    return instanceCreateInfo.validationLayerKHROption == Option::Enabled
+        && (!instanceCreateInfo.enabledValidationFeatures.empty()
+            || !instanceCreateInfo.disabledValidationFeatures.empty());
+}
+
+// Names are compared by value as the same name may come from different strings
+static void removeDuplicateNames(std::vector<const char*>& names)
+{
+    auto toStringView = [](const char* name) { return std::string_view(name); };
+    std::ranges::sort(names, {}, toStringView);
+    const auto duplicates = std::ranges::unique(names, {}, toStringView);
+    names.erase(duplicates.begin(), duplicates.end());
+}
+
+// Apply the options and keep the optional layers and extensions that are available, so that the
+// enabled lists are final
+static void resolveEnabledNames(InstanceCreateInfo& instanceCreateInfo)
+{
+    const InstanceEnumeration& enumeration = InstanceEnumeration::get();
 
     // Update the debug utils extension requirement according to validation layer requirement
     if (instanceCreateInfo.validationLayerKHROption == Option::Enabled) {
         instanceCreateInfo.debugUtilsMessengerEXTOption = Option::Enabled;
     }
 
-    // Ensure the debug utils extension is present if required
-    if (instanceCreateInfo.debugUtilsMessengerEXTOption == Option::Enabled
-        && !isInstanceExtensionSupported(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
-        throw std::runtime_error(VK_EXT_DEBUG_UTILS_EXTENSION_NAME " is not available");
-    }
-
     // Add the debug utils extension to the list if needed
     if (instanceCreateInfo.debugUtilsMessengerEXTOption == Option::Enabled) {
         instanceCreateInfo.enabledExtensionNames.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
 
-    // Ensure the validation layer is present if required
-    if (instanceCreateInfo.validationLayerKHROption == Option::Enabled
-        && !isValidationLayerSupported("VK_LAYER_KHRONOS_validation")) {
-        throw std::runtime_error("VK_LAYER_KHRONOS_validation is not available");
-    }
-
     // Add the validation layer to the list if needed
     if (instanceCreateInfo.validationLayerKHROption == Option::Enabled) {
         instanceCreateInfo.enabledLayerNames.push_back("VK_LAYER_KHRONOS_validation");
     }
 
+    // Ensure the required layers and extensions are present
+    for (std::string_view layerName : instanceCreateInfo.enabledLayerNames) {
+        if (!enumeration.hasLayer(layerName)) {
+            throw std::runtime_error(std::format("{} is not available", layerName));
+        }
+    }
+    for (std::string_view extensionName : instanceCreateInfo.enabledExtensionNames) {
+        if (!enumeration.hasExtension(extensionName)) {
+            throw std::runtime_error(std::format("{} is not available", extensionName));
+        }
+    }
+
+    // Enable the optional ones that are present
+    for (LayerName layerName : instanceCreateInfo.optionalLayerNames) {
+        if (enumeration.hasLayer(layerName)) {
+            instanceCreateInfo.enabledLayerNames.push_back(layerName);
+        } else {
+            spdlog::info("Optional instance layer {} is not available", layerName);
+        }
+    }
+    for (ExtensionName extensionName : instanceCreateInfo.optionalExtensionNames) {
+        if (enumeration.hasExtension(extensionName)) {
+            instanceCreateInfo.enabledExtensionNames.push_back(extensionName);
+        } else {
+            spdlog::info("Optional instance extension {} is not available", extensionName);
+        }
+    }
+
+    // Provided by the validation layer itself, so not part of the loader extensions
+    if (hasValidationFeatures(instanceCreateInfo)) {
+        instanceCreateInfo.enabledExtensionNames.push_back(
+            VK_EXT_VALIDATION_FEATURES_EXTENSION_NAME);
+    }
+
+    removeDuplicateNames(instanceCreateInfo.enabledLayerNames);
+    removeDuplicateNames(instanceCreateInfo.enabledExtensionNames);
+}
+
+[[nodiscard]] static vk::UniqueInstance makeInstanceUnique(
+    const InstanceCreateInfo& instanceCreateInfo)
+{
+    vk::ApplicationInfo appInfo {
+        .pApplicationName = instanceCreateInfo.applicationInfo.applicationName.c_str(),
+        .applicationVersion = value_of(instanceCreateInfo.applicationInfo.applicationVersion),
+        .pEngineName = instanceCreateInfo.applicationInfo.engineName.c_str(),
+        .engineVersion = value_of(instanceCreateInfo.applicationInfo.engineVersion),
+        .apiVersion = instanceCreateInfo.applicationInfo.vkApiVersion.value(),
+    };
+
+    vk::ValidationFeaturesEXT validationFeatures {
+        .enabledValidationFeatureCount
+        = static_cast<uint32_t>(instanceCreateInfo.enabledValidationFeatures.size()),
+        .pEnabledValidationFeatures = instanceCreateInfo.enabledValidationFeatures.data(),
+        .disabledValidationFeatureCount
+        = static_cast<uint32_t>(instanceCreateInfo.disabledValidationFeatures.size()),
+        .pDisabledValidationFeatures = instanceCreateInfo.disabledValidationFeatures.data(),
+    };
+
     return vk::createInstanceUnique({
+        .pNext = hasValidationFeatures(instanceCreateInfo) ? &validationFeatures : nullptr,
         .pApplicationInfo = &appInfo,
         .enabledLayerCount = static_cast<uint32_t>(instanceCreateInfo.enabledLayerNames.size()),
         .ppEnabledLayerNames = instanceCreateInfo.enabledLayerNames.data(),
@@ -115,24 +180,19 @@ namespace vki {
 
 [[nodiscard]] static vk::UniqueDebugUtilsMessengerEXT makeDebugUtilsMessengerEXTUnique(
     vk::Instance instance,
-    std::optional<DebugUtilsMessengerCallback> debugUtilsMessengerCb)
+    const InstanceCreateInfo& instanceCreateInfo,
+    DebugMessageSink* debugMessageSink)
 {
+    const std::optional<DebugUtilsMessengerCallback>& debugUtilsMessengerCb
+        = instanceCreateInfo.debugUtilsMessengerCallback;
     vk::DebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo = [&] {
         if (debugUtilsMessengerCb == std::nullopt) {
             // Use the default debug utils messenger if the user provided none
             return vk::DebugUtilsMessengerCreateInfoEXT {
-                .messageSeverity =
-                    []() {
-                        using enum vk::DebugUtilsMessageSeverityFlagBitsEXT;
-                        return eVerbose | eInfo | eWarning | eError;
-                    }(),
-                .messageType =
-                    []() {
-                        using enum vk::DebugUtilsMessageTypeFlagBitsEXT;
-                        return eGeneral | eValidation | ePerformance;
-                    }(),
+                .messageSeverity = instanceCreateInfo.debugMessageSeverity,
+                .messageType = instanceCreateInfo.debugMessageType,
                 .pfnUserCallback = defaultDebugCallback,
-                .pUserData = nullptr,
+                .pUserData = debugMessageSink,
             };
         } else {
             return vk::DebugUtilsMessengerCreateInfoEXT {
@@ -149,24 +209,53 @@ namespace vki {
 
 [[nodiscard]] Instance Instance::make(const InstanceCreateInfo& instanceCreateInfo)
 {
+    const auto startTime = std::chrono::steady_clock::now();
+
     VULKAN_HPP_DEFAULT_DISPATCHER.init();
 
-    vk::UniqueInstance instance = vki::makeInstanceUnique(instanceCreateInfo);
+    InstanceCreateInfo resolvedCreateInfo = instanceCreateInfo;
+    resolveEnabledNames(resolvedCreateInfo);
+
+    vk::UniqueInstance instance = vki::makeInstanceUnique(resolvedCreateInfo);
 
     VULKAN_HPP_DEFAULT_DISPATCHER.init(*instance);
 
+    std::unique_ptr<DebugMessageSink> debugMessageSink;
     vk::UniqueDebugUtilsMessengerEXT debugMessenger;
-    if (instanceCreateInfo.debugUtilsMessengerEXTOption == Option::Enabled) {
+    if (resolvedCreateInfo.debugUtilsMessengerEXTOption == Option::Enabled) {
+        if (!resolvedCreateInfo.debugUtilsMessengerCallback.has_value()) {
+            debugMessageSink
+                = std::make_unique<DebugMessageSink>(resolvedCreateInfo.debugMessageSinkCreateInfo);
+        }
         debugMessenger = vki::makeDebugUtilsMessengerEXTUnique(
             *instance,
-            instanceCreateInfo.debugUtilsMessengerCallback);
+            resolvedCreateInfo,
+            debugMessageSink.get());
     }
 
+    spdlog::info(
+        "Created the Vulkan instance in {:.3f} ms",
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime)
+            .count());
+
     return {
         .handle = std::move(instance),
         .allocationCallbacks = instanceCreateInfo.allocationCallbacks,
+        .debugMessageSink = std::move(debugMessageSink),
         .debugUtilsMessengerEXT = std::move(debugMessenger),
+        .enabledLayerNames = std::vector<std::string>(
+            resolvedCreateInfo.enabledLayerNames.begin(),
+            resolvedCreateInfo.enabledLayerNames.end()),
+        .enabledExtensionNames = std::vector<std::string>(
+            resolvedCreateInfo.enabledExtensionNames.begin(),
+            resolvedCreateInfo.enabledExtensionNames.end()),
     };
 }
 
+[[nodiscard]] bool Instance::isExtensionEnabled(std::string_view extensionName) const
+{
+    return std::ranges::find(enabledExtensionNames, extensionName)
+        != enabledExtensionNames.end();
+}
+
 } // namespace vki
@@ -1,21 +1,20 @@
 #pragma once
 
+#include "DebugMessageSink.hpp"
 #include "Types.hpp"
 #include "Version.hpp"
 
 #include "Pch/Vulkan.hpp"
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace vki {
 
-// A boolean value to control an option activation like extension or layer
-enum class Option {
-    Disabled,
-    Enabled,
-};
-
 struct ApplicationInfo {
     std::string applicationName = {};
     Version applicationVersion = {};
@@ -31,18 +30,52 @@ struct DebugUtilsMessengerCallback {
     void* userData;
 };
 
+// Layers and instance extensions exposed by the Vulkan loader. Enumerating them makes the loader
+// scan the layer manifests, so it is done once per process and shared by all the instance checks.
+struct InstanceEnumeration {
+    // Sorted by name
+    std::vector<vk::LayerProperties> layers;
+    // Sorted by name
+    std::vector<vk::ExtensionProperties> extensions;
+
+    [[nodiscard]] static const InstanceEnumeration& get();
+
+    [[nodiscard]] bool hasLayer(std::string_view layerName) const;
+    [[nodiscard]] bool hasExtension(std::string_view extensionName) const;
+};
+
 struct InstanceCreateInfo {
     ApplicationInfo applicationInfo = {};
-    // List of instance layers to enable
+    // List of instance layers to enable, creation fails if one is missing
     std::vector<LayerName> enabledLayerNames = {};
-    // List of instance extensions to enable
+    // List of instance extensions to enable, creation fails if one is missing
     std::vector<ExtensionName> enabledExtensionNames = {};
+    // List of instance layers to enable when available
+    std::vector<LayerName> optionalLayerNames = {};
+    // List of instance extensions to enable when available
+    std::vector<ExtensionName> optionalExtensionNames = {};
     // Whether to enable the validation layer from Khronos
     Option validationLayerKHROption = Option::Disabled;
+    // Validation features to enable and disable through VK_EXT_validation_features when the
+    // validation layer is enabled, the layer defaults are kept when both are empty
+    std::vector<vk::ValidationFeatureEnableEXT> enabledValidationFeatures = {};
+    std::vector<vk::ValidationFeatureDisableEXT> disabledValidationFeatures = {};
     // Whether to enable the debug utils extension
     Option debugUtilsMessengerEXTOption = Option::Disabled;
     // Debug messenger callback, or nullopt to use the engine's default one
     std::optional<DebugUtilsMessengerCallback> debugUtilsMessengerCallback = std::nullopt;
+    // Messages received by the default debug messenger
+    vk::DebugUtilsMessageSeverityFlagsEXT debugMessageSeverity
+        = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose
+        | vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo
+        | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning
+        | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError;
+    vk::DebugUtilsMessageTypeFlagsEXT debugMessageType
+        = vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral
+        | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation
+        | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance;
+    // Queue, muted ids and rate limit of the default debug messenger
+    DebugMessageSinkCreateInfo debugMessageSinkCreateInfo = {};
     // Allocation callback, or nullopt if not used
     std::optional<vk::AllocationCallbacks> allocationCallbacks = std::nullopt;
 };
@@ -51,9 +84,16 @@ class Instance {
 public:
     [[nodiscard]] static Instance make(const InstanceCreateInfo& instanceCreateInfo);
 
+    // Whether an extension, required or optional, has been enabled
+    [[nodiscard]] bool isExtensionEnabled(std::string_view extensionName) const;
+
     vk::UniqueInstance handle;
     std::optional<vk::AllocationCallbacks> allocationCallbacks;
+    // Receives the messages of the default debug messenger, declared before it to outlive it
+    std::unique_ptr<DebugMessageSink> debugMessageSink;
     vk::UniqueDebugUtilsMessengerEXT debugUtilsMessengerEXT;
+    std::vector<std::string> enabledLayerNames;
+    std::vector<std::string> enabledExtensionNames;
 };
 
 } // namespace vki
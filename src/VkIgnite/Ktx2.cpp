@@ -0,0 +1,205 @@
+#include "Ktx2.hpp"
+
+#include <vulkan/vulkan_format_traits.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace vki {
+
+constexpr std::array<uint8_t, 12> kKtx2Identifier {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A,
+};
+
+// The level index follows the header and the data format, key/value and supercompression
+// global data offsets
+constexpr size_t kKtx2LevelIndexOffset = Ktx2Header::size;
+constexpr size_t kKtx2LevelIndexEntrySize = 3 * sizeof(uint64_t);
+
+template<typename TValue>
+[[nodiscard]] static TValue readLittleEndian(std::span<const std::byte> data, size_t offset)
+{
+    static_assert(std::endian::native == std::endian::little, "Big endian hosts not supported");
+    if (offset + sizeof(TValue) > data.size()) {
+        throw std::runtime_error("Truncated KTX2 file");
+    }
+    TValue value;
+    std::memcpy(&value, data.data() + offset, sizeof(TValue));
+    return value;
+}
+
+[[nodiscard]] static std::vector<std::byte> readBytes(const std::string& filename, size_t maxSize)
+{
+    std::ifstream file(filename, std::ios::ate | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open KTX2 file " + filename);
+    }
+    const auto fileSize = file.tellg();
+    if (fileSize < 0) {
+        throw std::runtime_error("Failed to get the size of KTX2 file " + filename);
+    }
+    std::vector<std::byte> data(std::min(static_cast<size_t>(fileSize), maxSize));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    // A short read would leave zeroed bytes that parse as level data
+    if (static_cast<size_t>(file.gcount()) != data.size()) {
+        throw std::runtime_error("Failed to read KTX2 file " + filename);
+    }
+    return data;
+}
+
+[[nodiscard]] Ktx2Header Ktx2Header::parse(std::span<const std::byte> data)
+{
+    if (data.size() < Ktx2Header::size
+        || std::memcmp(data.data(), kKtx2Identifier.data(), kKtx2Identifier.size()) != 0) {
+        throw std::runtime_error("Not a KTX2 file");
+    }
+
+    Ktx2Header header {
+        .format = static_cast<vk::Format>(readLittleEndian<uint32_t>(data, 12)),
+        .typeSize = readLittleEndian<uint32_t>(data, 16),
+        .pixelWidth = readLittleEndian<uint32_t>(data, 20),
+        .pixelHeight = readLittleEndian<uint32_t>(data, 24),
+        .pixelDepth = readLittleEndian<uint32_t>(data, 28),
+        .layerCount = readLittleEndian<uint32_t>(data, 32),
+        .faceCount = readLittleEndian<uint32_t>(data, 36),
+        .levelCount = readLittleEndian<uint32_t>(data, 40),
+        .supercompressionScheme = readLittleEndian<uint32_t>(data, 44),
+    };
+
+    if (header.supercompressionScheme != 0) {
+        throw std::runtime_error(
+            "Supercompressed KTX2 files are not supported (scheme "
+            + std::to_string(header.supercompressionScheme) + ")");
+    }
+    if (header.format == vk::Format::eUndefined) {
+        throw std::runtime_error("KTX2 files requiring transcoding are not supported");
+    }
+    if (vk::blockSize(header.format) == 0) {
+        throw std::runtime_error(
+            "Unknown KTX2 format " + std::to_string(static_cast<uint32_t>(header.format)));
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0
+        || header.layerCount > 1 || header.faceCount != 1) {
+        throw std::runtime_error("Only 2D KTX2 textures are supported");
+    }
+    if (header.levelCount == 0) {
+        // A level count of 0 requests the mip chain to be generated at load time, which is not
+        // possible for block-compressed formats
+        throw std::runtime_error("KTX2 files without mip levels are not supported");
+    }
+    // Also bounds the mip level shifts and the level index size
+    const auto maxLevelCount = static_cast<uint32_t>(
+        std::bit_width(std::max(header.pixelWidth, header.pixelHeight)));
+    if (header.levelCount > maxLevelCount) {
+        throw std::runtime_error(
+            "KTX2 file has more mip levels than its extent allows ("
+            + std::to_string(header.levelCount) + ")");
+    }
+    return header;
+}
+
+[[nodiscard]] Ktx2Header Ktx2Header::readFile(const std::string& filename)
+{
+    return parse(readBytes(filename, Ktx2Header::size));
+}
+
+[[nodiscard]] static vk::DeviceSize getLevelSize(const Ktx2Header& header, uint32_t mipLevel)
+{
+    const std::array<uint8_t, 3> blockExtent = vk::blockExtent(header.format);
+    const uint32_t width = std::max(1u, header.pixelWidth >> mipLevel);
+    const uint32_t height = std::max(1u, header.pixelHeight >> mipLevel);
+    const vk::DeviceSize blocksX = (width + blockExtent[0] - 1) / blockExtent[0];
+    const vk::DeviceSize blocksY = (height + blockExtent[1] - 1) / blockExtent[1];
+    return blocksX * blocksY * vk::blockSize(header.format);
+}
+
+[[nodiscard]] Ktx2Image Ktx2Image::parse(std::vector<std::byte> data)
+{
+    Ktx2Header header = Ktx2Header::parse(data);
+
+    std::vector<Ktx2Level> levels;
+    levels.reserve(header.levelCount);
+    for (uint32_t mipLevel = 0; mipLevel < header.levelCount; mipLevel++) {
+        const size_t entryOffset = kKtx2LevelIndexOffset + mipLevel * kKtx2LevelIndexEntrySize;
+        Ktx2Level level {
+            .byteOffset = readLittleEndian<uint64_t>(data, entryOffset),
+            .byteLength = readLittleEndian<uint64_t>(data, entryOffset + sizeof(uint64_t)),
+            .uncompressedByteLength
+            = readLittleEndian<uint64_t>(data, entryOffset + 2 * sizeof(uint64_t)),
+        };
+        // Written so that crafted offsets and lengths cannot wrap around
+        if (level.byteLength > data.size() || level.byteOffset > data.size() - level.byteLength) {
+            throw std::runtime_error(
+                "KTX2 mip level " + std::to_string(mipLevel) + " is out of the file bounds");
+        }
+        if (level.byteLength != getLevelSize(header, mipLevel)) {
+            throw std::runtime_error(
+                "KTX2 mip level " + std::to_string(mipLevel) + " has an unexpected size");
+        }
+        // Level data must satisfy copyBufferToImage alignment rules once copied contiguously
+        if (level.byteOffset % std::lcm<uint64_t>(4, vk::blockSize(header.format)) != 0) {
+            throw std::runtime_error(
+                "KTX2 mip level " + std::to_string(mipLevel) + " is not properly aligned");
+        }
+        levels.push_back(level);
+    }
+
+    return {
+        .header = header,
+        .levels = std::move(levels),
+        .data = std::move(data),
+    };
+}
+
+[[nodiscard]] Ktx2Image Ktx2Image::readFile(const std::string& filename)
+{
+    return parse(readBytes(filename, std::numeric_limits<size_t>::max()));
+}
+
+[[nodiscard]] std::span<const std::byte> Ktx2Image::levelData() const
+{
+    // Levels are stored from the smallest to the largest one, but do not rely on that
+    const auto [firstLevel, lastLevel] = std::ranges::minmax(levels, {}, &Ktx2Level::byteOffset);
+    const uint64_t begin = firstLevel.byteOffset;
+    const uint64_t end = lastLevel.byteOffset + lastLevel.byteLength;
+    return std::span(data).subspan(begin, end - begin);
+}
+
+[[nodiscard]] std::vector<vk::BufferImageCopy> Ktx2Image::copyRegions(
+    vk::DeviceSize bufferOffset) const
+{
+    const uint64_t levelDataOffset
+        = std::ranges::min(levels, {}, &Ktx2Level::byteOffset).byteOffset;
+
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve(levels.size());
+    for (uint32_t mipLevel = 0; mipLevel < levels.size(); mipLevel++) {
+        regions.push_back({
+            .bufferOffset = bufferOffset + levels[mipLevel].byteOffset - levelDataOffset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = mipLevel,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = { 0, 0, 0 },
+            .imageExtent = {
+                .width = std::max(1u, header.pixelWidth >> mipLevel),
+                .height = std::max(1u, header.pixelHeight >> mipLevel),
+                .depth = 1,
+            },
+        });
+    }
+    return regions;
+}
+
+} // namespace vki
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vki {
+
+// Fixed-size header at the beginning of every KTX2 file.
+// Refer to https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html for details.
+struct Ktx2Header {
+    vk::Format format;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+
+    static constexpr size_t size = 80;
+
+    // Parse and validate the header from the first bytes of a KTX2 file
+    [[nodiscard]] static Ktx2Header parse(std::span<const std::byte> data);
+
+    [[nodiscard]] static Ktx2Header readFile(const std::string& filename);
+};
+
+// Location of a mip level in a KTX2 file
+struct Ktx2Level {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+// A 2D KTX2 texture whose mip levels can be copied as is into an image, like block-compressed
+// BC1-7, ETC2 or ASTC textures.
+//
+// Supercompressed files (BasisLZ, Zstandard, ZLIB) and Basis Universal UASTC files require a
+// transcoder and are rejected.
+class Ktx2Image {
+public:
+    [[nodiscard]] static Ktx2Image parse(std::vector<std::byte> data);
+
+    [[nodiscard]] static Ktx2Image readFile(const std::string& filename);
+
+    // Contiguous bytes holding all the mip levels, ready to be copied in a staging buffer
+    [[nodiscard]] std::span<const std::byte> levelData() const;
+
+    // Copy regions uploading every mip level with a single copyBufferToImage call, assuming
+    // levelData() was copied at bufferOffset in the source buffer
+    [[nodiscard]] std::vector<vk::BufferImageCopy> copyRegions(vk::DeviceSize bufferOffset) const;
+
+    [[nodiscard]] vk::Extent2D extent() const
+    {
+        return { .width = header.pixelWidth, .height = header.pixelHeight };
+    }
+
+    [[nodiscard]] uint32_t mipLevels() const
+    {
+        return static_cast<uint32_t>(levels.size());
+    }
+
+    Ktx2Header header;
+    // Level 0 is the base level
+    std::vector<Ktx2Level> levels;
+    std::vector<std::byte> data;
+};
+
+} // namespace vki
@@ -0,0 +1,207 @@
+#include "Memory.hpp"
+
+#include "Stdx/Algorithm.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace vki {
+
+[[nodiscard]] std::optional<uint32_t> findMemoryTypeIndex(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    uint32_t typeBits,
+    vk::MemoryPropertyFlags requiredProperties)
+{
+    for (uint32_t typeIndex = 0; typeIndex < memoryProperties.memoryTypeCount; typeIndex++) {
+        const bool isAllowed = (typeBits & (1u << typeIndex)) != 0;
+        const vk::MemoryPropertyFlags properties
+            = memoryProperties.memoryTypes[typeIndex].propertyFlags;
+        if (isAllowed && (properties & requiredProperties) == requiredProperties) {
+            return typeIndex;
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]] std::optional<uint32_t> findMemoryTypeIndex(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    uint32_t typeBits,
+    vk::MemoryPropertyFlags requiredProperties,
+    vk::MemoryPropertyFlags preferredProperties)
+{
+    std::optional<uint32_t> preferredTypeIndex
+        = findMemoryTypeIndex(memoryProperties, typeBits, requiredProperties | preferredProperties);
+    if (preferredTypeIndex.has_value()) {
+        return preferredTypeIndex;
+    }
+    return findMemoryTypeIndex(memoryProperties, typeBits, requiredProperties);
+}
+
+[[nodiscard]] static vk::UniqueDeviceMemory allocateMemory(
+    vk::Device device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    const vk::MemoryRequirements& memoryRequirements,
+    vk::MemoryPropertyFlags requiredProperties,
+    vk::MemoryAllocateFlags allocateFlags = {})
+{
+    std::optional<uint32_t> memoryTypeIndex = findMemoryTypeIndex(
+        memoryProperties,
+        memoryRequirements.memoryTypeBits,
+        requiredProperties);
+    if (!memoryTypeIndex.has_value()) {
+        throw std::runtime_error(
+            "No memory type providing " + vk::to_string(requiredProperties) + " found");
+    }
+    vk::MemoryAllocateFlagsInfo allocateFlagsInfo { .flags = allocateFlags };
+    return device.allocateMemoryUnique({
+        .pNext = allocateFlags ? &allocateFlagsInfo : nullptr,
+        .allocationSize = memoryRequirements.size,
+        .memoryTypeIndex = *memoryTypeIndex,
+    });
+}
+
+[[nodiscard]] Buffer Buffer::make(
+    vk::Device device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    const BufferCreateInfo& bufferCreateInfo)
+{
+    std::vector<QueueFamilyIndex> queueFamilyIndices(
+        bufferCreateInfo.queueFamilyIndices.begin(),
+        bufferCreateInfo.queueFamilyIndices.end());
+    stdx::ranges::sort_unique(queueFamilyIndices);
+    const bool concurrent = queueFamilyIndices.size() > 1;
+
+    vk::UniqueBuffer buffer = device.createBufferUnique({
+        .size = bufferCreateInfo.size,
+        .usage = bufferCreateInfo.usage,
+        .sharingMode = concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+        .queueFamilyIndexCount
+        = concurrent ? static_cast<uint32_t>(queueFamilyIndices.size()) : 0,
+        .pQueueFamilyIndices = concurrent ? queueFamilyIndices.data() : nullptr,
+    });
+
+    vk::UniqueDeviceMemory memory = allocateMemory(
+        device,
+        memoryProperties,
+        device.getBufferMemoryRequirements(*buffer),
+        bufferCreateInfo.memoryProperties,
+        // Buffers read through their address need memory that can be addressed
+        (bufferCreateInfo.usage & vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            ? vk::MemoryAllocateFlagBits::eDeviceAddress
+            : vk::MemoryAllocateFlags {});
+    device.bindBufferMemory(*buffer, *memory, 0);
+
+    return {
+        .handle = std::move(buffer),
+        .memory = std::move(memory),
+        .size = bufferCreateInfo.size,
+    };
+}
+
+[[nodiscard]] vk::DeviceAddress Buffer::getDeviceAddress(vk::Device device) const
+{
+    return device.getBufferAddress({ .buffer = *handle });
+}
+
+[[nodiscard]] static vk::UniqueImage createImage(
+    vk::Device device,
+    const ImageCreateInfo& imageCreateInfo)
+{
+    vk::ImageUsageFlags usage = imageCreateInfo.usage;
+    if (imageCreateInfo.transientAttachment == Option::Enabled) {
+        usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+    }
+
+    return device.createImageUnique({
+        .imageType = vk::ImageType::e2D,
+        .format = imageCreateInfo.format,
+        .extent = {
+            .width = imageCreateInfo.extent.width,
+            .height = imageCreateInfo.extent.height,
+            .depth = 1,
+        },
+        .mipLevels = imageCreateInfo.mipLevels,
+        .arrayLayers = 1,
+        .samples = imageCreateInfo.samples,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = usage,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined,
+    });
+}
+
+[[nodiscard]] Image Image::make(
+    vk::Device device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    const ImageCreateInfo& imageCreateInfo)
+{
+    const bool transientAttachment = imageCreateInfo.transientAttachment == Option::Enabled;
+    vk::UniqueImage image = createImage(device, imageCreateInfo);
+
+    vk::MemoryRequirements memoryRequirements = device.getImageMemoryRequirements(*image);
+    const vk::MemoryPropertyFlags preferredProperties = transientAttachment
+        ? vk::MemoryPropertyFlags { vk::MemoryPropertyFlagBits::eLazilyAllocated }
+        : vk::MemoryPropertyFlags {};
+    std::optional<uint32_t> memoryTypeIndex = findMemoryTypeIndex(
+        memoryProperties,
+        memoryRequirements.memoryTypeBits,
+        imageCreateInfo.memoryProperties,
+        preferredProperties);
+    if (!memoryTypeIndex.has_value()) {
+        throw std::runtime_error(
+            "No memory type providing " + vk::to_string(imageCreateInfo.memoryProperties)
+            + " found");
+    }
+    vk::UniqueDeviceMemory memory = device.allocateMemoryUnique({
+        .allocationSize = memoryRequirements.size,
+        .memoryTypeIndex = *memoryTypeIndex,
+    });
+    device.bindImageMemory(*image, *memory, 0);
+
+    return {
+        .handle = std::move(image),
+        .memory = std::move(memory),
+        .format = imageCreateInfo.format,
+        .extent = imageCreateInfo.extent,
+        .mipLevels = imageCreateInfo.mipLevels,
+        .allocationSize = memoryRequirements.size,
+        .lazilyAllocated = static_cast<bool>(
+            memoryProperties.memoryTypes[*memoryTypeIndex].propertyFlags
+            & vk::MemoryPropertyFlagBits::eLazilyAllocated),
+    };
+}
+
+[[nodiscard]] vk::MemoryRequirements Image::getMemoryRequirements(
+    vk::Device device,
+    const ImageCreateInfo& imageCreateInfo)
+{
+    // The image is destroyed without ever being bound to memory
+    const vk::UniqueImage image = createImage(device, imageCreateInfo);
+    return device.getImageMemoryRequirements(*image);
+}
+
+[[nodiscard]] vk::UniqueImageView Image::makeView(
+    vk::Device device,
+    vk::ImageAspectFlags aspectMask) const
+{
+    return device.createImageViewUnique({
+        .image = *handle,
+        .viewType = vk::ImageViewType::e2D,
+        .format = format,
+        .components = {
+            .r = vk::ComponentSwizzle::eIdentity,
+            .g = vk::ComponentSwizzle::eIdentity,
+            .b = vk::ComponentSwizzle::eIdentity,
+            .a = vk::ComponentSwizzle::eIdentity,
+        },
+        .subresourceRange = {
+            .aspectMask = aspectMask,
+            .baseMipLevel = 0,
+            .levelCount = mipLevels,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    });
+}
+
+} // namespace vki
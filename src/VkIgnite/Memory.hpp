@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <optional>
+#include <span>
+
+namespace vki {
+
+// Find the first memory type allowed by typeBits and providing all the required properties
+[[nodiscard]] std::optional<uint32_t> findMemoryTypeIndex(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    uint32_t typeBits,
+    vk::MemoryPropertyFlags requiredProperties);
+
+// Same as above, favoring a memory type also providing the preferred properties if there is one
+[[nodiscard]] std::optional<uint32_t> findMemoryTypeIndex(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    uint32_t typeBits,
+    vk::MemoryPropertyFlags requiredProperties,
+    vk::MemoryPropertyFlags preferredProperties);
+
+struct BufferCreateInfo {
+    vk::DeviceSize size = 0;
+    vk::BufferUsageFlags usage = {};
+    vk::MemoryPropertyFlags memoryProperties = {};
+    // Families of the queues accessing the buffer. With several distinct families the buffer is
+    // shared concurrently, so that no queue family ownership transfer is needed.
+    std::span<const QueueFamilyIndex> queueFamilyIndices = {};
+};
+
+// A buffer bound to its own dedicated memory allocation
+class Buffer {
+public:
+    [[nodiscard]] static Buffer make(
+        vk::Device device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        const BufferCreateInfo& bufferCreateInfo);
+
+    // Address of the buffer for shaders, the buffer must have been created with the
+    // eShaderDeviceAddress usage and the bufferDeviceAddress feature enabled
+    [[nodiscard]] vk::DeviceAddress getDeviceAddress(vk::Device device) const;
+
+    vk::UniqueBuffer handle;
+    vk::UniqueDeviceMemory memory;
+    vk::DeviceSize size = 0;
+};
+
+struct ImageCreateInfo {
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent = {};
+    uint32_t mipLevels = 1;
+    vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+    vk::ImageUsageFlags usage = {};
+    vk::MemoryPropertyFlags memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+    // Whether the image is only used as an attachment whose contents are neither loaded nor
+    // stored. If so it is backed by lazily allocated memory when the device provides it, which
+    // tile-based GPUs may never commit.
+    Option transientAttachment = Option::Disabled;
+};
+
+// An optimally tiled 2D image bound to its own dedicated memory allocation
+class Image {
+public:
+    [[nodiscard]] static Image make(
+        vk::Device device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        const ImageCreateInfo& imageCreateInfo);
+
+    // Memory requirements of the image make() would create, without allocating its memory
+    [[nodiscard]] static vk::MemoryRequirements getMemoryRequirements(
+        vk::Device device,
+        const ImageCreateInfo& imageCreateInfo);
+
+    // Create a 2D view covering all the mip levels of the image
+    [[nodiscard]] vk::UniqueImageView makeView(
+        vk::Device device,
+        vk::ImageAspectFlags aspectMask = vk::ImageAspectFlagBits::eColor) const;
+
+    vk::UniqueImage handle;
+    vk::UniqueDeviceMemory memory;
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent = {};
+    uint32_t mipLevels = 1;
+    vk::DeviceSize allocationSize = 0;
+    bool lazilyAllocated = false;
+};
+
+} // namespace vki
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+namespace vki {
+
+// Highest sample count not above the requested one that the device supports for both color and
+// depth framebuffer attachments, so that they can be used together in a subpass
+[[nodiscard]] inline vk::SampleCountFlagBits chooseSampleCount(
+    const vk::PhysicalDeviceLimits& limits,
+    vk::SampleCountFlagBits requestedSampleCount)
+{
+    const vk::SampleCountFlags supportedSampleCounts
+        = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+    for (vk::SampleCountFlagBits sampleCount : {
+             vk::SampleCountFlagBits::e64,
+             vk::SampleCountFlagBits::e32,
+             vk::SampleCountFlagBits::e16,
+             vk::SampleCountFlagBits::e8,
+             vk::SampleCountFlagBits::e4,
+             vk::SampleCountFlagBits::e2,
+         }) {
+        if (sampleCount <= requestedSampleCount && (supportedSampleCounts & sampleCount)) {
+            return sampleCount;
+        }
+    }
+    return vk::SampleCountFlagBits::e1;
+}
+
+} // namespace vki
@@ -0,0 +1,106 @@
+#include "PhysicalDeviceInfo.hpp"
+
+#include <algorithm>
+
+namespace vki {
+
+[[nodiscard]] PhysicalDeviceInfo PhysicalDeviceInfo::make(vk::PhysicalDevice physicalDevice)
+{
+    PhysicalDeviceInfo info { .handle = physicalDevice };
+
+    // The extensions decide which extension structures can be chained
+    info.extensions = physicalDevice.enumerateDeviceExtensionProperties();
+    std::ranges::sort(info.extensions, {}, [](const vk::ExtensionProperties& extension) {
+        return std::string_view(extension.extensionName);
+    });
+
+    // The version decides which version structures can be chained, and is only known from the
+    // properties, hence this one extra query
+    const uint32_t apiVersion = physicalDevice.getProperties().apiVersion;
+
+    vk::StructureChain<
+        vk::PhysicalDeviceProperties2,
+        vk::PhysicalDeviceVulkan11Properties,
+        vk::PhysicalDeviceVulkan12Properties,
+        vk::PhysicalDeviceVulkan13Properties>
+        properties;
+    vk::StructureChain<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan11Features,
+        vk::PhysicalDeviceVulkan12Features,
+        vk::PhysicalDeviceVulkan13Features,
+        vk::PhysicalDevicePresentIdFeaturesKHR,
+        vk::PhysicalDevicePresentWaitFeaturesKHR>
+        features;
+    unlinkUnsupportedVersionStructures<
+        vk::PhysicalDeviceVulkan11Properties,
+        vk::PhysicalDeviceVulkan12Properties,
+        vk::PhysicalDeviceVulkan13Properties>(properties, apiVersion);
+    unlinkUnsupportedVersionStructures<
+        vk::PhysicalDeviceVulkan11Features,
+        vk::PhysicalDeviceVulkan12Features,
+        vk::PhysicalDeviceVulkan13Features>(features, apiVersion);
+    const bool hasPresentId = info.hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    const bool hasPresentWait = info.hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    if (!hasPresentId) {
+        features.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+    }
+    if (!hasPresentWait) {
+        features.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+    }
+    physicalDevice.getProperties2(&properties.get<vk::PhysicalDeviceProperties2>());
+    physicalDevice.getFeatures2(&features.get<vk::PhysicalDeviceFeatures2>());
+
+    info.properties = properties.get<vk::PhysicalDeviceProperties2>().properties;
+    info.features = features.get<vk::PhysicalDeviceFeatures2>().features;
+    if (apiVersion >= VK_API_VERSION_1_2) {
+        info.properties11 = properties.get<vk::PhysicalDeviceVulkan11Properties>();
+        info.properties11.pNext = nullptr;
+        info.properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+        info.properties12.pNext = nullptr;
+        info.features11 = features.get<vk::PhysicalDeviceVulkan11Features>();
+        info.features11.pNext = nullptr;
+        info.features12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+        info.features12.pNext = nullptr;
+    }
+    if (apiVersion >= VK_API_VERSION_1_3) {
+        info.properties13 = properties.get<vk::PhysicalDeviceVulkan13Properties>();
+        info.properties13.pNext = nullptr;
+        info.features13 = features.get<vk::PhysicalDeviceVulkan13Features>();
+        info.features13.pNext = nullptr;
+    }
+    if (hasPresentId) {
+        info.presentIdFeatures = features.get<vk::PhysicalDevicePresentIdFeaturesKHR>();
+        info.presentIdFeatures.pNext = nullptr;
+    }
+    if (hasPresentWait) {
+        info.presentWaitFeatures = features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+        info.presentWaitFeatures.pNext = nullptr;
+    }
+
+    info.memoryProperties = physicalDevice.getMemoryProperties();
+    info.queueFamilies = physicalDevice.getQueueFamilyProperties();
+    return info;
+}
+
+[[nodiscard]] bool PhysicalDeviceInfo::hasExtension(std::string_view extensionName) const
+{
+    return std::ranges::binary_search(
+        extensions,
+        extensionName,
+        {},
+        [](const vk::ExtensionProperties& extension) {
+            return std::string_view(extension.extensionName);
+        });
+}
+
+[[nodiscard]] std::vector<PhysicalDeviceInfo> queryPhysicalDeviceInfos(vk::Instance instance)
+{
+    std::vector<PhysicalDeviceInfo> infos;
+    for (vk::PhysicalDevice physicalDevice : instance.enumeratePhysicalDevices()) {
+        infos.push_back(PhysicalDeviceInfo::make(physicalDevice));
+    }
+    return infos;
+}
+
+} // namespace vki
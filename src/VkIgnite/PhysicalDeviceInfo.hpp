@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vki {
+
+// Snapshot of the properties, features, memory properties, queue families and extensions of a
+// physical device, queried once and shared by the device picker, the device creation and the
+// subsystems instead of querying the driver again. The pNext members of the chained structures
+// are reset, as the chain does not survive the query.
+struct PhysicalDeviceInfo {
+    [[nodiscard]] static PhysicalDeviceInfo make(vk::PhysicalDevice physicalDevice);
+
+    [[nodiscard]] std::string_view name() const
+    {
+        return properties.deviceName;
+    }
+
+    [[nodiscard]] bool hasExtension(std::string_view extensionName) const;
+
+    vk::PhysicalDevice handle;
+    vk::PhysicalDeviceProperties properties;
+    // The Vulkan 1.1 and 1.2 structures are left value initialized when the device does not
+    // support Vulkan 1.2, which introduced them, and the 1.3 ones when it does not support 1.3
+    vk::PhysicalDeviceVulkan11Properties properties11;
+    vk::PhysicalDeviceVulkan12Properties properties12;
+    vk::PhysicalDeviceVulkan13Properties properties13;
+    vk::PhysicalDeviceFeatures features;
+    vk::PhysicalDeviceVulkan11Features features11;
+    vk::PhysicalDeviceVulkan12Features features12;
+    vk::PhysicalDeviceVulkan13Features features13;
+    // Left value initialized when the device does not support the extension
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures;
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    std::vector<vk::QueueFamilyProperties> queueFamilies;
+    // Sorted by name
+    std::vector<vk::ExtensionProperties> extensions;
+};
+
+// Snapshot of every physical device of the instance
+[[nodiscard]] std::vector<PhysicalDeviceInfo> queryPhysicalDeviceInfos(vk::Instance instance);
+
+// Unlink the Vulkan 1.1, 1.2 and 1.3 structures of a properties or features chain, which can only
+// be chained if the device supports the version introducing them: Vulkan 1.2 for the 1.1 and 1.2
+// structures, Vulkan 1.3 for the 1.3 ones
+template<typename T11, typename T12, typename T13, typename... TChain>
+void unlinkUnsupportedVersionStructures(vk::StructureChain<TChain...>& chain, uint32_t apiVersion)
+{
+    if (apiVersion < VK_API_VERSION_1_2) {
+        chain.template unlink<T11>();
+        chain.template unlink<T12>();
+    }
+    if (apiVersion < VK_API_VERSION_1_3) {
+        chain.template unlink<T13>();
+    }
+}
+
+} // namespace vki
@@ -1,26 +1,128 @@
 #pragma once
 
-#include "Stdx/Algorithm.hpp"
+#include "PhysicalDeviceInfo.hpp"
+#include "QueueTopology.hpp"
 #include "VkIgnite.hpp"
 
 #include "Pch/Spdlog.hpp"
 #include "Pch/Vulkan.hpp"
 
+#include <algorithm>
 #include <charconv>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <format>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 
 namespace vki {
 
 struct PhysicalDevicePickResult {
     vk::PhysicalDevice physicalDevice;
-    QueueFamilyIndex graphicsQueueFamilyIndex;
-    QueueFamilyIndex presentationQueueFamilyIndex;
+    PhysicalDeviceInfo deviceInfo;
+    QueueTopology queueTopology;
     SwapchainSupportDetails swapchainSupportDetails;
+    double score = 0.0;
+};
+
+// Contribution of a device property to the device score
+struct PhysicalDeviceCriterion {
+    std::string name;
+    double weight = 1.0;
+    // Value of the device for this criterion, usually normalized in [0, 1]
+    std::function<double(const PhysicalDeviceInfo&)> evaluate;
+};
+
+// Property a device must have to be picked, such as a feature
+struct PhysicalDeviceRequirement {
+    std::string name;
+    std::function<bool(const PhysicalDeviceInfo&)> isMet;
+};
+
+// Favor discrete GPUs, then the amount of device local memory and the compute, push constant and
+// image limits
+[[nodiscard]] inline std::vector<PhysicalDeviceCriterion> getDefaultPhysicalDeviceCriteria()
+{
+    return {
+        {
+            .name = "device type",
+            .weight = 100.0,
+            .evaluate = [](const PhysicalDeviceInfo& deviceInfo) {
+                switch (deviceInfo.properties.deviceType) {
+                case vk::PhysicalDeviceType::eDiscreteGpu:
+                    return 1.0;
+                case vk::PhysicalDeviceType::eIntegratedGpu:
+                    return 0.4;
+                case vk::PhysicalDeviceType::eVirtualGpu:
+                    return 0.2;
+                case vk::PhysicalDeviceType::eCpu:
+                case vk::PhysicalDeviceType::eOther:
+                    return 0.0;
+                }
+                return 0.0;
+            },
+        },
+        {
+            .name = "device local memory",
+            .weight = 20.0,
+            // Logarithmic in GiB, so that doubling the memory always adds the same score
+            .evaluate = [](const PhysicalDeviceInfo& deviceInfo) {
+                const vk::PhysicalDeviceMemoryProperties& memoryProperties
+                    = deviceInfo.memoryProperties;
+                vk::DeviceSize largestHeapSize = 0;
+                for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+                    const vk::MemoryHeap& heap = memoryProperties.memoryHeaps[i];
+                    if (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+                        largestHeapSize = std::max(largestHeapSize, heap.size);
+                    }
+                }
+                constexpr double GiB = 1024.0 * 1024.0 * 1024.0;
+                return std::log2(1.0 + static_cast<double>(largestHeapSize) / GiB);
+            },
+        },
+        {
+            .name = "compute work group invocations",
+            .weight = 5.0,
+            .evaluate = [](const PhysicalDeviceInfo& deviceInfo) {
+                const uint32_t invocations
+                    = deviceInfo.properties.limits.maxComputeWorkGroupInvocations;
+                return std::min(invocations / 1024.0, 1.0);
+            },
+        },
+        {
+            .name = "push constants size",
+            .weight = 5.0,
+            .evaluate = [](const PhysicalDeviceInfo& deviceInfo) {
+                return std::min(deviceInfo.properties.limits.maxPushConstantsSize / 256.0, 1.0);
+            },
+        },
+        {
+            .name = "2D image dimension",
+            .weight = 5.0,
+            .evaluate = [](const PhysicalDeviceInfo& deviceInfo) {
+                return std::min(deviceInfo.properties.limits.maxImageDimension2D / 16384.0, 1.0);
+            },
+        },
+    };
+}
+
+struct PhysicalDevicePickInfo {
+    std::span<ExtensionName> requiredExtensions = {};
+    // Each optional extension available adds its weight to the device score
+    std::span<const ExtensionName> optionalExtensions = {};
+    double optionalExtensionWeight = 10.0;
+    std::vector<PhysicalDeviceRequirement> requirements = {};
+    std::vector<PhysicalDeviceCriterion> criteria = getDefaultPhysicalDeviceCriteria();
 };
 
 // Pick a Vulkan physical device suitable for graphics rendering. If multiple
-// devices are suitable, the preferred one is selected.
+// devices are suitable, the one with the highest score is selected.
 // If the DEVICE_ID environment variable is defined, the device having the
 // corresponding ID is selected. If it is not found, the program terminates. To
 // get the list of device IDs, run the program once without the environment
@@ -32,9 +134,10 @@ struct PhysicalDevicePickResult {
 // - the device provides a presentation queue
 // - the surface provides at least one surface format
 // - the surface provides at least one presentation mode
+// - the device meets every additional requirement
 //
-// Device properties preference:
-// - type: discrete > integrated > virtual > cpu > other
+// The score is the weighted sum of the criteria values plus the weight of each optional extension
+// available, and is detailed in the logs for every compatible device.
 class PhysicalDevicePicker {
 public:
     [[nodiscard]] static PhysicalDevicePickResult pick(
@@ -42,36 +145,67 @@ public:
         const vk::SurfaceKHR& surface,
         std::span<vki::ExtensionName> requiredDeviceExtensions)
     {
+        return pick(instance, surface, { .requiredExtensions = requiredDeviceExtensions });
+    }
+
+    [[nodiscard]] static PhysicalDevicePickResult pick(
+        const vk::Instance& instance,
+        const vk::SurfaceKHR& surface,
+        const PhysicalDevicePickInfo& pickInfo)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
         std::vector<PhysicalDevicePickResult> compatiblePhysicalDevices;
 
+        // Every device is queried once, the checks below only read the snapshots
         spdlog::debug("Enumerating devices...");
-        const std::vector physicalDevices = instance.enumeratePhysicalDevices();
-        for (const vk::PhysicalDevice& physicalDevice : physicalDevices) {
-            auto deviceProperties = physicalDevice.getProperties();
+        for (PhysicalDeviceInfo& deviceInfo : queryPhysicalDeviceInfos(instance)) {
             spdlog::debug(
                 "Device: ID={}, name=\"{}\"",
-                deviceProperties.deviceID,
-                std::string_view(deviceProperties.deviceName));
+                deviceInfo.properties.deviceID,
+                deviceInfo.name());
             std::optional<PhysicalDevicePickResult> physicalDevicePickResult
-                = isPhysicalDeviceCompatible(physicalDevice, surface, requiredDeviceExtensions);
+                = isPhysicalDeviceCompatible(deviceInfo, surface, pickInfo);
             if (physicalDevicePickResult.has_value()) {
-                compatiblePhysicalDevices.push_back(*physicalDevicePickResult);
+                physicalDevicePickResult->score = scorePhysicalDevice(deviceInfo, pickInfo);
+                compatiblePhysicalDevices.push_back(std::move(*physicalDevicePickResult));
             }
         }
 
         if (compatiblePhysicalDevices.empty()) {
-            std::runtime_error("No compatible physical device found");
+            throw std::runtime_error("No compatible physical device found");
         }
 
+        PhysicalDevicePickResult pickedPhysicalDevice;
         char* userSelectedDeviceId = std::getenv("DEVICE_ID");
         if (userSelectedDeviceId != nullptr) {
             spdlog::debug("DEVICE_ID provided: {}", userSelectedDeviceId);
-            return pickFromEnv(userSelectedDeviceId, compatiblePhysicalDevices);
+            pickedPhysicalDevice = pickFromEnv(userSelectedDeviceId, compatiblePhysicalDevices);
+        } else {
+            std::ranges::stable_sort(
+                compatiblePhysicalDevices,
+                std::ranges::greater {},
+                &PhysicalDevicePickResult::score);
+            if (compatiblePhysicalDevices.size() > 1) {
+                spdlog::info(
+                    "Picked physical device {} with a score of {:.1f}, ahead of {} with {:.1f}",
+                    compatiblePhysicalDevices[0].deviceInfo.name(),
+                    compatiblePhysicalDevices[0].score,
+                    compatiblePhysicalDevices[1].deviceInfo.name(),
+                    compatiblePhysicalDevices[1].score);
+            } else {
+                spdlog::info(
+                    "Picked physical device {}, the only compatible one",
+                    compatiblePhysicalDevices[0].deviceInfo.name());
+            }
+            pickedPhysicalDevice = std::move(compatiblePhysicalDevices.front());
         }
 
-        std::ranges::sort(compatiblePhysicalDevices, compareDevicesByPreference);
-        PhysicalDevicePickResult& preferedPhysicalDevice = compatiblePhysicalDevices.front();
-        return preferedPhysicalDevice;
+        spdlog::debug(
+            "Picked physical device {} in {:.3f} ms",
+            pickedPhysicalDevice.deviceInfo.name(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime)
+                .count());
+        return pickedPhysicalDevice;
     }
 
 private:
@@ -101,7 +235,7 @@ private:
         auto selectedDeviceIt = std::ranges::find_if(
             compatiblePhysicalDevices,
             [deviceId](const PhysicalDevicePickResult& compatibleDevice) -> bool {
-                return compatibleDevice.physicalDevice.getProperties().deviceID == deviceId;
+                return compatibleDevice.deviceInfo.properties.deviceID == deviceId;
             });
         if (selectedDeviceIt == compatiblePhysicalDevices.end()) {
             spdlog::error("Selected device ID {} not found.", deviceId);
@@ -110,47 +244,36 @@ private:
         return *selectedDeviceIt;
     }
 
-    [[nodiscard]] static bool compareDevicesByPreference(
-        const PhysicalDevicePickResult& device1,
-        const PhysicalDevicePickResult& device2)
-    {
-        const auto preferenceForDevice1
-            = getDeviceTypePreference(device1.physicalDevice.getProperties().deviceType);
-        const auto preferenceForDevice2
-            = getDeviceTypePreference(device2.physicalDevice.getProperties().deviceType);
-        return preferenceForDevice1 < preferenceForDevice2;
-    }
-
-    [[nodiscard]] static uint32_t getDeviceTypePreference(vk::PhysicalDeviceType type)
+    // Weighted score of the device, logging the contribution of each criterion
+    [[nodiscard]] static double scorePhysicalDevice(
+        const PhysicalDeviceInfo& deviceInfo,
+        const PhysicalDevicePickInfo& pickInfo)
     {
-        switch (type) {
-        case vk::PhysicalDeviceType::eDiscreteGpu:
-            return 0;
-        case vk::PhysicalDeviceType::eIntegratedGpu:
-            return 1;
-        case vk::PhysicalDeviceType::eVirtualGpu:
-            return 2;
-        case vk::PhysicalDeviceType::eCpu:
-            return 3;
-        case vk::PhysicalDeviceType::eOther:
-            return 4;
+        double score = 0.0;
+        std::string details;
+        auto addTerm = [&](std::string_view name, double term) {
+            score += term;
+            details += std::format("{}{}: {:.1f}", details.empty() ? "" : ", ", name, term);
+        };
+        for (const PhysicalDeviceCriterion& criterion : pickInfo.criteria) {
+            addTerm(criterion.name, criterion.weight * criterion.evaluate(deviceInfo));
+        }
+        for (std::string_view optionalExtension : pickInfo.optionalExtensions) {
+            if (deviceInfo.hasExtension(optionalExtension)) {
+                addTerm(optionalExtension, pickInfo.optionalExtensionWeight);
+            }
         }
-        throw std::logic_error("Unsupported vk::PhysicalDeviceType");
+        spdlog::info("Physical device {} scores {:.1f} ({})", deviceInfo.name(), score, details);
+        return score;
     }
 
     [[nodiscard]] static bool areRequiredDeviceExtensionsAvailable(
-        const vk::PhysicalDevice& physicalDevice,
+        const PhysicalDeviceInfo& deviceInfo,
         std::span<vki::ExtensionName> requiredDeviceExtensions)
     {
-        const std::vector availableExtensions = physicalDevice.enumerateDeviceExtensionProperties();
         bool extensionsSupported = true;
         for (std::string_view requiredExtension : requiredDeviceExtensions) {
-            if (!stdx::ranges::contains(
-                    availableExtensions,
-                    requiredExtension,
-                    [](const vk::ExtensionProperties& extprop) -> std::string_view {
-                        return extprop.extensionName;
-                    })) {
+            if (!deviceInfo.hasExtension(requiredExtension)) {
                 spdlog::debug("Physical device does not support extension {}", requiredExtension);
                 extensionsSupported = false;
             }
@@ -158,66 +281,43 @@ private:
         return extensionsSupported;
     }
 
-    [[nodiscard]] static std::optional<QueueFamilyIndex> findFirstGraphicsQueueIndex(
-        const vk::PhysicalDevice& physicalDevice)
+    [[nodiscard]] static bool areRequirementsMet(
+        const PhysicalDeviceInfo& deviceInfo,
+        std::span<const PhysicalDeviceRequirement> requirements)
     {
-        const std::vector queueFamiliesProperties = physicalDevice.getQueueFamilyProperties();
-        const QueueFamilyIndex queueFamiliesCount { static_cast<uint32_t>(
-            queueFamiliesProperties.size()) };
-        for (QueueFamilyIndex queueFamilyIndex = 0; queueFamilyIndex < queueFamiliesCount;
-             queueFamilyIndex++) {
-            const vk::QueueFamilyProperties& queueFamilyProperty
-                = queueFamiliesProperties[queueFamilyIndex];
-            if (queueFamilyProperty.queueFlags & vk::QueueFlagBits::eGraphics) {
-                return queueFamilyIndex;
+        bool requirementsMet = true;
+        for (const PhysicalDeviceRequirement& requirement : requirements) {
+            if (!requirement.isMet(deviceInfo)) {
+                spdlog::debug("Physical device does not meet requirement {}", requirement.name);
+                requirementsMet = false;
             }
         }
-        spdlog::debug("Incompatible physical device: no graphics queue");
-        return std::nullopt;
-    }
-
-    [[nodiscard]] static std::optional<QueueFamilyIndex> findFirstPresentationQueueIndex(
-        const vk::PhysicalDevice& physicalDevice,
-        const vk::SurfaceKHR& surface)
-    {
-        const std::vector queueFamiliesProperties = physicalDevice.getQueueFamilyProperties();
-        const QueueFamilyIndex queueFamiliesCount { static_cast<uint32_t>(
-            queueFamiliesProperties.size()) };
-        for (QueueFamilyIndex queueFamilyIndex = 0; queueFamilyIndex < queueFamiliesCount;
-             queueFamilyIndex++) {
-            if (physicalDevice.getSurfaceSupportKHR(queueFamilyIndex, surface)) {
-                return queueFamilyIndex;
-            }
-        }
-        spdlog::debug("Incompatible physical device: no presentation queue");
-        return std::nullopt;
+        return requirementsMet;
     }
 
     [[nodiscard]] static std::optional<PhysicalDevicePickResult> isPhysicalDeviceCompatible(
-        const vk::PhysicalDevice& physicalDevice,
+        const PhysicalDeviceInfo& deviceInfo,
         const vk::SurfaceKHR& surface,
-        std::span<vki::ExtensionName> requiredDeviceExtensions)
+        const PhysicalDevicePickInfo& pickInfo)
     {
-        vk::PhysicalDeviceProperties properties = physicalDevice.getProperties();
-        std::string_view deviceName = properties.deviceName;
+        std::string_view deviceName = deviceInfo.name();
 
         spdlog::debug("Checking if physical device {} is compatible", deviceName);
 
         bool requiredExtensionsAvailable
-            = areRequiredDeviceExtensionsAvailable(physicalDevice, requiredDeviceExtensions);
+            = areRequiredDeviceExtensionsAvailable(deviceInfo, pickInfo.requiredExtensions);
 
-        std::optional<QueueFamilyIndex> graphicsQueueIndex
-            = findFirstGraphicsQueueIndex(physicalDevice);
+        bool requirementsMet = areRequirementsMet(deviceInfo, pickInfo.requirements);
 
-        std::optional<QueueFamilyIndex> presentationQueueIndex
-            = findFirstPresentationQueueIndex(physicalDevice, surface);
+        std::optional<QueueTopology> queueTopology = findQueueTopology(deviceInfo, surface);
 
-        SwapchainSupportDetails swapchainSupport = querySwapchainSupport(physicalDevice, surface);
+        SwapchainSupportDetails swapchainSupport
+            = querySwapchainSupport(deviceInfo.handle, surface);
         bool swapchainAdequate
             = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
 
-        bool isCompatible = requiredExtensionsAvailable && graphicsQueueIndex.has_value()
-            && presentationQueueIndex.has_value() && swapchainAdequate;
+        bool isCompatible = requiredExtensionsAvailable && requirementsMet
+            && queueTopology.has_value() && swapchainAdequate;
 
         if (!isCompatible) {
             spdlog::warn("Physical device {} is not compatible", deviceName);
@@ -227,9 +327,9 @@ private:
         spdlog::debug("Physical device {} is compatible", deviceName);
 
         return PhysicalDevicePickResult {
-            .physicalDevice = physicalDevice,
-            .graphicsQueueFamilyIndex = *graphicsQueueIndex,
-            .presentationQueueFamilyIndex = *presentationQueueIndex,
+            .physicalDevice = deviceInfo.handle,
+            .deviceInfo = deviceInfo,
+            .queueTopology = *queueTopology,
             .swapchainSupportDetails = swapchainSupport,
         };
     }
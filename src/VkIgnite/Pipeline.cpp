@@ -0,0 +1,41 @@
+#include "Pipeline.hpp"
+#include "Shader.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace vki {
+
+[[nodiscard]] vk::UniquePipeline makeComputePipelineUnique(
+    vk::Device device,
+    const ComputePipelineCreateInfo& computePipelineCreateInfo)
+{
+    vk::UniqueShaderModule computeShader = Shader::compileGlslToSpv(
+        device,
+        computePipelineCreateInfo.sourceText,
+        ShaderCompileInfo {
+            .shaderStage = GLSLANG_STAGE_COMPUTE,
+            .inputIdentifier = computePipelineCreateInfo.inputIdentifier,
+            .entryPointName = computePipelineCreateInfo.entryPointName,
+        });
+
+    vk::ComputePipelineCreateInfo pipelineCreateInfo {
+        .stage = {
+            .stage = vk::ShaderStageFlagBits::eCompute,
+            .module = *computeShader,
+            .pName = computePipelineCreateInfo.entryPointName,
+        },
+        .layout = computePipelineCreateInfo.layout,
+    };
+
+    auto pipelineCreationResult
+        = device.createComputePipelinesUnique(nullptr, { pipelineCreateInfo }, nullptr);
+    if (pipelineCreationResult.result != vk::Result::eSuccess) {
+        throw std::runtime_error(
+            std::string("Failed to create compute pipeline ")
+            + computePipelineCreateInfo.inputIdentifier);
+    }
+    return std::move(pipelineCreationResult.value[0]);
+}
+
+} // namespace vki
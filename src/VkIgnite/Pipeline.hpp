@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Pch/Vulkan.hpp"
+
+namespace vki {
+
+struct ComputePipelineCreateInfo {
+    // GLSL source of the compute shader
+    const char* sourceText;
+    const char* inputIdentifier;
+    vk::PipelineLayout layout;
+    const char* entryPointName = "main";
+};
+
+// Compile a GLSL compute shader and create the corresponding compute pipeline
+[[nodiscard]] vk::UniquePipeline makeComputePipelineUnique(
+    vk::Device device,
+    const ComputePipelineCreateInfo& computePipelineCreateInfo);
+
+} // namespace vki
@@ -0,0 +1,175 @@
+#include "PresentWait.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <utility>
+
+namespace vki {
+
+bool isPresentWaitSupported(const PhysicalDeviceInfo& deviceInfo)
+{
+    // The snapshot leaves the features disabled when the extensions are not supported
+    return deviceInfo.presentIdFeatures.presentId && deviceInfo.presentWaitFeatures.presentWait;
+}
+
+void LatencyHistogram::add(std::chrono::nanoseconds duration)
+{
+    const auto milliseconds = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    const size_t bucket = std::min<size_t>(std::bit_width(milliseconds), kBucketCount - 1);
+    counts[bucket]++;
+    sampleCount++;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+std::chrono::nanoseconds LatencyHistogram::average() const
+{
+    return sampleCount > 0 ? total / sampleCount : std::chrono::nanoseconds {};
+}
+
+std::string LatencyHistogram::toString() const
+{
+    std::string result;
+    for (size_t bucket = 0; bucket < kBucketCount; bucket++) {
+        if (counts[bucket] == 0) {
+            continue;
+        }
+        if (!result.empty()) {
+            result += ", ";
+        }
+        const uint64_t lowerBound = bucket == 0 ? 0 : uint64_t { 1 } << (bucket - 1);
+        if (bucket == kBucketCount - 1) {
+            result += std::format("[{}, +inf) ms: {}", lowerBound, counts[bucket]);
+        } else {
+            result += std::format(
+                "[{}, {}) ms: {}",
+                lowerBound,
+                uint64_t { 1 } << bucket,
+                counts[bucket]);
+        }
+    }
+    return result;
+}
+
+PresentWaiter::~PresentWaiter()
+{
+    stop();
+}
+
+void PresentWaiter::start(vk::Device device, vk::SwapchainKHR swapchain)
+{
+    stop();
+    device_ = device;
+    swapchain_ = swapchain;
+    thread_ = std::jthread([this](std::stop_token stopToken) { run(stopToken); });
+}
+
+void PresentWaiter::stop()
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    thread_.request_stop();
+    thread_.join();
+    {
+        std::scoped_lock lock { mutex_ };
+        pendingPresents_.clear();
+    }
+    condition_.notify_all();
+}
+
+uint64_t PresentWaiter::nextPresentId()
+{
+    if (!isRunning()) {
+        return 0;
+    }
+    return ++lastPresentId_;
+}
+
+void PresentWaiter::onPresentQueued(uint64_t presentId, Clock::time_point frameStart)
+{
+    if (!isRunning() || presentId == 0) {
+        return;
+    }
+    {
+        std::scoped_lock lock { mutex_ };
+        pendingPresents_.push_back({
+            .presentId = presentId,
+            .frameStart = frameStart,
+            .presentTime = Clock::now(),
+        });
+    }
+    condition_.notify_all();
+}
+
+void PresentWaiter::waitForQueuedPresents(
+    uint32_t maxQueuedPresents,
+    std::chrono::nanoseconds timeout)
+{
+    if (!isRunning()) {
+        return;
+    }
+    std::unique_lock lock { mutex_ };
+    condition_.wait_for(lock, timeout, [&] {
+        return pendingPresents_.size() <= maxQueuedPresents;
+    });
+}
+
+PresentLatencyStats PresentWaiter::takeStats()
+{
+    std::scoped_lock lock { mutex_ };
+    return std::exchange(stats_, {});
+}
+
+void PresentWaiter::run(std::stop_token stopToken)
+{
+    // Presents are waited with a timeout so that stopping is never delayed for long
+    constexpr uint64_t kWaitTimeoutNs = 100'000'000;
+
+    while (true) {
+        PendingPresent present;
+        {
+            std::unique_lock lock { mutex_ };
+            if (!condition_.wait(lock, stopToken, [&] { return !pendingPresents_.empty(); })) {
+                return;
+            }
+            present = pendingPresents_.front();
+        }
+
+        bool displayed = false;
+        while (!stopToken.stop_requested()) {
+            vk::Result result = vk::Result::eTimeout;
+            try {
+                result = device_.waitForPresentKHR(swapchain_, present.presentId, kWaitTimeoutNs);
+            } catch (const vk::SystemError& e) {
+                // Out of date or lost surface, the present will never be displayed
+                spdlog::debug("waitForPresentKHR failed: {}", e.what());
+                break;
+            }
+            if (result != vk::Result::eTimeout) {
+                displayed = true;
+                break;
+            }
+        }
+        const Clock::time_point displayTime = Clock::now();
+
+        {
+            std::scoped_lock lock { mutex_ };
+            if (!pendingPresents_.empty()
+                && pendingPresents_.front().presentId == present.presentId) {
+                pendingPresents_.erase(pendingPresents_.begin());
+            }
+            if (displayed) {
+                stats_.presentToDisplay.add(displayTime - present.presentTime);
+                stats_.frameStartToDisplay.add(displayTime - present.frameStart);
+            }
+        }
+        condition_.notify_all();
+    }
+}
+
+} // namespace vki
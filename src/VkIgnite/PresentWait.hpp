@@ -0,0 +1,105 @@
+#pragma once
+
+#include "PhysicalDeviceInfo.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vki {
+
+// Whether the device supports VK_KHR_present_id and VK_KHR_present_wait along with their features
+[[nodiscard]] bool isPresentWaitSupported(const PhysicalDeviceInfo& deviceInfo);
+
+// Histogram of durations in power of two millisecond buckets: [0, 1), [1, 2), [2, 4) up to
+// [64, +inf)
+struct LatencyHistogram {
+    static constexpr size_t kBucketCount = 8;
+
+    std::array<uint32_t, kBucketCount> counts = {};
+    uint32_t sampleCount = 0;
+    std::chrono::nanoseconds total = {};
+    std::chrono::nanoseconds max = {};
+
+    void add(std::chrono::nanoseconds duration);
+
+    [[nodiscard]] std::chrono::nanoseconds average() const;
+
+    // Non empty buckets, e.g. "[4, 8) ms: 12, [8, 16) ms: 3"
+    [[nodiscard]] std::string toString() const;
+};
+
+struct PresentLatencyStats {
+    // From the presentKHR call to the image being displayed
+    LatencyHistogram presentToDisplay;
+    // From the start of the frame, when it samples its input, to the image being displayed
+    LatencyHistogram frameStartToDisplay;
+};
+
+// Track when presented images are actually displayed, using VK_KHR_present_id to tag the presents
+// and VK_KHR_present_wait to wait for them on a side thread.
+//
+// Until started, and when the extensions are not supported, every member is a no-op so that the
+// application does not need to special case it. Must be stopped before its swapchain is retired.
+class PresentWaiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PresentWaiter() = default;
+    PresentWaiter(const PresentWaiter&) = delete;
+    PresentWaiter& operator=(const PresentWaiter&) = delete;
+    ~PresentWaiter();
+
+    void start(vk::Device device, vk::SwapchainKHR swapchain);
+    // Stop waiting, discarding the presents not displayed yet
+    void stop();
+
+    [[nodiscard]] bool isRunning() const
+    {
+        return thread_.joinable();
+    }
+
+    // Identifier to chain with a vk::PresentIdKHR to the next present, 0 when not running
+    [[nodiscard]] uint64_t nextPresentId();
+
+    // Report that the present tagged with presentId has been queued
+    void onPresentQueued(uint64_t presentId, Clock::time_point frameStart);
+
+    // Block until at most maxQueuedPresents presents are waiting to be displayed or the timeout
+    // expires, to start frames in step with the display instead of queuing them
+    void waitForQueuedPresents(uint32_t maxQueuedPresents, std::chrono::nanoseconds timeout);
+
+    // Statistics of the presents displayed since the previous call
+    [[nodiscard]] PresentLatencyStats takeStats();
+
+private:
+    struct PendingPresent {
+        uint64_t presentId;
+        Clock::time_point frameStart;
+        Clock::time_point presentTime;
+    };
+
+    void run(std::stop_token stopToken);
+
+    vk::Device device_;
+    vk::SwapchainKHR swapchain_;
+    uint64_t lastPresentId_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable_any condition_;
+    // A few presents at most are pending, a vector keeps its capacity so queuing a present does
+    // not allocate once warmed up
+    std::vector<PendingPresent> pendingPresents_;
+    PresentLatencyStats stats_;
+
+    std::jthread thread_;
+};
+
+} // namespace vki
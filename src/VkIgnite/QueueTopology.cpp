@@ -0,0 +1,136 @@
+#include "QueueTopology.hpp"
+
+#include "Stdx/Algorithm.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <string>
+
+namespace vki {
+
+[[nodiscard]] std::vector<QueueFamilyIndex> QueueTopology::getUniqueFamilies() const
+{
+    std::vector<QueueFamilyIndex> families { graphics, present };
+    if (asyncCompute.has_value()) {
+        families.push_back(*asyncCompute);
+    }
+    if (transfer.has_value()) {
+        families.push_back(*transfer);
+    }
+    stdx::ranges::sort_unique(families);
+    return families;
+}
+
+[[nodiscard]] std::optional<QueueTopology> findQueueTopology(
+    const PhysicalDeviceInfo& deviceInfo,
+    vk::SurfaceKHR surface)
+{
+    const std::vector<vk::QueueFamilyProperties>& families = deviceInfo.queueFamilies;
+    const auto familyCount = static_cast<QueueFamilyIndex>(families.size());
+
+    std::vector<bool> canPresent(familyCount);
+    for (QueueFamilyIndex family = 0; family < familyCount; family++) {
+        canPresent[family] = !surface || deviceInfo.handle.getSurfaceSupportKHR(family, surface);
+    }
+    auto hasFlags = [&](QueueFamilyIndex family, vk::QueueFlags flags) {
+        return families[family].queueCount > 0 && (families[family].queueFlags & flags) == flags;
+    };
+    auto lacksFlags = [&](QueueFamilyIndex family, vk::QueueFlags flags) {
+        return !(families[family].queueFlags & flags);
+    };
+
+    // Graphics family able to present if possible, then the one with the most queues
+    std::optional<QueueFamilyIndex> graphics;
+    for (QueueFamilyIndex family = 0; family < familyCount; family++) {
+        // Compute is also required on the graphics queue to run the culling pass
+        if (!hasFlags(family, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) {
+            continue;
+        }
+        if (!graphics.has_value() || canPresent[family] > canPresent[*graphics]
+            || (canPresent[family] == canPresent[*graphics]
+                && families[family].queueCount > families[*graphics].queueCount)) {
+            graphics = family;
+        }
+    }
+    if (!graphics.has_value()) {
+        spdlog::debug("Incompatible physical device: no graphics and compute queue");
+        return std::nullopt;
+    }
+
+    std::optional<QueueFamilyIndex> present;
+    if (canPresent[*graphics]) {
+        present = graphics;
+    } else {
+        for (QueueFamilyIndex family = 0; family < familyCount && !present; family++) {
+            if (canPresent[family] && families[family].queueCount > 0) {
+                present = family;
+            }
+        }
+    }
+    if (!present.has_value()) {
+        spdlog::debug("Incompatible physical device: no presentation queue");
+        return std::nullopt;
+    }
+
+    QueueTopology topology {
+        .graphics = *graphics,
+        .present = *present,
+    };
+    for (QueueFamilyIndex family = 0; family < familyCount; family++) {
+        if (!topology.asyncCompute.has_value() && hasFlags(family, vk::QueueFlagBits::eCompute)
+            && lacksFlags(family, vk::QueueFlagBits::eGraphics)) {
+            topology.asyncCompute = family;
+        }
+        if (!topology.transfer.has_value() && hasFlags(family, vk::QueueFlagBits::eTransfer)
+            && lacksFlags(family, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) {
+            topology.transfer = family;
+        }
+    }
+
+    spdlog::debug(
+        "Queue families of {}: graphics {}, present {}, async compute {}, transfer {}",
+        deviceInfo.name(),
+        topology.graphics,
+        topology.present,
+        topology.asyncCompute.has_value() ? std::to_string(*topology.asyncCompute) : "none",
+        topology.transfer.has_value() ? std::to_string(*topology.transfer) : "none");
+    return topology;
+}
+
+[[nodiscard]] std::vector<QueueCreateInfo> makeQueueCreateInfos(const QueueTopology& topology)
+{
+    // Background work such as streaming should yield to the frame being rendered
+    constexpr float kGraphicsPriority = 1.0f;
+    constexpr float kAsyncComputePriority = 0.5f;
+    constexpr float kTransferPriority = 0.25f;
+
+    std::vector<QueueCreateInfo> queueCreateInfos;
+    for (QueueFamilyIndex family : topology.getUniqueFamilies()) {
+        float priority = kTransferPriority;
+        if (family == topology.graphics || family == topology.present) {
+            priority = kGraphicsPriority;
+        } else if (family == topology.asyncCompute) {
+            priority = kAsyncComputePriority;
+        }
+        queueCreateInfos.push_back({
+            .queueFamilyIndex = family,
+            .queuePriorities = { priority },
+        });
+    }
+    return queueCreateInfos;
+}
+
+[[nodiscard]] Queues getQueues(vk::Device device, const QueueTopology& topology)
+{
+    return {
+        .graphics = device.getQueue(topology.graphics, 0),
+        .present = device.getQueue(topology.present, 0),
+        .asyncCompute = topology.asyncCompute.has_value()
+            ? device.getQueue(*topology.asyncCompute, 0)
+            : vk::Queue {},
+        .transfer = topology.transfer.has_value() ? device.getQueue(*topology.transfer, 0)
+                                                  : vk::Queue {},
+    };
+}
+
+} // namespace vki
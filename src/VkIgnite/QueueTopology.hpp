@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Device.hpp"
+#include "PhysicalDeviceInfo.hpp"
+#include "Types.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace vki {
+
+// Queue families used by the renderer, a queue being created from each distinct family
+struct QueueTopology {
+    // Supports graphics and compute
+    QueueFamilyIndex graphics = 0;
+    // The graphics family whenever it can present, so that the swapchain images are not shared
+    // between families
+    QueueFamilyIndex present = 0;
+    // Compute without graphics, to overlap compute work with rendering
+    std::optional<QueueFamilyIndex> asyncCompute;
+    // Transfer without graphics nor compute, usually backed by a dedicated DMA engine
+    std::optional<QueueFamilyIndex> transfer;
+
+    // Distinct families of the topology, sorted
+    [[nodiscard]] std::vector<QueueFamilyIndex> getUniqueFamilies() const;
+};
+
+// Select the queue families of a device. Return nullopt if the device has no family supporting
+// both graphics and compute, or no family able to present to the surface. Without surface, for
+// headless rendering, the present family is the graphics one.
+[[nodiscard]] std::optional<QueueTopology> findQueueTopology(
+    const PhysicalDeviceInfo& deviceInfo,
+    vk::SurfaceKHR surface);
+
+// One queue per distinct family of the topology, giving graphics and presentation precedence over
+// async compute and transfers
+[[nodiscard]] std::vector<QueueCreateInfo> makeQueueCreateInfos(const QueueTopology& topology);
+
+// Queues of a topology, null for the families the topology does not have
+struct Queues {
+    vk::Queue graphics;
+    vk::Queue present;
+    vk::Queue asyncCompute;
+    vk::Queue transfer;
+};
+
+[[nodiscard]] Queues getQueues(vk::Device device, const QueueTopology& topology);
+
+} // namespace vki
@@ -0,0 +1,212 @@
+#include "RenderQueue.hpp"
+
+#include "Stdx/RadixSort.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace vki {
+
+// Sort key layout, from most to least significant bits: pipeline, material, mesh
+constexpr uint32_t kMeshKeyBits = 24;
+constexpr uint32_t kMaterialKeyBits = 24;
+constexpr uint64_t kMeshKeyMask = (uint64_t { 1 } << kMeshKeyBits) - 1;
+constexpr uint64_t kMaterialKeyMask = (uint64_t { 1 } << kMaterialKeyBits) - 1;
+
+RenderQueue::RenderQueue(const RenderQueueCreateInfo& renderQueueCreateInfo)
+    : device_ { renderQueueCreateInfo.device }
+    , instanceStride_ { renderQueueCreateInfo.instanceStride }
+    , maxInstancesPerFrame_ { renderQueueCreateInfo.maxInstancesPerFrame }
+    , meshBinding_ { renderQueueCreateInfo.meshBinding }
+    , instanceBinding_ { renderQueueCreateInfo.instanceBinding }
+    , materialSetIndex_ { renderQueueCreateInfo.materialSetIndex }
+{
+    const vk::PhysicalDeviceMemoryProperties memoryProperties
+        = renderQueueCreateInfo.physicalDevice.getMemoryProperties();
+    const vk::DeviceSize instanceBufferSize
+        = vk::DeviceSize { instanceStride_ } * maxInstancesPerFrame_;
+
+    using enum vk::MemoryPropertyFlagBits;
+    for (uint32_t i = 0; i < renderQueueCreateInfo.framesInFlight; i++) {
+        Buffer instanceBuffer = Buffer::make(
+            device_,
+            memoryProperties,
+            {
+                .size = instanceBufferSize,
+                .usage = vk::BufferUsageFlagBits::eVertexBuffer,
+                .memoryProperties = eHostVisible | eHostCoherent,
+            });
+        // Mapped for the lifetime of the buffer, freeing the memory implicitly unmaps it
+        auto* instanceData = static_cast<std::byte*>(
+            device_.mapMemory(*instanceBuffer.memory, 0, instanceBufferSize));
+        frames_.push_back({
+            .instanceBuffer = std::move(instanceBuffer),
+            .instanceData = instanceData,
+        });
+    }
+
+    instanceData_.reserve(instanceBufferSize);
+    requests_.reserve(maxInstancesPerFrame_);
+    sortScratch_.resize(maxInstancesPerFrame_);
+}
+
+RenderPipelineId RenderQueue::addPipeline(const RenderPipeline& pipeline)
+{
+    if (pipelines_.size() > std::numeric_limits<RenderPipelineId>::max()) {
+        throw std::runtime_error("Too many pipelines in the render queue");
+    }
+    pipelines_.push_back(pipeline);
+    return static_cast<RenderPipelineId>(pipelines_.size() - 1);
+}
+
+RenderMaterialId RenderQueue::addMaterial(vk::DescriptorSet descriptorSet)
+{
+    if (materials_.size() > kMaterialKeyMask) {
+        throw std::runtime_error("Too many materials in the render queue");
+    }
+    materials_.push_back(descriptorSet);
+    return static_cast<RenderMaterialId>(materials_.size() - 1);
+}
+
+RenderMeshId RenderQueue::addMesh(const RenderMesh& mesh)
+{
+    if (meshes_.size() > kMeshKeyMask) {
+        throw std::runtime_error("Too many meshes in the render queue");
+    }
+    meshes_.push_back(mesh);
+    return static_cast<RenderMeshId>(meshes_.size() - 1);
+}
+
+uint64_t RenderQueue::makeSortKey(
+    RenderPipelineId pipeline,
+    RenderMaterialId material,
+    RenderMeshId mesh)
+{
+    return (uint64_t { pipeline } << (kMaterialKeyBits + kMeshKeyBits))
+        | ((material & kMaterialKeyMask) << kMeshKeyBits) | (mesh & kMeshKeyMask);
+}
+
+void RenderQueue::submit(
+    RenderPipelineId pipeline,
+    RenderMaterialId material,
+    RenderMeshId mesh,
+    std::span<const std::byte> instanceData)
+{
+    if (instanceData.size() != instanceStride_) {
+        throw std::invalid_argument("Instance data size does not match the instance stride");
+    }
+    if (requests_.size() == maxInstancesPerFrame_) {
+        throw std::runtime_error("Render queue is full");
+    }
+    requests_.push_back({
+        .sortKey = makeSortKey(pipeline, material, mesh),
+        .instanceIndex = static_cast<uint32_t>(requests_.size()),
+    });
+    instanceData_.insert(instanceData_.end(), instanceData.begin(), instanceData.end());
+}
+
+RenderQueueStats RenderQueue::record(vk::CommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    const FrameResources& frame = frames_[frameIndex];
+    stats_ = { .drawRequests = static_cast<uint32_t>(requests_.size()) };
+
+    stdx::radix_sort(
+        std::span(requests_),
+        std::span(sortScratch_),
+        [](const DrawRequest& request) { return request.sortKey; });
+
+    if (!requests_.empty()) {
+        commandBuffer.bindVertexBuffers(instanceBinding_, { *frame.instanceBuffer.handle }, { 0 });
+    }
+
+    const RenderPipeline* boundPipeline = nullptr;
+    std::optional<vk::DescriptorSet> boundMaterial;
+    const RenderMesh* boundMesh = nullptr;
+
+    uint32_t firstInstance = 0;
+    for (size_t runBegin = 0; runBegin < requests_.size();) {
+        const uint64_t sortKey = requests_[runBegin].sortKey;
+        size_t runEnd = runBegin + 1;
+        while (runEnd < requests_.size() && requests_[runEnd].sortKey == sortKey) {
+            runEnd++;
+        }
+
+        // Gather the instances of the run contiguously in the frame buffer
+        for (size_t i = runBegin; i < runEnd; i++) {
+            std::memcpy(
+                frame.instanceData + size_t { firstInstance + (i - runBegin) } * instanceStride_,
+                instanceData_.data() + size_t { requests_[i].instanceIndex } * instanceStride_,
+                instanceStride_);
+        }
+
+        const RenderPipeline& pipeline
+            = pipelines_.at(sortKey >> (kMaterialKeyBits + kMeshKeyBits));
+        const vk::DescriptorSet material
+            = materials_.at((sortKey >> kMeshKeyBits) & kMaterialKeyMask);
+        const RenderMesh& mesh = meshes_.at(sortKey & kMeshKeyMask);
+
+        if (&pipeline != boundPipeline) {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+            boundPipeline = &pipeline;
+            // The new pipeline layout may not be compatible with the bound descriptor sets
+            boundMaterial.reset();
+            stats_.pipelineBinds++;
+        }
+        if (material != boundMaterial) {
+            if (material) {
+                commandBuffer.bindDescriptorSets(
+                    vk::PipelineBindPoint::eGraphics,
+                    pipeline.layout,
+                    materialSetIndex_,
+                    { material },
+                    {});
+                stats_.descriptorSetBinds++;
+            }
+            boundMaterial = material;
+        }
+        if (boundMesh == nullptr || mesh.vertexBuffer != boundMesh->vertexBuffer
+            || mesh.vertexBufferOffset != boundMesh->vertexBufferOffset
+            || mesh.indexBuffer != boundMesh->indexBuffer
+            || mesh.indexBufferOffset != boundMesh->indexBufferOffset
+            || mesh.indexType != boundMesh->indexType) {
+            commandBuffer.bindVertexBuffers(
+                meshBinding_,
+                { mesh.vertexBuffer },
+                { mesh.vertexBufferOffset });
+            commandBuffer.bindIndexBuffer(mesh.indexBuffer, mesh.indexBufferOffset, mesh.indexType);
+            stats_.meshBinds++;
+        }
+        boundMesh = &mesh;
+
+        const auto instanceCount = static_cast<uint32_t>(runEnd - runBegin);
+        commandBuffer.drawIndexed(
+            mesh.indexCount,
+            instanceCount,
+            mesh.firstIndex,
+            mesh.vertexOffset,
+            firstInstance);
+        stats_.drawCalls++;
+
+        firstInstance += instanceCount;
+        runBegin = runEnd;
+    }
+
+    spdlog::trace(
+        "Render queue: {} requests, {} draws, {} pipeline binds, {} descriptor set binds, {} mesh "
+        "binds",
+        stats_.drawRequests,
+        stats_.drawCalls,
+        stats_.pipelineBinds,
+        stats_.descriptorSetBinds,
+        stats_.meshBinds);
+
+    requests_.clear();
+    instanceData_.clear();
+    return stats_;
+}
+
+} // namespace vki
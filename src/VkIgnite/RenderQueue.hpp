@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Memory.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vki {
+
+using RenderPipelineId = uint16_t;
+using RenderMaterialId = uint32_t;
+using RenderMeshId = uint32_t;
+
+struct RenderPipeline {
+    vk::Pipeline pipeline;
+    vk::PipelineLayout layout;
+};
+
+// Indexed geometry drawn by the render queue. Meshes sharing the same buffers only cost a draw
+// call when switching from one to another.
+struct RenderMesh {
+    vk::Buffer vertexBuffer;
+    vk::DeviceSize vertexBufferOffset = 0;
+    vk::Buffer indexBuffer;
+    vk::DeviceSize indexBufferOffset = 0;
+    vk::IndexType indexType = vk::IndexType::eUint32;
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t vertexOffset = 0;
+};
+
+struct RenderQueueCreateInfo {
+    vk::PhysicalDevice physicalDevice;
+    vk::Device device;
+    // Size in bytes of the per instance data, read by the pipelines as a per instance vertex input
+    uint32_t instanceStride;
+    uint32_t maxInstancesPerFrame;
+    uint32_t framesInFlight;
+    // Vertex binding of the mesh vertices and of the per instance data
+    uint32_t meshBinding = 0;
+    uint32_t instanceBinding = 1;
+    // Descriptor set index at which the material descriptor sets are bound
+    uint32_t materialSetIndex = 0;
+};
+
+// Commands recorded by the last RenderQueue::record call
+struct RenderQueueStats {
+    uint32_t drawRequests = 0;
+    uint32_t drawCalls = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t meshBinds = 0;
+};
+
+// Queue of draw requests merged into instanced draws.
+//
+// Requests are sorted by a 64-bit key made of the pipeline, the material and the mesh, most
+// expensive state change first, so that identical requests end up next to each other and each
+// run is issued as a single instanced draw. The instance data of the requests is copied in sorted
+// order into a persistently mapped per frame buffer, so the instances of each draw are contiguous
+// and addressed through firstInstance.
+class RenderQueue {
+public:
+    explicit RenderQueue(const RenderQueueCreateInfo& renderQueueCreateInfo);
+
+    [[nodiscard]] RenderPipelineId addPipeline(const RenderPipeline& pipeline);
+    // A null descriptor set can be used for pipelines without material
+    [[nodiscard]] RenderMaterialId addMaterial(vk::DescriptorSet descriptorSet);
+    [[nodiscard]] RenderMeshId addMesh(const RenderMesh& mesh);
+
+    [[nodiscard]] static uint64_t makeSortKey(
+        RenderPipelineId pipeline,
+        RenderMaterialId material,
+        RenderMeshId mesh);
+
+    // Queue one instance of a mesh. instanceData must be instanceStride bytes long.
+    void submit(
+        RenderPipelineId pipeline,
+        RenderMaterialId material,
+        RenderMeshId mesh,
+        std::span<const std::byte> instanceData);
+
+    template<typename TInstance>
+    void submit(
+        RenderPipelineId pipeline,
+        RenderMaterialId material,
+        RenderMeshId mesh,
+        const TInstance& instance)
+    {
+        submit(pipeline, material, mesh, std::as_bytes(std::span(&instance, 1)));
+    }
+
+    // Sort and merge the queued requests, record the resulting draws and empty the queue. Must be
+    // called inside a render pass compatible with the pipelines, once per frame.
+    RenderQueueStats record(vk::CommandBuffer commandBuffer, uint32_t frameIndex);
+
+    [[nodiscard]] const RenderQueueStats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    struct DrawRequest {
+        uint64_t sortKey;
+        uint32_t instanceIndex;
+    };
+
+    struct FrameResources {
+        Buffer instanceBuffer;
+        std::byte* instanceData;
+    };
+
+    vk::Device device_;
+    uint32_t instanceStride_;
+    uint32_t maxInstancesPerFrame_;
+    uint32_t meshBinding_;
+    uint32_t instanceBinding_;
+    uint32_t materialSetIndex_;
+
+    std::vector<RenderPipeline> pipelines_;
+    std::vector<vk::DescriptorSet> materials_;
+    std::vector<RenderMesh> meshes_;
+
+    // Instance data in submission order, reordered into the frame buffer when recording
+    std::vector<std::byte> instanceData_;
+    std::vector<DrawRequest> requests_;
+    std::vector<DrawRequest> sortScratch_;
+    std::vector<FrameResources> frames_;
+    RenderQueueStats stats_;
+};
+
+} // namespace vki
@@ -0,0 +1,549 @@
+#include "Texture.hpp"
+#include "Commands.hpp"
+#include "Ktx2.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+
+namespace vki {
+
+SamplerCache::SamplerCache(vk::Device device)
+    : device_ { device }
+{
+}
+
+[[nodiscard]] vk::Sampler SamplerCache::get(const SamplerCreateInfo& samplerCreateInfo)
+{
+    std::scoped_lock lock(mutex_);
+
+    auto cachedSampler = std::ranges::find(
+        samplers_,
+        samplerCreateInfo,
+        &std::pair<SamplerCreateInfo, vk::UniqueSampler>::first);
+    if (cachedSampler != samplers_.end()) {
+        return *cachedSampler->second;
+    }
+
+    vk::UniqueSampler sampler = device_.createSamplerUnique({
+        .magFilter = samplerCreateInfo.filter,
+        .minFilter = samplerCreateInfo.filter,
+        .mipmapMode = samplerCreateInfo.mipmapMode,
+        .addressModeU = samplerCreateInfo.addressMode,
+        .addressModeV = samplerCreateInfo.addressMode,
+        .addressModeW = samplerCreateInfo.addressMode,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = samplerCreateInfo.maxAnisotropy.has_value(),
+        .maxAnisotropy = samplerCreateInfo.maxAnisotropy.value_or(1.0f),
+        .compareEnable = vk::False,
+        .compareOp = vk::CompareOp::eAlways,
+        .minLod = 0.0f,
+        .maxLod = static_cast<float>(samplerCreateInfo.mipLevels),
+        .borderColor = vk::BorderColor::eIntOpaqueBlack,
+        .unnormalizedCoordinates = vk::False,
+    });
+    vk::Sampler handle = *sampler;
+    samplers_.emplace_back(samplerCreateInfo, std::move(sampler));
+    return handle;
+}
+
+TextureLoader::TextureLoader(const TextureLoaderCreateInfo& textureLoaderCreateInfo)
+    : physicalDevice_ { textureLoaderCreateInfo.physicalDevice }
+    , memoryProperties_ { textureLoaderCreateInfo.physicalDevice.getMemoryProperties() }
+    , device_ { textureLoaderCreateInfo.device }
+    , queue_ { textureLoaderCreateInfo.queue }
+    , queueFamilyIndex_ { textureLoaderCreateInfo.queueFamilyIndex }
+    , samplerCache_ { textureLoaderCreateInfo.device }
+    , decodeThreads_ { textureLoaderCreateInfo.decodeThreadCount }
+{
+}
+
+[[nodiscard]] Texture TextureLoader::load(const TextureCreateInfo& textureCreateInfo)
+{
+    return upload(decode(textureCreateInfo.filename), textureCreateInfo);
+}
+
+[[nodiscard]] std::vector<Texture> TextureLoader::load(
+    std::span<const TextureCreateInfo> textureCreateInfos)
+{
+    std::vector<std::future<DecodedImage>> decodedImages;
+    decodedImages.reserve(textureCreateInfos.size());
+    for (const TextureCreateInfo& textureCreateInfo : textureCreateInfos) {
+        // Copied, the tasks still queued keep running when an upload throws and unwinds the
+        // caller owning the create infos
+        decodedImages.push_back(
+            decodeThreads_.submit([filename = textureCreateInfo.filename] {
+                return decode(filename);
+            }));
+    }
+
+    std::vector<Texture> textures;
+    textures.reserve(textureCreateInfos.size());
+    for (size_t i = 0; i < textureCreateInfos.size(); i++) {
+        textures.push_back(upload(decodedImages[i].get(), textureCreateInfos[i]));
+    }
+    return textures;
+}
+
+[[nodiscard]] TextureLoader::DecodedImage TextureLoader::decode(const std::string& filename)
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc* pixels = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+        throw std::runtime_error(
+            "Failed to decode image " + filename + ": " + stbi_failure_reason());
+    }
+
+    const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    DecodedImage decodedImage {
+        .pixels = std::vector<uint8_t>(pixels, pixels + size),
+        .extent = {
+            .width = static_cast<uint32_t>(width),
+            .height = static_cast<uint32_t>(height),
+        },
+    };
+    stbi_image_free(pixels);
+    return decodedImage;
+}
+
+[[nodiscard]] uint32_t TextureLoader::computeMipLevels(vk::Extent2D extent)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+}
+
+[[nodiscard]] vk::Format TextureLoader::getFormat(TextureColorSpace colorSpace)
+{
+    switch (colorSpace) {
+    case TextureColorSpace::Srgb:
+        return vk::Format::eR8G8B8A8Srgb;
+    case TextureColorSpace::Linear:
+        return vk::Format::eR8G8B8A8Unorm;
+    }
+    throw std::logic_error("Unsupported vki::TextureColorSpace");
+}
+
+[[nodiscard]] bool TextureLoader::supportsLinearBlit(vk::Format format) const
+{
+    using enum vk::FormatFeatureFlagBits;
+    const vk::FormatFeatureFlags requiredFeatures = eBlitSrc | eBlitDst | eSampledImageFilterLinear;
+    const vk::FormatProperties formatProperties = physicalDevice_.getFormatProperties(format);
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+[[nodiscard]] bool TextureLoader::supportsLinearSampling(vk::Format format) const
+{
+    using enum vk::FormatFeatureFlagBits;
+    const vk::FormatFeatureFlags requiredFeatures = eSampledImage | eSampledImageFilterLinear;
+    const vk::FormatProperties formatProperties = physicalDevice_.getFormatProperties(format);
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+[[nodiscard]] static vk::Extent2D getMipExtent(vk::Extent2D extent, uint32_t mipLevel)
+{
+    return {
+        .width = std::max(1u, extent.width >> mipLevel),
+        .height = std::max(1u, extent.height >> mipLevel),
+    };
+}
+
+[[nodiscard]] static float srgbToLinear(uint8_t value)
+{
+    const float normalized = static_cast<float>(value) / 255.0f;
+    return normalized <= 0.04045f ? normalized / 12.92f
+                                  : std::pow((normalized + 0.055f) / 1.055f, 2.4f);
+}
+
+[[nodiscard]] static uint8_t linearToSrgb(float value)
+{
+    const float encoded = value <= 0.0031308f ? value * 12.92f
+                                              : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::clamp(encoded * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+// Box filter an RGBA8 image down to the next mip level. Color channels of sRGB images are
+// averaged in linear space to avoid darkening, alpha is always linear.
+[[nodiscard]] static std::vector<uint8_t> downsample(
+    std::span<const uint8_t> pixels,
+    vk::Extent2D extent,
+    TextureColorSpace colorSpace)
+{
+    static const std::array<float, 256> srgbToLinearTable = [] {
+        std::array<float, 256> table;
+        for (size_t i = 0; i < table.size(); i++) {
+            table[i] = srgbToLinear(static_cast<uint8_t>(i));
+        }
+        return table;
+    }();
+
+    const vk::Extent2D mipExtent = getMipExtent(extent, 1);
+    std::vector<uint8_t> mipPixels(static_cast<size_t>(mipExtent.width) * mipExtent.height * 4);
+    for (uint32_t y = 0; y < mipExtent.height; y++) {
+        for (uint32_t x = 0; x < mipExtent.width; x++) {
+            // Clamp the sampled texels for odd or unit dimensions
+            const uint32_t x0 = std::min(2 * x, extent.width - 1);
+            const uint32_t x1 = std::min(2 * x + 1, extent.width - 1);
+            const uint32_t y0 = std::min(2 * y, extent.height - 1);
+            const uint32_t y1 = std::min(2 * y + 1, extent.height - 1);
+            const std::array<size_t, 4> texels {
+                (static_cast<size_t>(y0) * extent.width + x0) * 4,
+                (static_cast<size_t>(y0) * extent.width + x1) * 4,
+                (static_cast<size_t>(y1) * extent.width + x0) * 4,
+                (static_cast<size_t>(y1) * extent.width + x1) * 4,
+            };
+            const size_t mipTexel = (static_cast<size_t>(y) * mipExtent.width + x) * 4;
+            for (size_t channel = 0; channel < 4; channel++) {
+                const bool isSrgb = colorSpace == TextureColorSpace::Srgb && channel < 3;
+                float sum = 0.0f;
+                for (size_t texel : texels) {
+                    const uint8_t value = pixels[texel + channel];
+                    sum += isSrgb ? srgbToLinearTable[value] : static_cast<float>(value) / 255.0f;
+                }
+                const float average = sum / 4.0f;
+                mipPixels[mipTexel + channel] = isSrgb
+                    ? linearToSrgb(average)
+                    : static_cast<uint8_t>(std::clamp(average * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }
+    return mipPixels;
+}
+
+static void recordMipChainBlits(vk::CommandBuffer commandBuffer, const Image& image)
+{
+    using enum vk::ImageLayout;
+    using enum vk::AccessFlagBits;
+    using Stage = vk::PipelineStageFlagBits;
+
+    for (uint32_t mipLevel = 1; mipLevel < image.mipLevels; mipLevel++) {
+        // The previous level was written by a copy or a blit, make it the blit source
+        transitionMipLevels(
+            commandBuffer,
+            *image.handle,
+            mipLevel - 1,
+            1,
+            eTransferDstOptimal,
+            eTransferSrcOptimal,
+            eTransferWrite,
+            eTransferRead,
+            Stage::eTransfer,
+            Stage::eTransfer);
+
+        const vk::Extent2D srcExtent = getMipExtent(image.extent, mipLevel - 1);
+        const vk::Extent2D dstExtent = getMipExtent(image.extent, mipLevel);
+        vk::ImageBlit blit {
+            .srcSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = mipLevel - 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .srcOffsets = { {
+                vk::Offset3D { 0, 0, 0 },
+                vk::Offset3D {
+                    static_cast<int32_t>(srcExtent.width),
+                    static_cast<int32_t>(srcExtent.height),
+                    1,
+                },
+            } },
+            .dstSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = mipLevel,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .dstOffsets = { {
+                vk::Offset3D { 0, 0, 0 },
+                vk::Offset3D {
+                    static_cast<int32_t>(dstExtent.width),
+                    static_cast<int32_t>(dstExtent.height),
+                    1,
+                },
+            } },
+        };
+        commandBuffer.blitImage(
+            *image.handle,
+            eTransferSrcOptimal,
+            *image.handle,
+            eTransferDstOptimal,
+            { blit },
+            vk::Filter::eLinear);
+    }
+
+    // All levels but the last one are now blit sources
+    transitionMipLevels(
+        commandBuffer,
+        *image.handle,
+        0,
+        image.mipLevels - 1,
+        eTransferSrcOptimal,
+        eShaderReadOnlyOptimal,
+        eTransferRead,
+        eShaderRead,
+        Stage::eTransfer,
+        Stage::eFragmentShader);
+    transitionMipLevels(
+        commandBuffer,
+        *image.handle,
+        image.mipLevels - 1,
+        1,
+        eTransferDstOptimal,
+        eShaderReadOnlyOptimal,
+        eTransferWrite,
+        eShaderRead,
+        Stage::eTransfer,
+        Stage::eFragmentShader);
+}
+
+[[nodiscard]] Texture TextureLoader::upload(
+    const DecodedImage& decodedImage,
+    const TextureCreateInfo& textureCreateInfo)
+{
+    const vk::Format format = getFormat(textureCreateInfo.colorSpace);
+    const uint32_t mipLevels = textureCreateInfo.mipmaps == Option::Enabled
+        ? computeMipLevels(decodedImage.extent)
+        : 1;
+    const bool generateOnGpu = mipLevels > 1 && supportsLinearBlit(format);
+
+    // Mip levels that have to be uploaded, only the base one when the GPU generates the others
+    std::vector<std::vector<uint8_t>> cpuMipLevels;
+    if (mipLevels > 1 && !generateOnGpu) {
+        spdlog::debug(
+            "Format {} does not support linear blits, generating mip chain of {} on CPU",
+            vk::to_string(format),
+            textureCreateInfo.filename);
+        cpuMipLevels.reserve(mipLevels - 1);
+        std::span<const uint8_t> previousLevel = decodedImage.pixels;
+        for (uint32_t mipLevel = 1; mipLevel < mipLevels; mipLevel++) {
+            cpuMipLevels.push_back(downsample(
+                previousLevel,
+                getMipExtent(decodedImage.extent, mipLevel - 1),
+                textureCreateInfo.colorSpace));
+            previousLevel = cpuMipLevels.back();
+        }
+    }
+
+    std::vector<std::span<const uint8_t>> uploadedLevels { decodedImage.pixels };
+    uploadedLevels.insert(uploadedLevels.end(), cpuMipLevels.begin(), cpuMipLevels.end());
+
+    // Pack all uploaded levels in a single staging buffer, with one copy region per level
+    vk::DeviceSize stagingSize = 0;
+    std::vector<vk::BufferImageCopy> copyRegions;
+    for (uint32_t mipLevel = 0; mipLevel < uploadedLevels.size(); mipLevel++) {
+        const vk::Extent2D mipExtent = getMipExtent(decodedImage.extent, mipLevel);
+        copyRegions.push_back({
+            .bufferOffset = stagingSize,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = mipLevel,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = { 0, 0, 0 },
+            .imageExtent = { mipExtent.width, mipExtent.height, 1 },
+        });
+        stagingSize += uploadedLevels[mipLevel].size();
+    }
+
+    using enum vk::MemoryPropertyFlagBits;
+    Buffer stagingBuffer = Buffer::make(
+        device_,
+        memoryProperties_,
+        {
+            .size = stagingSize,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+            .memoryProperties = eHostVisible | eHostCoherent,
+        });
+    void* stagingData = device_.mapMemory(*stagingBuffer.memory, 0, stagingSize);
+    for (size_t i = 0; i < uploadedLevels.size(); i++) {
+        std::memcpy(
+            static_cast<uint8_t*>(stagingData) + copyRegions[i].bufferOffset,
+            uploadedLevels[i].data(),
+            uploadedLevels[i].size());
+    }
+    device_.unmapMemory(*stagingBuffer.memory);
+
+    using enum vk::ImageUsageFlagBits;
+    Image image = Image::make(
+        device_,
+        memoryProperties_,
+        {
+            .format = format,
+            .extent = decodedImage.extent,
+            .mipLevels = mipLevels,
+            .usage = eTransferSrc | eTransferDst | eSampled,
+            .memoryProperties = eDeviceLocal,
+        });
+
+    submitImmediate(device_, queue_, queueFamilyIndex_, [&](vk::CommandBuffer commandBuffer) {
+        using enum vk::ImageLayout;
+        using enum vk::AccessFlagBits;
+        using Stage = vk::PipelineStageFlagBits;
+        transitionMipLevels(
+            commandBuffer,
+            *image.handle,
+            0,
+            mipLevels,
+            eUndefined,
+            eTransferDstOptimal,
+            {},
+            eTransferWrite,
+            Stage::eTopOfPipe,
+            Stage::eTransfer);
+        commandBuffer.copyBufferToImage(
+            *stagingBuffer.handle,
+            *image.handle,
+            eTransferDstOptimal,
+            copyRegions);
+        if (generateOnGpu) {
+            recordMipChainBlits(commandBuffer, image);
+        } else {
+            transitionMipLevels(
+                commandBuffer,
+                *image.handle,
+                0,
+                mipLevels,
+                eTransferDstOptimal,
+                eShaderReadOnlyOptimal,
+                eTransferWrite,
+                eShaderRead,
+                Stage::eTransfer,
+                Stage::eFragmentShader);
+        }
+    });
+
+    vk::UniqueImageView view = image.makeView(device_);
+
+    SamplerCreateInfo samplerCreateInfo = textureCreateInfo.sampler;
+    samplerCreateInfo.mipLevels = mipLevels;
+
+    spdlog::debug(
+        "Loaded texture {} ({}x{}, {} mip levels)",
+        textureCreateInfo.filename,
+        decodedImage.extent.width,
+        decodedImage.extent.height,
+        mipLevels);
+
+    return {
+        .image = std::move(image),
+        .view = std::move(view),
+        .sampler = samplerCache_.get(samplerCreateInfo),
+    };
+}
+
+[[nodiscard]] Texture TextureLoader::loadCompressed(
+    const CompressedTextureCreateInfo& compressedTextureCreateInfo)
+{
+    // Only read the headers to select the file, the chosen one is then fully loaded
+    auto selectedFilename = std::ranges::find_if(
+        compressedTextureCreateInfo.candidateFilenames,
+        [this](const std::string& filename) {
+            const vk::Format format = Ktx2Header::readFile(filename).format;
+            const bool isSupported = supportsLinearSampling(format);
+            spdlog::debug(
+                "Compressed texture {} uses format {}, {}",
+                filename,
+                vk::to_string(format),
+                isSupported ? "supported" : "not supported");
+            return isSupported;
+        });
+    if (selectedFilename == compressedTextureCreateInfo.candidateFilenames.end()) {
+        throw std::runtime_error("No compressed texture candidate has a supported format");
+    }
+
+    const Ktx2Image ktx2Image = Ktx2Image::readFile(*selectedFilename);
+    const std::span<const std::byte> levelData = ktx2Image.levelData();
+
+    using enum vk::MemoryPropertyFlagBits;
+    Buffer stagingBuffer = Buffer::make(
+        device_,
+        memoryProperties_,
+        {
+            .size = levelData.size(),
+            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+            .memoryProperties = eHostVisible | eHostCoherent,
+        });
+    void* stagingData = device_.mapMemory(*stagingBuffer.memory, 0, levelData.size());
+    std::memcpy(stagingData, levelData.data(), levelData.size());
+    device_.unmapMemory(*stagingBuffer.memory);
+
+    using enum vk::ImageUsageFlagBits;
+    Image image = Image::make(
+        device_,
+        memoryProperties_,
+        {
+            .format = ktx2Image.header.format,
+            .extent = ktx2Image.extent(),
+            .mipLevels = ktx2Image.mipLevels(),
+            .usage = eTransferDst | eSampled,
+            .memoryProperties = eDeviceLocal,
+        });
+
+    const std::vector<vk::BufferImageCopy> copyRegions = ktx2Image.copyRegions(0);
+    submitImmediate(device_, queue_, queueFamilyIndex_, [&](vk::CommandBuffer commandBuffer) {
+        using enum vk::ImageLayout;
+        using enum vk::AccessFlagBits;
+        using Stage = vk::PipelineStageFlagBits;
+        transitionMipLevels(
+            commandBuffer,
+            *image.handle,
+            0,
+            image.mipLevels,
+            eUndefined,
+            eTransferDstOptimal,
+            {},
+            eTransferWrite,
+            Stage::eTopOfPipe,
+            Stage::eTransfer);
+        // All the mip levels in a single copy
+        commandBuffer.copyBufferToImage(
+            *stagingBuffer.handle,
+            *image.handle,
+            eTransferDstOptimal,
+            copyRegions);
+        transitionMipLevels(
+            commandBuffer,
+            *image.handle,
+            0,
+            image.mipLevels,
+            eTransferDstOptimal,
+            eShaderReadOnlyOptimal,
+            eTransferWrite,
+            eShaderRead,
+            Stage::eTransfer,
+            Stage::eFragmentShader);
+    });
+
+    vk::UniqueImageView view = image.makeView(device_);
+
+    SamplerCreateInfo samplerCreateInfo = compressedTextureCreateInfo.sampler;
+    samplerCreateInfo.mipLevels = image.mipLevels;
+
+    spdlog::debug(
+        "Loaded compressed texture {} ({}x{}, {} mip levels, {} bytes)",
+        *selectedFilename,
+        image.extent.width,
+        image.extent.height,
+        image.mipLevels,
+        levelData.size());
+
+    return {
+        .image = std::move(image),
+        .view = std::move(view),
+        .sampler = samplerCache_.get(samplerCreateInfo),
+    };
+}
+
+} // namespace vki
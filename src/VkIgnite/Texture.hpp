@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Memory.hpp"
+#include "Types.hpp"
+
+#include "Stdx/ThreadPool.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vki {
+
+// How the texel values of an image must be interpreted
+enum class TextureColorSpace {
+    // Color data authored in sRGB (albedo, UI), decoded to linear by the sampler
+    Srgb,
+    // Non-color data (normal maps, roughness, masks), sampled as is
+    Linear,
+};
+
+struct SamplerCreateInfo {
+    vk::Filter filter = vk::Filter::eLinear;
+    vk::SamplerMipmapMode mipmapMode = vk::SamplerMipmapMode::eLinear;
+    vk::SamplerAddressMode addressMode = vk::SamplerAddressMode::eRepeat;
+    // Number of mip levels reachable through the sampler
+    uint32_t mipLevels = 1;
+    // Anisotropy level, or nullopt to disable it. Requires the samplerAnisotropy feature.
+    std::optional<float> maxAnisotropy = std::nullopt;
+
+    [[nodiscard]] bool operator==(const SamplerCreateInfo&) const = default;
+};
+
+// Samplers are immutable and only a handful of distinct ones are typically used, so they are
+// shared between textures instead of being created per texture.
+class SamplerCache {
+public:
+    explicit SamplerCache(vk::Device device);
+
+    // Get the sampler matching the create info, creating it on first use. Thread-safe.
+    [[nodiscard]] vk::Sampler get(const SamplerCreateInfo& samplerCreateInfo);
+
+private:
+    vk::Device device_;
+    std::mutex mutex_;
+    std::vector<std::pair<SamplerCreateInfo, vk::UniqueSampler>> samplers_;
+};
+
+struct TextureCreateInfo {
+    std::string filename = {};
+    TextureColorSpace colorSpace = TextureColorSpace::Srgb;
+    // Whether to generate the full mip chain
+    Option mipmaps = Option::Enabled;
+    // Sampler parameters, its mip level count is overridden by the texture's one
+    SamplerCreateInfo sampler = {};
+};
+
+struct CompressedTextureCreateInfo {
+    // KTX2 files holding the same texture in different block-compressed formats (BC7, ASTC,
+    // ETC2...), by order of preference. The first one whose format can be sampled by the physical
+    // device is loaded.
+    std::vector<std::string> candidateFilenames = {};
+    // Sampler parameters, its mip level count is overridden by the texture's one
+    SamplerCreateInfo sampler = {};
+};
+
+struct Texture {
+    Image image;
+    vk::UniqueImageView view;
+    vk::Sampler sampler;
+};
+
+struct TextureLoaderCreateInfo {
+    vk::PhysicalDevice physicalDevice;
+    vk::Device device;
+    // Queue used for uploads, must support graphics operations for the mip chain blits
+    vk::Queue queue;
+    QueueFamilyIndex queueFamilyIndex;
+    // Number of threads decoding images
+    size_t decodeThreadCount = stdx::ThreadPool::defaultThreadCount();
+};
+
+// Load textures from image files (PNG, JPEG, TGA, BMP...) into sampled 2D images.
+//
+// Images are decoded to RGBA8 on worker threads, then uploaded through a staging buffer into
+// optimally tiled device local images. The mip chain is generated on the GPU with linear blits
+// when the format supports linear filtering, and on the CPU otherwise.
+//
+// Pre-compressed KTX2 textures are uploaded as is with all their mip levels, saving VRAM and
+// upload bandwidth compared to RGBA8.
+class TextureLoader {
+public:
+    explicit TextureLoader(const TextureLoaderCreateInfo& textureLoaderCreateInfo);
+
+    [[nodiscard]] Texture load(const TextureCreateInfo& textureCreateInfo);
+
+    // Load several textures, decoding them in parallel. The upload of a texture overlaps with the
+    // decoding of the following ones.
+    [[nodiscard]] std::vector<Texture> load(std::span<const TextureCreateInfo> textureCreateInfos);
+
+    [[nodiscard]] Texture loadCompressed(
+        const CompressedTextureCreateInfo& compressedTextureCreateInfo);
+
+    [[nodiscard]] SamplerCache& samplerCache()
+    {
+        return samplerCache_;
+    }
+
+    // Decoded RGBA8 pixels
+    struct DecodedImage {
+        std::vector<uint8_t> pixels;
+        vk::Extent2D extent;
+    };
+
+    [[nodiscard]] static DecodedImage decode(const std::string& filename);
+
+    [[nodiscard]] static uint32_t computeMipLevels(vk::Extent2D extent);
+
+    [[nodiscard]] static vk::Format getFormat(TextureColorSpace colorSpace);
+
+private:
+    [[nodiscard]] Texture upload(
+        const DecodedImage& decodedImage,
+        const TextureCreateInfo& textureCreateInfo);
+
+    [[nodiscard]] bool supportsLinearBlit(vk::Format format) const;
+
+    [[nodiscard]] bool supportsLinearSampling(vk::Format format) const;
+
+    vk::PhysicalDevice physicalDevice_;
+    vk::PhysicalDeviceMemoryProperties memoryProperties_;
+    vk::Device device_;
+    vk::Queue queue_;
+    QueueFamilyIndex queueFamilyIndex_;
+    SamplerCache samplerCache_;
+    stdx::ThreadPool decodeThreads_;
+};
+
+} // namespace vki
@@ -0,0 +1,519 @@
+#include "TextureStreamer.hpp"
+#include "Commands.hpp"
+
+#include "Pch/Spdlog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+
+namespace vki {
+
+[[nodiscard]] static vk::DeviceSize getLargestDeviceLocalHeapSize(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties)
+{
+    vk::DeviceSize largestHeapSize = 0;
+    for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; heapIndex++) {
+        const vk::MemoryHeap& heap = memoryProperties.memoryHeaps[heapIndex];
+        if (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+            largestHeapSize = std::max(largestHeapSize, heap.size);
+        }
+    }
+    return largestHeapSize;
+}
+
+[[nodiscard]] static vk::Extent2D getLevelExtent(const Ktx2Image& source, uint32_t mipLevel)
+{
+    return {
+        .width = std::max(1u, source.header.pixelWidth >> mipLevel),
+        .height = std::max(1u, source.header.pixelHeight >> mipLevel),
+    };
+}
+
+// Image holding the levels of the source from baseLevel to the last one
+[[nodiscard]] static ImageCreateInfo getImageCreateInfo(const Ktx2Image& source, uint32_t baseLevel)
+{
+    using enum vk::ImageUsageFlagBits;
+    return {
+        .format = source.header.format,
+        .extent = getLevelExtent(source, baseLevel),
+        .mipLevels = source.mipLevels() - baseLevel,
+        .usage = eTransferDst | eSampled,
+        .memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+    };
+}
+
+TextureStreamer::TextureStreamer(const TextureStreamerCreateInfo& textureStreamerCreateInfo)
+    : physicalDevice_ { textureStreamerCreateInfo.physicalDevice }
+    , memoryProperties_ { textureStreamerCreateInfo.physicalDevice.getMemoryProperties() }
+    , device_ { textureStreamerCreateInfo.device }
+    , queue_ { textureStreamerCreateInfo.queue }
+    , queueFamilyIndex_ { textureStreamerCreateInfo.queueFamilyIndex }
+    , memoryBudgetEXT_ { textureStreamerCreateInfo.memoryBudgetEXT }
+    , fallbackBudget_ { textureStreamerCreateInfo.fallbackBudget != 0
+                            ? textureStreamerCreateInfo.fallbackBudget
+                            : getLargestDeviceLocalHeapSize(memoryProperties_) / 2 }
+    , mipTailExtent_ { textureStreamerCreateInfo.mipTailExtent }
+    , maxPendingRequests_ { textureStreamerCreateInfo.maxPendingRequests }
+    , framesInFlight_ { textureStreamerCreateInfo.framesInFlight }
+    , samplerCache_ { textureStreamerCreateInfo.device }
+    , streamingThread_ { [this](std::stop_token stopToken) { streamingLoop(stopToken); } }
+{
+    // The streaming thread is already running
+    std::scoped_lock lock(mutex_);
+    requests_.reserve(maxPendingRequests_);
+    results_.reserve(maxPendingRequests_);
+    appliedResults_.reserve(maxPendingRequests_);
+}
+
+TextureStreamer::~TextureStreamer() = default;
+
+[[nodiscard]] StreamedTextureId TextureStreamer::add(
+    const std::string& filename,
+    const SamplerCreateInfo& samplerCreateInfo)
+{
+    auto texture = std::make_unique<StreamedTexture>(StreamedTexture {
+        .source = Ktx2Image::readFile(filename),
+        .mipTailBaseLevel = 0,
+        .desiredBaseLevel = 0,
+        .samplerCreateInfo = samplerCreateInfo,
+        .residentSizes = {},
+        .residentBaseLevel = 0,
+        .image = {},
+        .view = {},
+        .sampler = {},
+    });
+
+    // The mip tail starts at the first level fitting in the tail extent
+    const uint32_t mipLevels = texture->source.mipLevels();
+    texture->mipTailBaseLevel = mipLevels - 1;
+    for (uint32_t mipLevel = 0; mipLevel < mipLevels; mipLevel++) {
+        const vk::Extent2D extent = getLevelExtent(texture->source, mipLevel);
+        if (extent.width <= mipTailExtent_ && extent.height <= mipTailExtent_) {
+            texture->mipTailBaseLevel = mipLevel;
+            break;
+        }
+    }
+    texture->desiredBaseLevel = texture->mipTailBaseLevel;
+
+    // Budget checks compare these sizes to the resident allocations, so they are measured the
+    // same way rather than from the size of the level data
+    for (uint32_t baseLevel = 0; baseLevel <= texture->mipTailBaseLevel; baseLevel++) {
+        texture->residentSizes.push_back(
+            Image::getMemoryRequirements(device_, getImageCreateInfo(texture->source, baseLevel))
+                .size);
+    }
+
+    ResidencyResult mipTail = upload(*texture, texture->mipTailBaseLevel);
+    texture->residentBaseLevel = mipTail.baseLevel;
+    texture->image = std::move(mipTail.image);
+    texture->view = std::move(mipTail.view);
+    residentBytes_ += texture->image.allocationSize;
+
+    SamplerCreateInfo fullChainSamplerCreateInfo = samplerCreateInfo;
+    fullChainSamplerCreateInfo.mipLevels = mipLevels;
+    texture->samplerCreateInfo = fullChainSamplerCreateInfo;
+    texture->sampler = samplerCache_.get(fullChainSamplerCreateInfo);
+
+    spdlog::debug(
+        "Streamed texture {} added with {} of its {} mip levels resident",
+        filename,
+        mipLevels - texture->mipTailBaseLevel,
+        mipLevels);
+
+    textures_.push_back(std::move(texture));
+    return static_cast<StreamedTextureId>(textures_.size() - 1);
+}
+
+void TextureStreamer::request(StreamedTextureId textureId, float projectedSize)
+{
+    StreamedTexture& texture = *textures_.at(textureId);
+
+    // Keep the largest size if the texture is drawn several times in the frame
+    if (texture.lastRequestedFrame != frame_) {
+        texture.projectedSize = 0.0f;
+    }
+    texture.projectedSize = std::max(texture.projectedSize, projectedSize);
+    texture.lastRequestedFrame = frame_;
+
+    // One texel per pixel is reached at the level whose size matches the projected size
+    const vk::Extent2D extent = getLevelExtent(texture.source, 0);
+    const float baseSize = static_cast<float>(std::max(extent.width, extent.height));
+    const float texelsPerPixel = baseSize / std::max(texture.projectedSize, 1.0f);
+    const float level = std::floor(std::log2(std::max(texelsPerPixel, 1.0f)));
+    texture.desiredBaseLevel = std::min(static_cast<uint32_t>(level), texture.mipTailBaseLevel);
+}
+
+[[nodiscard]] StreamedTextureView TextureStreamer::view(StreamedTextureId textureId) const
+{
+    const StreamedTexture& texture = *textures_.at(textureId);
+    return {
+        .view = *texture.view,
+        .sampler = texture.sampler,
+        .residentBaseLevel = texture.residentBaseLevel,
+    };
+}
+
+void TextureStreamer::update(stdx::LinearArena& frameArena)
+{
+    stdx::LinearArenaResource frameMemoryResource { frameArena };
+
+    stats_ = TextureResidencyStats { .frame = frame_ };
+
+    // Destroy the images no frame in flight can use anymore
+    while (!retiredImages_.empty()
+           && retiredImages_.front().retireFrame + framesInFlight_ <= frame_) {
+        retiredImages_.pop_front();
+    }
+
+    applyResults();
+
+    const vk::DeviceSize budget = getBudget();
+    if (getProjectedResidentBytes() > budget) {
+        evictUntil(budget, 0, &frameMemoryResource);
+    }
+    scheduleRequests(budget, &frameMemoryResource);
+
+    stats_.textureCount = textures_.size();
+    stats_.fullyResidentCount = static_cast<size_t>(
+        std::ranges::count(textures_, 0u, [](const std::unique_ptr<StreamedTexture>& texture) {
+            return texture->residentBaseLevel;
+        }));
+    stats_.residentBytes = residentBytes_;
+    stats_.budgetBytes = budget;
+
+    if (stats_.completedUploads > 0 || stats_.queuedUploads > 0 || stats_.evictions > 0
+        || stats_.failedUploads > 0) {
+        spdlog::debug(
+            "Texture residency (frame {}): {}/{} fully resident, {}/{} MiB, {} uploads completed "
+            "({} KiB), {} queued, {} evictions, {} failed",
+            stats_.frame,
+            stats_.fullyResidentCount,
+            stats_.textureCount,
+            stats_.residentBytes / (1024 * 1024),
+            stats_.budgetBytes / (1024 * 1024),
+            stats_.completedUploads,
+            stats_.uploadedBytes / 1024,
+            stats_.queuedUploads,
+            stats_.evictions,
+            stats_.failedUploads);
+    }
+
+    frame_++;
+}
+
+void TextureStreamer::applyResults()
+{
+    {
+        std::scoped_lock lock(mutex_);
+        appliedResults_.swap(results_);
+    }
+
+    for (ResidencyResult& result : appliedResults_) {
+        StreamedTexture& texture = *textures_[result.textureId];
+        texture.hasPendingRequest = false;
+        pendingRequestCount_--;
+        pendingResidentDelta_ -= getResidentDelta(texture, result.baseLevel);
+        if (result.failed) {
+            texture.retryFrame = frame_ + kFailedRequestRetryDelay;
+            stats_.failedUploads++;
+            continue;
+        }
+
+        residentBytes_ -= texture.image.allocationSize;
+        residentBytes_ += result.image.allocationSize;
+        retiredImages_.push_back({
+            .retireFrame = frame_,
+            .image = std::move(texture.image),
+            .view = std::move(texture.view),
+        });
+        texture.residentBaseLevel = result.baseLevel;
+        texture.image = std::move(result.image);
+        texture.view = std::move(result.view);
+
+        stats_.completedUploads++;
+        stats_.uploadedBytes += result.uploadedBytes;
+    }
+    appliedResults_.clear();
+}
+
+[[nodiscard]] vk::DeviceSize TextureStreamer::getBudget() const
+{
+    if (memoryBudgetEXT_ == Option::Disabled) {
+        return fallbackBudget_;
+    }
+
+    auto memoryProperties = physicalDevice_.getMemoryProperties2<
+        vk::PhysicalDeviceMemoryProperties2,
+        vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+    const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budgetProperties
+        = memoryProperties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+    vk::DeviceSize heapBudget = 0;
+    vk::DeviceSize heapUsage = 0;
+    for (uint32_t heapIndex = 0; heapIndex < memoryProperties_.memoryHeapCount; heapIndex++) {
+        if (memoryProperties_.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+            heapBudget += budgetProperties.heapBudget[heapIndex];
+            heapUsage += budgetProperties.heapUsage[heapIndex];
+        }
+    }
+
+    // The reported usage includes the streamed textures, which share what is left of the budget
+    // once the rest of the process and the other applications are accounted for
+    const vk::DeviceSize otherUsage = heapUsage - std::min(heapUsage, residentBytes_);
+    return heapBudget > otherUsage ? heapBudget - otherUsage : 0;
+}
+
+[[nodiscard]] vk::DeviceSize TextureStreamer::getResidentSize(
+    const StreamedTexture& texture,
+    uint32_t baseLevel)
+{
+    return texture.residentSizes[baseLevel];
+}
+
+[[nodiscard]] int64_t TextureStreamer::getResidentDelta(
+    const StreamedTexture& texture,
+    uint32_t baseLevel)
+{
+    return static_cast<int64_t>(getResidentSize(texture, baseLevel))
+        - static_cast<int64_t>(getResidentSize(texture, texture.residentBaseLevel));
+}
+
+[[nodiscard]] vk::DeviceSize TextureStreamer::getProjectedResidentBytes() const
+{
+    return static_cast<vk::DeviceSize>(
+        static_cast<int64_t>(residentBytes_) + pendingResidentDelta_);
+}
+
+void TextureStreamer::queueRequest(StreamedTextureId textureId, uint32_t baseLevel)
+{
+    StreamedTexture& texture = *textures_[textureId];
+    texture.hasPendingRequest = true;
+    pendingRequestCount_++;
+    pendingResidentDelta_ += getResidentDelta(texture, baseLevel);
+    {
+        std::scoped_lock lock(mutex_);
+        requests_.push_back({
+            .textureId = textureId,
+            .texture = &texture,
+            .baseLevel = baseLevel,
+        });
+    }
+    requestsAvailable_.notify_one();
+}
+
+void TextureStreamer::evictUntil(
+    vk::DeviceSize budget,
+    vk::DeviceSize requiredBytes,
+    std::pmr::memory_resource* memoryResource)
+{
+    // Least recently used textures first, never the ones drawn this frame
+    std::pmr::vector<StreamedTextureId> candidates(memoryResource);
+    for (StreamedTextureId textureId = 0; textureId < textures_.size(); textureId++) {
+        const StreamedTexture& texture = *textures_[textureId];
+        if (!texture.hasPendingRequest && texture.retryFrame <= frame_
+            && texture.lastRequestedFrame != frame_
+            && texture.residentBaseLevel < texture.mipTailBaseLevel) {
+            candidates.push_back(textureId);
+        }
+    }
+    std::ranges::sort(candidates, {}, [this](StreamedTextureId textureId) {
+        return textures_[textureId]->lastRequestedFrame;
+    });
+
+    // The memory is only released once the eviction completes, the evictions still pending are
+    // accounted for so that the next calls and frames do not evict more
+    for (StreamedTextureId textureId : candidates) {
+        if (getProjectedResidentBytes() + requiredBytes <= budget
+            || pendingRequestCount_ >= maxPendingRequests_) {
+            break;
+        }
+        queueRequest(textureId, textures_[textureId]->mipTailBaseLevel);
+        stats_.evictions++;
+    }
+}
+
+void TextureStreamer::scheduleRequests(
+    vk::DeviceSize budget,
+    std::pmr::memory_resource* memoryResource)
+{
+    std::pmr::vector<StreamedTextureId> candidates(memoryResource);
+    for (StreamedTextureId textureId = 0; textureId < textures_.size(); textureId++) {
+        const StreamedTexture& texture = *textures_[textureId];
+        if (!texture.hasPendingRequest && texture.retryFrame <= frame_
+            && texture.lastRequestedFrame == frame_
+            && texture.desiredBaseLevel < texture.residentBaseLevel) {
+            candidates.push_back(textureId);
+        }
+    }
+
+    // Most undersampled textures first: the ones whose resident base level covers the fewest
+    // texels per pixel on screen
+    const auto undersampling = [this](StreamedTextureId textureId) {
+        const StreamedTexture& texture = *textures_[textureId];
+        const vk::Extent2D extent = getLevelExtent(texture.source, texture.residentBaseLevel);
+        return texture.projectedSize / static_cast<float>(std::max(extent.width, extent.height));
+    };
+    std::ranges::sort(candidates, std::ranges::greater {}, undersampling);
+
+    for (StreamedTextureId textureId : candidates) {
+        if (pendingRequestCount_ >= maxPendingRequests_) {
+            break;
+        }
+        StreamedTexture& texture = *textures_[textureId];
+        const vk::DeviceSize requiredBytes = getResidentSize(texture, texture.desiredBaseLevel)
+            - getResidentSize(texture, texture.residentBaseLevel);
+        // The uploads still pending count against the budget too
+        if (getProjectedResidentBytes() + requiredBytes > budget) {
+            evictUntil(budget, requiredBytes, memoryResource);
+            // Evicted memory becomes available in a later frame, retry then
+            continue;
+        }
+        queueRequest(textureId, texture.desiredBaseLevel);
+        stats_.queuedUploads++;
+    }
+}
+
+void TextureStreamer::streamingLoop(std::stop_token stopToken)
+{
+    while (true) {
+        ResidencyRequest request;
+        {
+            std::unique_lock lock(mutex_);
+            requestsAvailable_.wait(lock, stopToken, [this] { return !requests_.empty(); });
+            if (stopToken.stop_requested()) {
+                return;
+            }
+            request = requests_.front();
+            requests_.erase(requests_.begin());
+        }
+
+        // A failed upload must still be reported, so that the request is no longer pending and
+        // can be retried later
+        ResidencyResult result;
+        try {
+            result = upload(*request.texture, request.baseLevel);
+        } catch (const std::exception& exception) {
+            spdlog::error(
+                "Failed to make mip levels {}+ of streamed texture {} resident: {}",
+                request.baseLevel,
+                request.textureId,
+                exception.what());
+            result = ResidencyResult {
+                .textureId = 0,
+                .baseLevel = request.baseLevel,
+                .image = {},
+                .view = {},
+                .uploadedBytes = 0,
+                .failed = true,
+            };
+        }
+        result.textureId = request.textureId;
+
+        std::scoped_lock lock(mutex_);
+        results_.push_back(std::move(result));
+    }
+}
+
+[[nodiscard]] TextureStreamer::ResidencyResult TextureStreamer::upload(
+    const StreamedTexture& texture,
+    uint32_t baseLevel)
+{
+    const Ktx2Image& source = texture.source;
+    const uint32_t mipLevels = source.mipLevels() - baseLevel;
+
+    // Resident levels are contiguous in the file, copy them all at once in the staging buffer
+    uint64_t dataBegin = std::numeric_limits<uint64_t>::max();
+    uint64_t dataEnd = 0;
+    for (uint32_t mipLevel = baseLevel; mipLevel < source.mipLevels(); mipLevel++) {
+        dataBegin = std::min(dataBegin, source.levels[mipLevel].byteOffset);
+        dataEnd = std::max(
+            dataEnd,
+            source.levels[mipLevel].byteOffset + source.levels[mipLevel].byteLength);
+    }
+    const vk::DeviceSize dataSize = dataEnd - dataBegin;
+
+    std::vector<vk::BufferImageCopy> copyRegions;
+    for (uint32_t mipLevel = baseLevel; mipLevel < source.mipLevels(); mipLevel++) {
+        const vk::Extent2D extent = getLevelExtent(source, mipLevel);
+        copyRegions.push_back({
+            .bufferOffset = source.levels[mipLevel].byteOffset - dataBegin,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = mipLevel - baseLevel,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = { 0, 0, 0 },
+            .imageExtent = { extent.width, extent.height, 1 },
+        });
+    }
+
+    using enum vk::MemoryPropertyFlagBits;
+    Buffer stagingBuffer = Buffer::make(
+        device_,
+        memoryProperties_,
+        {
+            .size = dataSize,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc,
+            .memoryProperties = eHostVisible | eHostCoherent,
+        });
+    void* stagingData = device_.mapMemory(*stagingBuffer.memory, 0, dataSize);
+    std::memcpy(stagingData, source.data.data() + dataBegin, dataSize);
+    device_.unmapMemory(*stagingBuffer.memory);
+
+    Image image = Image::make(device_, memoryProperties_, getImageCreateInfo(source, baseLevel));
+
+    {
+        // The queue is shared between the streaming thread and add()
+        std::scoped_lock lock(queueMutex_);
+        submitImmediate(device_, queue_, queueFamilyIndex_, [&](vk::CommandBuffer commandBuffer) {
+            using enum vk::ImageLayout;
+            using enum vk::AccessFlagBits;
+            using Stage = vk::PipelineStageFlagBits;
+            transitionMipLevels(
+                commandBuffer,
+                *image.handle,
+                0,
+                mipLevels,
+                eUndefined,
+                eTransferDstOptimal,
+                {},
+                eTransferWrite,
+                Stage::eTopOfPipe,
+                Stage::eTransfer);
+            commandBuffer.copyBufferToImage(
+                *stagingBuffer.handle,
+                *image.handle,
+                eTransferDstOptimal,
+                copyRegions);
+            transitionMipLevels(
+                commandBuffer,
+                *image.handle,
+                0,
+                mipLevels,
+                eTransferDstOptimal,
+                eShaderReadOnlyOptimal,
+                eTransferWrite,
+                eShaderRead,
+                Stage::eTransfer,
+                Stage::eFragmentShader);
+        });
+    }
+
+    vk::UniqueImageView view = image.makeView(device_);
+    return {
+        .textureId = 0,
+        .baseLevel = baseLevel,
+        .image = std::move(image),
+        .view = std::move(view),
+        .uploadedBytes = dataSize,
+        .failed = false,
+    };
+}
+
+} // namespace vki
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Ktx2.hpp"
+#include "Memory.hpp"
+#include "Texture.hpp"
+#include "Types.hpp"
+
+#include "Stdx/LinearArena.hpp"
+
+#include "Pch/Vulkan.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vki {
+
+using StreamedTextureId = uint32_t;
+
+struct TextureStreamerCreateInfo {
+    vk::PhysicalDevice physicalDevice;
+    vk::Device device;
+    // Queue reserved to the streamer, used by add() and the streaming thread. Its family must be
+    // the one sampling the textures, no queue family ownership transfer is performed.
+    vk::Queue queue;
+    QueueFamilyIndex queueFamilyIndex;
+    // Whether VK_EXT_memory_budget was enabled on the device. If so the budget follows the one
+    // reported by the driver, otherwise fallbackBudget is used.
+    Option memoryBudgetEXT = Option::Disabled;
+    // VRAM budget in bytes when VK_EXT_memory_budget is not available, 0 to use half of the
+    // largest device local heap
+    vk::DeviceSize fallbackBudget = 0;
+    // Mip levels whose width and height are both below this size form the mip tail, which is
+    // loaded when the texture is added and is never evicted
+    uint32_t mipTailExtent = 64;
+    // Maximum number of residency changes queued to the streaming thread at once
+    uint32_t maxPendingRequests = 4;
+    // Number of frames that may still use a replaced image
+    uint32_t framesInFlight = 2;
+};
+
+// What must be bound to sample a streamed texture this frame
+struct StreamedTextureView {
+    vk::ImageView view;
+    vk::Sampler sampler;
+    // Most detailed mip level of the texture that is currently resident
+    uint32_t residentBaseLevel;
+};
+
+struct TextureResidencyStats {
+    uint64_t frame = 0;
+    size_t textureCount = 0;
+    size_t fullyResidentCount = 0;
+    vk::DeviceSize residentBytes = 0;
+    vk::DeviceSize budgetBytes = 0;
+    // Per frame counters
+    uint32_t completedUploads = 0;
+    uint32_t queuedUploads = 0;
+    uint32_t evictions = 0;
+    uint32_t failedUploads = 0;
+    vk::DeviceSize uploadedBytes = 0;
+};
+
+// Stream the mip levels of KTX2 textures in and out of VRAM depending on how large they appear on
+// screen.
+//
+// When added, only the mip tail of a texture is loaded. Every frame, the application reports the
+// projected screen-space size of the textures it draws with request(), and update() schedules the
+// more detailed levels on a background thread, the most undersampled textures first. When the
+// VRAM budget is exceeded, the high mip levels of the least recently used textures are evicted.
+//
+// Partially resident textures are regular images only holding the resident levels. A residency
+// change creates a new image which is uploaded entirely from the CPU copy of the file, so the
+// image in use by the GPU is never accessed by the streaming queue. The previous image is
+// destroyed once the frames in flight that may use it have retired.
+class TextureStreamer {
+public:
+    explicit TextureStreamer(const TextureStreamerCreateInfo& textureStreamerCreateInfo);
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    ~TextureStreamer();
+
+    // Add a texture and synchronously load its mip tail
+    [[nodiscard]] StreamedTextureId add(
+        const std::string& filename,
+        const SamplerCreateInfo& samplerCreateInfo = {});
+
+    // Report that the texture is drawn this frame, with the size in pixels its largest dimension
+    // covers on screen
+    void request(StreamedTextureId textureId, float projectedSize);
+
+    // Apply completed uploads, evict under memory pressure and schedule new uploads.
+    // Must be called once per frame, before getting the views to bind. The temporaries of the
+    // update are allocated from frameArena, which may be reset as soon as update() returns.
+    void update(stdx::LinearArena& frameArena);
+
+    [[nodiscard]] StreamedTextureView view(StreamedTextureId textureId) const;
+
+    [[nodiscard]] const TextureResidencyStats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    struct StreamedTexture {
+        Ktx2Image source;
+        uint32_t mipTailBaseLevel;
+        // Level to reach according to the last reported screen size
+        uint32_t desiredBaseLevel;
+        float projectedSize = 0.0f;
+        uint64_t lastRequestedFrame = 0;
+        bool hasPendingRequest = false;
+        // Frame before which no residency change is requested again after a failed one
+        uint64_t retryFrame = 0;
+        SamplerCreateInfo samplerCreateInfo;
+        // Allocation size of the image holding the levels from a base level to the last one,
+        // indexed by base level up to the mip tail one
+        std::vector<vk::DeviceSize> residentSizes;
+        uint32_t residentBaseLevel;
+        Image image;
+        vk::UniqueImageView view;
+        vk::Sampler sampler;
+    };
+
+    struct ResidencyRequest {
+        StreamedTextureId textureId;
+        const StreamedTexture* texture;
+        uint32_t baseLevel;
+    };
+
+    struct ResidencyResult {
+        StreamedTextureId textureId;
+        uint32_t baseLevel;
+        Image image;
+        vk::UniqueImageView view;
+        vk::DeviceSize uploadedBytes;
+        // Set when the upload threw, the texture keeps its current image
+        bool failed = false;
+    };
+
+    struct RetiredImage {
+        uint64_t retireFrame;
+        Image image;
+        vk::UniqueImageView view;
+    };
+
+    // Frames to wait before requesting a residency change that failed again
+    static constexpr uint64_t kFailedRequestRetryDelay = 60;
+
+    [[nodiscard]] ResidencyResult upload(const StreamedTexture& texture, uint32_t baseLevel);
+
+    [[nodiscard]] vk::DeviceSize getBudget() const;
+
+    [[nodiscard]] static vk::DeviceSize getResidentSize(
+        const StreamedTexture& texture,
+        uint32_t baseLevel);
+
+    // Change of the resident size once the texture holds the levels from baseLevel
+    [[nodiscard]] static int64_t getResidentDelta(
+        const StreamedTexture& texture,
+        uint32_t baseLevel);
+
+    // Resident size once the pending residency changes have completed
+    [[nodiscard]] vk::DeviceSize getProjectedResidentBytes() const;
+
+    void queueRequest(StreamedTextureId textureId, uint32_t baseLevel);
+
+    void applyResults();
+
+    void evictUntil(
+        vk::DeviceSize budget,
+        vk::DeviceSize requiredBytes,
+        std::pmr::memory_resource* memoryResource);
+
+    void scheduleRequests(vk::DeviceSize budget, std::pmr::memory_resource* memoryResource);
+
+    void streamingLoop(std::stop_token stopToken);
+
+    vk::PhysicalDevice physicalDevice_;
+    vk::PhysicalDeviceMemoryProperties memoryProperties_;
+    vk::Device device_;
+    vk::Queue queue_;
+    QueueFamilyIndex queueFamilyIndex_;
+    Option memoryBudgetEXT_;
+    vk::DeviceSize fallbackBudget_;
+    uint32_t mipTailExtent_;
+    uint32_t maxPendingRequests_;
+    uint32_t framesInFlight_;
+
+    SamplerCache samplerCache_;
+    // Stable addresses as the streaming thread reads the sources of pending requests
+    std::vector<std::unique_ptr<StreamedTexture>> textures_;
+    std::deque<RetiredImage> retiredImages_;
+    vk::DeviceSize residentBytes_ = 0;
+    // Sum of the resident size changes of the pending requests, negative for evictions
+    int64_t pendingResidentDelta_ = 0;
+    uint32_t pendingRequestCount_ = 0;
+    uint64_t frame_ = 0;
+    TextureResidencyStats stats_;
+
+    std::mutex queueMutex_;
+    std::mutex mutex_;
+    std::condition_variable_any requestsAvailable_;
+    // Vectors rather than deques, as they keep their capacity once the queues are emptied. Both
+    // queues hold at most maxPendingRequests elements.
+    std::vector<ResidencyRequest> requests_;
+    std::vector<ResidencyResult> results_;
+    // Results taken from results_ by the frame thread
+    std::vector<ResidencyResult> appliedResults_;
+    // Declared last so the thread is joined before the state it uses is destroyed
+    std::jthread streamingThread_;
+};
+
+} // namespace vki
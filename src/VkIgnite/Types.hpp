@@ -12,4 +12,10 @@ using QueueFamilyIndex = uint32_t;
 // Vulkan uses uint32_t to define version numbers
 using VersionValueType = uint32_t;
 
+// A boolean value to control an option activation like extension or layer
+enum class Option {
+    Disabled,
+    Enabled,
+};
+
 } // namespace vki
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "Pch/Glm.hpp"
+#include "Pch/Vulkan.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace vki {
+
+// Vertex attribute encodings usable in a VertexLayout.
+// Each encoding provides the Vulkan format used to fetch it, the CPU-side storage type written in
+// the vertex buffer and an encode() function converting the full precision value to that storage.
+// For vertex pulling, it also provides the GLSL type it decodes to and the GLSL expression decoding
+// it from its 32-bit words w0, w1..., giving the same value as the fixed function fetch.
+namespace vertex {
+
+// 32-bit float vectors, the unquantized reference encodings
+struct Float2 {
+    using StorageType = glm::vec2;
+    static constexpr vk::Format format = vk::Format::eR32G32Sfloat;
+    static constexpr const char* glslType = "vec2";
+    static constexpr const char* glslDecode = "uintBitsToFloat(uvec2(w0, w1))";
+
+    [[nodiscard]] static StorageType encode(glm::vec2 value)
+    {
+        return value;
+    }
+};
+
+struct Float3 {
+    using StorageType = glm::vec3;
+    static constexpr vk::Format format = vk::Format::eR32G32B32Sfloat;
+    static constexpr const char* glslType = "vec3";
+    static constexpr const char* glslDecode = "uintBitsToFloat(uvec3(w0, w1, w2))";
+
+    [[nodiscard]] static StorageType encode(glm::vec3 value)
+    {
+        return value;
+    }
+};
+
+struct Float4 {
+    using StorageType = glm::vec4;
+    static constexpr vk::Format format = vk::Format::eR32G32B32A32Sfloat;
+    static constexpr const char* glslType = "vec4";
+    static constexpr const char* glslDecode = "uintBitsToFloat(uvec4(w0, w1, w2, w3))";
+
+    [[nodiscard]] static StorageType encode(glm::vec4 value)
+    {
+        return value;
+    }
+};
+
+// Bounds used to quantize positions into the [-1, 1] range of snorm formats.
+// The vertex shader must apply the inverse transform: position = center + fetched.xyz * extent.
+struct QuantizationBounds {
+    glm::vec3 center = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(1.0f);
+
+    [[nodiscard]] static QuantizationBounds fromMinMax(glm::vec3 min, glm::vec3 max)
+    {
+        return {
+            .center = (min + max) * 0.5f,
+            .extent = glm::max((max - min) * 0.5f, glm::vec3(std::numeric_limits<float>::min())),
+        };
+    }
+};
+
+// Mesh-space positions quantized to 16-bit snorm (8 bytes instead of 12).
+// R16G16B16 formats are rarely supported as vertex input, so a 4th padding component is used.
+struct Snorm16Position {
+    using StorageType = std::array<uint16_t, 4>;
+    static constexpr vk::Format format = vk::Format::eR16G16B16A16Snorm;
+    static constexpr const char* glslType = "vec3";
+    static constexpr const char* glslDecode = "vec3(unpackSnorm2x16(w0), unpackSnorm2x16(w1).x)";
+
+    [[nodiscard]] static StorageType encode(glm::vec3 position, const QuantizationBounds& bounds)
+    {
+        const glm::vec3 normalized = (position - bounds.center) / bounds.extent;
+        const glm::uint64 packed = glm::packSnorm4x16(glm::vec4(normalized, 1.0f));
+        StorageType storage;
+        std::memcpy(storage.data(), &packed, sizeof(storage));
+        return storage;
+    }
+};
+
+// Unit vectors stored with an octahedral mapping on two 16-bit snorm (4 bytes instead of 12).
+// The vertex shader must decode it, for example:
+//   vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+//   float t = max(-n.z, 0.0);
+//   n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+//   n = normalize(n);
+struct OctahedralNormal {
+    using StorageType = std::array<uint16_t, 2>;
+    static constexpr vk::Format format = vk::Format::eR16G16Snorm;
+    static constexpr const char* glslType = "vec2";
+    static constexpr const char* glslDecode = "unpackSnorm2x16(w0)";
+
+    [[nodiscard]] static StorageType encode(glm::vec3 normal)
+    {
+        const glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+        glm::vec2 encoded = glm::vec2(n.x, n.y);
+        if (n.z < 0.0f) {
+            // Fold the lower hemisphere over the diagonals
+            const glm::vec2 signs = glm::vec2(
+                encoded.x >= 0.0f ? 1.0f : -1.0f,
+                encoded.y >= 0.0f ? 1.0f : -1.0f);
+            encoded = (glm::vec2(1.0f) - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+        }
+        const glm::uint32 packed = glm::packSnorm2x16(encoded);
+        StorageType storage;
+        std::memcpy(storage.data(), &packed, sizeof(storage));
+        return storage;
+    }
+};
+
+// Texture coordinates as two half floats (4 bytes instead of 8)
+struct Half2 {
+    using StorageType = std::array<uint16_t, 2>;
+    static constexpr vk::Format format = vk::Format::eR16G16Sfloat;
+    static constexpr const char* glslType = "vec2";
+    static constexpr const char* glslDecode = "unpackHalf2x16(w0)";
+
+    [[nodiscard]] static StorageType encode(glm::vec2 value)
+    {
+        const glm::uint32 packed = glm::packHalf2x16(value);
+        StorageType storage;
+        std::memcpy(storage.data(), &packed, sizeof(storage));
+        return storage;
+    }
+};
+
+// Colors as four 8-bit unorm (4 bytes instead of 16)
+struct Unorm8Color {
+    using StorageType = std::array<uint8_t, 4>;
+    static constexpr vk::Format format = vk::Format::eR8G8B8A8Unorm;
+    static constexpr const char* glslType = "vec4";
+    static constexpr const char* glslDecode = "unpackUnorm4x8(w0)";
+
+    [[nodiscard]] static StorageType encode(glm::vec4 color)
+    {
+        const glm::uint32 packed = glm::packUnorm4x8(color);
+        StorageType storage;
+        std::memcpy(storage.data(), &packed, sizeof(storage));
+        return storage;
+    }
+};
+
+template<typename TAttribute>
+concept Attribute = requires {
+    typename TAttribute::StorageType;
+    { TAttribute::format } -> std::convertible_to<vk::Format>;
+} && std::is_trivially_copyable_v<typename TAttribute::StorageType>;
+
+// Attribute that shaders can fetch themselves, word by word
+template<typename TAttribute>
+concept PullableAttribute = Attribute<TAttribute> && requires {
+    { TAttribute::glslType } -> std::convertible_to<std::string_view>;
+    { TAttribute::glslDecode } -> std::convertible_to<std::string_view>;
+} && sizeof(typename TAttribute::StorageType) % sizeof(uint32_t) == 0;
+
+} // namespace vertex
+
+// How the attributes of a VertexLayout are laid out in memory
+enum class VertexStreams {
+    // All attributes of a vertex are packed together in a single binding.
+    // Best for meshes drawn with every attribute, one fetch per vertex.
+    Interleaved,
+    // Each attribute lives in its own binding (structure of arrays).
+    // Best when some passes only need a subset of the attributes, like a depth pre-pass only
+    // fetching positions.
+    Separate,
+};
+
+// Compile-time description of a vertex format built from a list of attribute encodings.
+// Attribute locations follow the order of the list, starting at 0.
+//
+// Example:
+//   using MeshLayout = vki::VertexLayout<
+//       vki::VertexStreams::Interleaved,
+//       vki::vertex::Snorm16Position,
+//       vki::vertex::OctahedralNormal,
+//       vki::vertex::Half2>;
+//   // 16 bytes per vertex instead of 32 with full precision floats
+//   vk::PipelineVertexInputStateCreateInfo vertexInputState = MeshLayout::inputState();
+template<VertexStreams TStreams, vertex::Attribute... TAttributes>
+class VertexLayout {
+public:
+    static_assert(sizeof...(TAttributes) > 0, "A vertex layout needs at least one attribute");
+
+    static constexpr VertexStreams streams = TStreams;
+    static constexpr uint32_t attributeCount = sizeof...(TAttributes);
+    static constexpr uint32_t bindingCount
+        = TStreams == VertexStreams::Interleaved ? 1 : attributeCount;
+
+    template<uint32_t TLocation>
+    using AttributeAt = std::tuple_element_t<TLocation, std::tuple<TAttributes...>>;
+
+    // Size in bytes of each attribute, indexed by location
+    static constexpr std::array<uint32_t, attributeCount> attributeSizes {
+        static_cast<uint32_t>(sizeof(typename TAttributes::StorageType))...
+    };
+
+    // Size of one vertex summed over all bindings
+    static constexpr uint32_t bytesPerVertex = (sizeof(typename TAttributes::StorageType) + ...);
+
+    static constexpr std::array<vk::VertexInputBindingDescription, bindingCount> bindings
+        = [] {
+              std::array<vk::VertexInputBindingDescription, bindingCount> descriptions {};
+              for (uint32_t binding = 0; binding < bindingCount; binding++) {
+                  descriptions[binding] = vk::VertexInputBindingDescription {
+                      .binding = binding,
+                      .stride = TStreams == VertexStreams::Interleaved ? bytesPerVertex
+                                                                       : attributeSizes[binding],
+                      .inputRate = vk::VertexInputRate::eVertex,
+                  };
+              }
+              return descriptions;
+          }();
+
+    static constexpr std::array<vk::VertexInputAttributeDescription, attributeCount> attributes
+        = [] {
+              constexpr std::array<vk::Format, attributeCount> formats { TAttributes::format... };
+              std::array<vk::VertexInputAttributeDescription, attributeCount> descriptions {};
+              uint32_t offset = 0;
+              for (uint32_t location = 0; location < attributeCount; location++) {
+                  const bool interleaved = TStreams == VertexStreams::Interleaved;
+                  descriptions[location] = vk::VertexInputAttributeDescription {
+                      .location = location,
+                      .binding = interleaved ? 0 : location,
+                      .format = formats[location],
+                      .offset = interleaved ? offset : 0,
+                  };
+                  offset += attributeSizes[location];
+              }
+              return descriptions;
+          }();
+
+    [[nodiscard]] static vk::PipelineVertexInputStateCreateInfo inputState()
+    {
+        return vk::PipelineVertexInputStateCreateInfo {
+            .vertexBindingDescriptionCount = bindingCount,
+            .pVertexBindingDescriptions = bindings.data(),
+            .vertexAttributeDescriptionCount = attributeCount,
+            .pVertexAttributeDescriptions = attributes.data(),
+        };
+    }
+
+    // GLSL declarations for vertex pulling: a VertexWords buffer reference type and one
+    // fetchAttribute<location>(VertexWords stream, uint vertexIndex) function per attribute,
+    // stream being the address of the buffer backing the binding of the attribute. The shader
+    // must enable GL_EXT_buffer_reference before including them. Reading the vertices this way
+    // needs no vertex input state, so a single pipeline serves every vertex layout.
+    //
+    // Example:
+    //   #extension GL_EXT_buffer_reference : require
+    //   <pullingShaderSource()>
+    //   layout(push_constant) uniform Draw { VertexWords vertices; } draw;
+    //   vec3 position = fetchAttribute0(draw.vertices, gl_VertexIndex);
+    [[nodiscard]] static std::string pullingShaderSource()
+        requires(vertex::PullableAttribute<TAttributes> && ...)
+    {
+        constexpr std::array<std::string_view, attributeCount> glslTypes {
+            TAttributes::glslType...
+        };
+        constexpr std::array<std::string_view, attributeCount> glslDecodes {
+            TAttributes::glslDecode...
+        };
+        constexpr uint32_t wordSize = sizeof(uint32_t);
+
+        std::string source = "layout(buffer_reference, std430, buffer_reference_align = 4) "
+                             "readonly buffer VertexWords {\n"
+                             "    uint words[];\n"
+                             "};\n";
+        for (uint32_t location = 0; location < attributeCount; location++) {
+            const vk::VertexInputAttributeDescription& attribute = attributes[location];
+            source += std::format(
+                "\n{} fetchAttribute{}(VertexWords stream, uint vertexIndex)\n"
+                "{{\n"
+                "    uint word = vertexIndex * {}u + {}u;\n",
+                glslTypes[location],
+                location,
+                bindings[attribute.binding].stride / wordSize,
+                attribute.offset / wordSize);
+            for (uint32_t word = 0; word < attributeSizes[location] / wordSize; word++) {
+                source += std::format("    uint w{0} = stream.words[word + {0}u];\n", word);
+            }
+            source += std::format("    return {};\n}}\n", glslDecodes[location]);
+        }
+        return source;
+    }
+
+    // Size in bytes of the buffer backing the given binding for vertexCount vertices
+    [[nodiscard]] static constexpr vk::DeviceSize bufferSize(uint32_t binding, size_t vertexCount)
+    {
+        return static_cast<vk::DeviceSize>(bindings[binding].stride) * vertexCount;
+    }
+
+    // Write an already encoded attribute of a vertex in the buffers backing the layout.
+    // The streams span must contain one buffer per binding, each sized with bufferSize().
+    template<uint32_t TLocation>
+    static void write(
+        std::span<const std::span<std::byte>, bindingCount> streams,
+        size_t vertexIndex,
+        const typename AttributeAt<TLocation>::StorageType& value)
+    {
+        constexpr vk::VertexInputAttributeDescription attribute = attributes[TLocation];
+        const size_t offset
+            = vertexIndex * bindings[attribute.binding].stride + attribute.offset;
+        std::memcpy(streams[attribute.binding].data() + offset, &value, sizeof(value));
+    }
+};
+
+} // namespace vki
@@ -6,35 +6,22 @@
 
 #include <strong_type/strong_type.hpp>
 
+#include <memory_resource>
 #include <vector>
 
 namespace vki {
 
-struct QueueCreateInfo {
-    vk::DeviceQueueCreateFlags flags = {};
-    QueueFamilyIndex queueFamilyIndex = {};
-    std::vector<float> queuePriorities = {};
-};
-
-struct DeviceCreateInfo {
-    vk::DeviceCreateFlags flags = {};
-    std::vector<QueueCreateInfo> queueCreateInfos = {};
-    std::vector<LayerName> enabledLayerNames = {};
-    std::vector<ExtensionName> enabledExtensionNames = {};
-};
-
-[[nodiscard]] vk::UniqueDevice makeDeviceUnique(
-    vk::PhysicalDevice physicalDevice,
-    DeviceCreateInfo deviceCreateInfo);
-
 struct SwapchainSupportDetails {
     vk::SurfaceCapabilitiesKHR capabilities;
-    std::vector<vk::SurfaceFormatKHR> formats;
-    std::vector<vk::PresentModeKHR> presentModes;
+    std::pmr::vector<vk::SurfaceFormatKHR> formats;
+    std::pmr::vector<vk::PresentModeKHR> presentModes;
 };
 
+// The formats and present modes are allocated from memoryResource, which can be a per frame arena
+// when the details do not outlive the frame
 [[nodiscard]] SwapchainSupportDetails querySwapchainSupport(
     const vk::PhysicalDevice& physicalDevice,
-    const vk::SurfaceKHR& surface);
+    const vk::SurfaceKHR& surface,
+    std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
 
 } // namespace vki
@@ -1,13 +1,30 @@
+#include "VkIgnite/BuildProfile.hpp"
+#include "VkIgnite/CommandStream.hpp"
+#include "VkIgnite/Device.hpp"
+#include "VkIgnite/Format.hpp"
+#include "VkIgnite/FramePacing.hpp"
+#include "VkIgnite/Memory.hpp"
+#include "VkIgnite/Multisampling.hpp"
 #include "VkIgnite/PhysicalDevicePicker.hpp"
+#include "VkIgnite/PresentWait.hpp"
+#include "VkIgnite/QueueTopology.hpp"
 #include "VkIgnite/Shader.hpp"
+#include "VkIgnite/VertexLayout.hpp"
 #include "VkIgnite/VkIgnite.hpp"
 #include "VkIgnite/Wsi/Glfw.hpp"
 
+#include "Pch/Glm.hpp"
 #include "Pch/Spdlog.hpp"
 
 #include "Stdx/Algorithm.hpp"
+#include "Stdx/LinearArena.hpp"
 
+#include <array>
+#include <chrono>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 static void glfwErrorCallback(int errorCode, const char* description)
@@ -45,6 +62,26 @@ void main() {
 }
 )vertexshader";
 
+// Vertices of the triangle when they are pulled from a buffer by the vertex shader
+using TriangleVertexLayout = vki::
+    VertexLayout<vki::VertexStreams::Interleaved, vki::vertex::Float2, vki::vertex::Unorm8Color>;
+
+// Appended to the TriangleVertexLayout pulling declarations, the vertex data address being pushed
+// by the render state tracker
+constexpr const char kPullingVertexShaderMain[] = R"vertexshader(
+layout(push_constant) uniform Draw {
+    VertexWords vertices;
+} draw;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    uint vertexIndex = uint(gl_VertexIndex);
+    gl_Position = vec4(fetchAttribute0(draw.vertices, vertexIndex), 0.0, 1.0);
+    fragColor = fetchAttribute1(draw.vertices, vertexIndex).rgb;
+}
+)vertexshader";
+
 constexpr const char kFragmentShaderSource[] = R"fragmentShader(
 #version 450
 
@@ -61,8 +98,22 @@ class HelloTriangleApplication {
 public:
     static inline constexpr uint32_t Width = 800;
     static inline constexpr uint32_t Height = 600;
-    static inline constexpr bool EnableValidationLayers = true;
     static inline constexpr uint32_t MaxFramesInFlight = 2;
+    // Lowered to the highest sample count supported by the device, e1 disables multisampling
+    static inline constexpr vk::SampleCountFlagBits RequestedSampleCount
+        = vk::SampleCountFlagBits::e4;
+    // Render the depth of the scene before shading it, worth it when fragment shading dominates
+    static inline constexpr bool EnableDepthPrepass = false;
+    static inline constexpr vki::PresentPolicy SwapchainPresentPolicy
+        = vki::PresentPolicy::LowLatency;
+    // Maximum frame rate enforced on the CPU side, 0 to only be limited by the presentation
+    static inline constexpr uint32_t FrameRateLimit = 0;
+    static inline constexpr std::chrono::nanoseconds TargetFrameDuration = FrameRateLimit > 0
+        ? std::chrono::nanoseconds { std::chrono::seconds { 1 } } / FrameRateLimit
+        : std::chrono::nanoseconds::zero();
+    // Presents allowed to wait for display when a frame starts, if present wait is supported.
+    // Fewer means lower latency but less slack to absorb frame time spikes.
+    static inline constexpr uint32_t MaxQueuedPresents = 1;
 
     void run()
     {
@@ -98,7 +149,7 @@ private:
 
     void initVulkan()
     {
-        instance_ = vki::Instance::make(vki::InstanceCreateInfo {
+        vki::InstanceCreateInfo instanceCreateInfo {
             .applicationInfo = {
                 .applicationName = "",
                 .applicationVersion = vki::makeVersion(0, 1, 0),
@@ -107,9 +158,12 @@ private:
             },
             .enabledLayerNames = {},
             .enabledExtensionNames = vki::wsi::glfw::getRequiredExtensions(),
-            .validationLayerKHROption = vki::Option::Enabled,
-            .debugUtilsMessengerEXTOption = vki::Option::Enabled,
-        });
+        };
+        // Validation and debug messages depend on the build profile
+        const vki::BuildProfile buildProfile = vki::getActiveBuildProfile();
+        spdlog::info("Build profile: {}", vki::getBuildProfileName(buildProfile));
+        vki::applyBuildProfile(instanceCreateInfo, buildProfile);
+        instance_ = vki::Instance::make(instanceCreateInfo);
 
         surface_ = vki::wsi::glfw::createSurfaceKHRUnique(*instance_.handle, window_);
 
@@ -117,50 +171,85 @@ private:
             VK_KHR_SWAPCHAIN_EXTENSION_NAME
         };
 
+        // Present wait is optional, present latency is simply not measured without it
+        std::array<vki::ExtensionName, 2> optionalDeviceExtensions {
+            VK_KHR_PRESENT_ID_EXTENSION_NAME,
+            VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+        };
+
         vki::PhysicalDevicePickResult physicalDevicePickResult = vki::PhysicalDevicePicker::pick(
             *instance_.handle,
             *surface_,
-            requiredDeviceExtensions);
+            {
+                .requiredExtensions = requiredDeviceExtensions,
+                .optionalExtensions = optionalDeviceExtensions,
+            });
 
         physicalDevice_ = physicalDevicePickResult.physicalDevice;
+        const vki::PhysicalDeviceInfo& deviceInfo = physicalDevicePickResult.deviceInfo;
+        memoryProperties_ = deviceInfo.memoryProperties;
+
+        std::vector<vki::ExtensionName> enabledDeviceExtensions = requiredDeviceExtensions;
+        presentWaitSupported_ = vki::isPresentWaitSupported(deviceInfo);
+        if (presentWaitSupported_) {
+            enabledDeviceExtensions.insert(
+                enabledDeviceExtensions.end(),
+                optionalDeviceExtensions.begin(),
+                optionalDeviceExtensions.end());
+        }
+        spdlog::info("Present wait supported: {}", presentWaitSupported_);
+        // Chained after the core features, which the device builder enables
+        vk::StructureChain<
+            vk::PhysicalDevicePresentIdFeaturesKHR,
+            vk::PhysicalDevicePresentWaitFeaturesKHR>
+            presentWaitFeatures {
+                { .presentId = vk::True },
+                { .presentWait = vk::True },
+            };
+        sampleCount_ = vki::chooseSampleCount(deviceInfo.properties.limits, RequestedSampleCount);
+        spdlog::info("Rendering with {} samples per pixel", vk::to_string(sampleCount_));
+        depthFormat_ = vki::chooseDepthFormat(physicalDevice_);
+        spdlog::info("Depth format: {}", vk::to_string(depthFormat_));
 
-        // Save the index of both queue families
-        queueFamiliesInfo_.graphicsQueueFamilyIndex
-            = physicalDevicePickResult.graphicsQueueFamilyIndex;
-        queueFamiliesInfo_.presentationQueueFamilyIndex
-            = physicalDevicePickResult.presentationQueueFamilyIndex;
+        const vki::QueueTopology& queueTopology = physicalDevicePickResult.queueTopology;
+
+        // Save the index of both queue families used by the swapchain
+        queueFamiliesInfo_.graphicsQueueFamilyIndex = queueTopology.graphics;
+        queueFamiliesInfo_.presentationQueueFamilyIndex = queueTopology.present;
 
         // Create a list of queue family indices without duplicates
         queueFamiliesInfo_.queueFamilyIndices = {
-            physicalDevicePickResult.graphicsQueueFamilyIndex,
-            physicalDevicePickResult.presentationQueueFamilyIndex,
+            queueTopology.graphics,
+            queueTopology.present,
         };
         stdx::ranges::sort_unique(queueFamiliesInfo_.queueFamilyIndices);
 
-        // Create one queue from each family with the same priority
-        std::vector<vki::QueueCreateInfo> queueCreateInfos;
-        for (auto& queueFamilyIndex : queueFamiliesInfo_.queueFamilyIndices) {
-            queueCreateInfos.push_back({
-                .queueFamilyIndex = queueFamilyIndex,
-                .queuePriorities = { 1.f },
-            });
-        }
+        // Create one queue from each family of the topology, async compute and transfers having a
+        // lower priority than the frame
+        std::vector<vki::QueueCreateInfo> queueCreateInfos
+            = vki::makeQueueCreateInfos(queueTopology);
 
         // Create a logical device associated to the physical device
-        device_ = vki::makeDeviceUnique(
-            physicalDevice_,
+        vki::Device device = vki::Device::make(
+            deviceInfo,
             {
                 .queueCreateInfos = queueCreateInfos,
-                .enabledExtensionNames = requiredDeviceExtensions,
+                .enabledExtensionNames = enabledDeviceExtensions,
+                .pNext = presentWaitSupported_
+                    ? &presentWaitFeatures.get<vk::PhysicalDevicePresentIdFeaturesKHR>()
+                    : nullptr,
             });
+        device_ = std::move(device.handle);
+        deviceFeatures_ = device.enabledFeatures;
 
         // Get the queue handles from the device
-        graphicsQueue_ = device_->getQueue(physicalDevicePickResult.graphicsQueueFamilyIndex, 0);
-        presentationQueue_
-            = device_->getQueue(physicalDevicePickResult.presentationQueueFamilyIndex, 0);
+        const vki::Queues queues = vki::getQueues(*device_, queueTopology);
+        graphicsQueue_ = queues.graphics;
+        presentationQueue_ = queues.present;
 
         createSwapchain(physicalDevicePickResult.swapchainSupportDetails);
 
+        createVertexData();
         createGraphicsPipeline();
 
         createCommandPool();
@@ -169,7 +258,7 @@ private:
     }
 
     [[nodiscard]] static vk::SurfaceFormatKHR chooseSurfaceFormat(
-        const std::vector<vk::SurfaceFormatKHR>& availableFormats)
+        std::span<const vk::SurfaceFormatKHR> availableFormats)
     {
         // Prefer sRGB color space as it results in more accurate perceived colors
         for (const auto& availableFormat : availableFormats) {
@@ -182,19 +271,6 @@ private:
         return availableFormats[0];
     }
 
-    [[nodiscard]] static vk::PresentModeKHR choosePresentMode(
-        const std::vector<vk::PresentModeKHR>& availablePresentModes)
-    {
-        // Prefer Mailbox (triple buffering V-Sync) to avoid tearing and reduce latency
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-                return availablePresentMode;
-            }
-        }
-        // Otherwise fallback to Fifo (double buffering V-Sync) which is garanteed to be available
-        return vk::PresentModeKHR::eFifo;
-    }
-
     [[nodiscard]] static vk::Extent2D chooseExtent(
         GLFWwindow* window,
         const vk::SurfaceCapabilitiesKHR& capabilities)
@@ -218,19 +294,6 @@ private:
         }
     }
 
-    [[nodiscard]] static uint32_t chooseImageCount(const vk::SurfaceCapabilitiesKHR& capabilities)
-    {
-        // Allocate one more image than the strict minimum the driver requires to work properly to
-        // avoid waiting on the driver
-        uint32_t imageCount = capabilities.minImageCount + 1;
-        // Ensure the maximum number of image supported by the driver is not exceeded
-        if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
-            imageCount = capabilities.maxImageCount;
-        }
-        spdlog::debug("Minimal image count: {}", imageCount);
-        return imageCount;
-    }
-
     void createImageViews()
     {
         swapchainImageViews_.resize(swapchainImages_.size());
@@ -260,9 +323,13 @@ private:
     void createSwapchain(const vki::SwapchainSupportDetails& swapchainSupport)
     {
         vk::SurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(swapchainSupport.formats);
-        vk::PresentModeKHR presentMode = choosePresentMode(swapchainSupport.presentModes);
+        vk::PresentModeKHR presentMode
+            = vki::choosePresentMode(SwapchainPresentPolicy, swapchainSupport.presentModes);
         vk::Extent2D extent = chooseExtent(window_, swapchainSupport.capabilities);
-        uint32_t imageCount = chooseImageCount(swapchainSupport.capabilities);
+        uint32_t imageCount = vki::chooseImageCount(
+            SwapchainPresentPolicy,
+            presentMode,
+            swapchainSupport.capabilities);
 
         vk::SwapchainCreateInfoKHR swapchainCreateInfo {
             .flags = {},
@@ -291,66 +358,249 @@ private:
             swapchainCreateInfo.pQueueFamilyIndices = queueFamiliesInfo_.queueFamilyIndices.data();
         }
 
+        // The previous swapchain is retired by the creation, presents on it are no longer waited
+        presentWaiter_.stop();
         swapchain_ = device_->createSwapchainKHRUnique(swapchainCreateInfo);
+        if (presentWaitSupported_) {
+            presentWaiter_.start(*device_, *swapchain_);
+        }
         swapchainImages_ = device_->getSwapchainImagesKHR(*swapchain_);
         swapchainImageFormat_ = surfaceFormat.format;
         swapchainExtent_ = extent;
 
         createImageViews();
+        createColorResources();
+        createDepthResources();
         createRenderPass();
         createFramebuffers();
     }
 
+    [[nodiscard]] bool isMultisampled() const
+    {
+        return sampleCount_ != vk::SampleCountFlagBits::e1;
+    }
+
+    void createColorResources()
+    {
+        if (!isMultisampled()) {
+            return;
+        }
+        // The multisampled image is resolved to the swapchain image at the end of the subpass and
+        // never stored, so it can live in tile memory only
+        multisampledColorImage_ = vki::Image::make(
+            *device_,
+            memoryProperties_,
+            {
+                .format = swapchainImageFormat_,
+                .extent = swapchainExtent_,
+                .samples = sampleCount_,
+                .usage = vk::ImageUsageFlagBits::eColorAttachment,
+                .transientAttachment = vki::Option::Enabled,
+            });
+        multisampledColorImageView_ = multisampledColorImage_.makeView(*device_);
+        spdlog::debug(
+            "Multisampled color attachment: {} bytes{}",
+            multisampledColorImage_.allocationSize,
+            multisampledColorImage_.lazilyAllocated ? ", lazily allocated" : "");
+    }
+
+    void createDepthResources()
+    {
+        depthImage_ = vki::Image::make(
+            *device_,
+            memoryProperties_,
+            {
+                .format = depthFormat_,
+                .extent = swapchainExtent_,
+                .samples = sampleCount_,
+                .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+                .transientAttachment = vki::Option::Enabled,
+            });
+        depthImageView_ = depthImage_.makeView(*device_, vk::ImageAspectFlagBits::eDepth);
+    }
+
     void createRenderPass()
     {
-        vk::AttachmentDescription colorAttachment {
-            .format = swapchainImageFormat_,
-            .samples = vk::SampleCountFlagBits::e1,
-            .loadOp = vk::AttachmentLoadOp::eClear,
-            .storeOp = vk::AttachmentStoreOp::eStore,
-            .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-            .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-            .initialLayout = vk::ImageLayout::eUndefined,
-            .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+        // Without multisampling, the swapchain image is the color attachment. Otherwise the
+        // multisampled attachment is cleared, rendered to and discarded, only its resolve to the
+        // swapchain image is stored, avoiding a separate resolve pass. Depth is never read after
+        // the render pass so it is not stored either.
+        std::vector<vk::AttachmentDescription> attachments {
+            vk::AttachmentDescription {
+                .format = swapchainImageFormat_,
+                .samples = sampleCount_,
+                .loadOp = vk::AttachmentLoadOp::eClear,
+                .storeOp = isMultisampled() ? vk::AttachmentStoreOp::eDontCare
+                                            : vk::AttachmentStoreOp::eStore,
+                .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+                .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+                .initialLayout = vk::ImageLayout::eUndefined,
+                .finalLayout = isMultisampled() ? vk::ImageLayout::eColorAttachmentOptimal
+                                                : vk::ImageLayout::ePresentSrcKHR,
+            },
+            vk::AttachmentDescription {
+                .format = depthFormat_,
+                .samples = sampleCount_,
+                .loadOp = vk::AttachmentLoadOp::eClear,
+                .storeOp = vk::AttachmentStoreOp::eDontCare,
+                .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+                .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+                .initialLayout = vk::ImageLayout::eUndefined,
+                .finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+            },
         };
+        if (isMultisampled()) {
+            attachments.push_back({
+                .format = swapchainImageFormat_,
+                .samples = vk::SampleCountFlagBits::e1,
+                .loadOp = vk::AttachmentLoadOp::eDontCare,
+                .storeOp = vk::AttachmentStoreOp::eStore,
+                .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
+                .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+                .initialLayout = vk::ImageLayout::eUndefined,
+                .finalLayout = vk::ImageLayout::ePresentSrcKHR,
+            });
+        }
 
         vk::AttachmentReference colorAttachmentRef {
             .attachment = 0,
             .layout = vk::ImageLayout::eColorAttachmentOptimal,
         };
 
-        vk::SubpassDescription subpassDescription {
+        vk::AttachmentReference depthAttachmentRef {
+            .attachment = 1,
+            .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+        };
+
+        vk::AttachmentReference resolveAttachmentRef {
+            .attachment = 2,
+            .layout = vk::ImageLayout::eColorAttachmentOptimal,
+        };
+
+        std::vector<vk::SubpassDescription> subpassDescriptions;
+        if (EnableDepthPrepass) {
+            // Depth only subpass, so that the color subpass only shades the visible fragments
+            subpassDescriptions.push_back({
+                .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
+                .pDepthStencilAttachment = &depthAttachmentRef,
+            });
+        }
+        subpassDescriptions.push_back({
             .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
             .colorAttachmentCount = 1,
             .pColorAttachments = &colorAttachmentRef,
-        };
+            .pResolveAttachments = isMultisampled() ? &resolveAttachmentRef : nullptr,
+            .pDepthStencilAttachment = &depthAttachmentRef,
+        });
 
-        vk::SubpassDependency subpassDependency {
-            .srcSubpass = vk::SubpassExternal,
-            .dstSubpass = 0,
-            .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-            .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-            .srcAccessMask = vk::AccessFlagBits::eNone,
-            .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
+        // The depth image is shared by the frames in flight, so clearing it must wait for the
+        // depth writes of the previous frame
+        std::vector<vk::SubpassDependency> subpassDependencies {
+            vk::SubpassDependency {
+                .srcSubpass = vk::SubpassExternal,
+                .dstSubpass = 0,
+                .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput
+                    | vk::PipelineStageFlagBits::eLateFragmentTests,
+                .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput
+                    | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+                .srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite
+                    | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+            },
         };
+        if (EnableDepthPrepass) {
+            subpassDependencies.push_back({
+                .srcSubpass = 0,
+                .dstSubpass = 1,
+                .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput
+                    | vk::PipelineStageFlagBits::eEarlyFragmentTests
+                    | vk::PipelineStageFlagBits::eLateFragmentTests,
+                .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput
+                    | vk::PipelineStageFlagBits::eEarlyFragmentTests
+                    | vk::PipelineStageFlagBits::eLateFragmentTests,
+                .srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                .dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead,
+                .dependencyFlags = vk::DependencyFlagBits::eByRegion,
+            });
+        }
 
         vk::RenderPassCreateInfo renderPassCreateInfo {
-            .attachmentCount = 1,
-            .pAttachments = &colorAttachment,
-            .subpassCount = 1,
-            .pSubpasses = &subpassDescription,
-            .dependencyCount = 1,
-            .pDependencies = &subpassDependency,
+            .attachmentCount = static_cast<uint32_t>(attachments.size()),
+            .pAttachments = attachments.data(),
+            .subpassCount = static_cast<uint32_t>(subpassDescriptions.size()),
+            .pSubpasses = subpassDescriptions.data(),
+            .dependencyCount = static_cast<uint32_t>(subpassDependencies.size()),
+            .pDependencies = subpassDependencies.data(),
         };
 
         renderPass_ = device_->createRenderPassUnique(renderPassCreateInfo);
     }
 
+    // With buffer device addresses, the triangle vertices are stored in a buffer the vertex shader
+    // reads through a pointer, instead of being hardcoded in the shader. The pipeline then needs
+    // no vertex input state, whatever the vertex layout.
+    void createVertexData()
+    {
+        if (!deviceFeatures_.get<vk::PhysicalDeviceVulkan12Features>().bufferDeviceAddress) {
+            spdlog::info("Buffer device address unsupported, vertices are hardcoded in the shader");
+            return;
+        }
+
+        constexpr uint32_t vertexCount = 3;
+        const std::array<glm::vec2, vertexCount> positions {
+            glm::vec2(0.0f, -0.5f),
+            glm::vec2(0.5f, 0.5f),
+            glm::vec2(-0.5f, 0.5f),
+        };
+        const std::array<glm::vec4, vertexCount> colors {
+            glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+            glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+            glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+        };
+
+        const vk::DeviceSize vertexDataSize = TriangleVertexLayout::bufferSize(0, vertexCount);
+        vertexData_ = vki::Buffer::make(
+            *device_,
+            memoryProperties_,
+            {
+                .size = vertexDataSize,
+                .usage = vk::BufferUsageFlagBits::eStorageBuffer
+                    | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+                .memoryProperties = vk::MemoryPropertyFlagBits::eHostVisible
+                    | vk::MemoryPropertyFlagBits::eHostCoherent,
+            });
+
+        void* mappedVertexData = device_->mapMemory(*vertexData_.memory, 0, vertexDataSize);
+        const std::array<std::span<std::byte>, 1> streams {
+            std::span(static_cast<std::byte*>(mappedVertexData), vertexDataSize),
+        };
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            TriangleVertexLayout::write<0>(streams, i, vki::vertex::Float2::encode(positions[i]));
+            TriangleVertexLayout::write<1>(
+                streams,
+                i,
+                vki::vertex::Unorm8Color::encode(colors[i]));
+        }
+        device_->unmapMemory(*vertexData_.memory);
+
+        vertexDataAddress_ = vertexData_.getDeviceAddress(*device_);
+        spdlog::info("Vertices are pulled from buffer device address {:#x}", vertexDataAddress_);
+    }
+
+    [[nodiscard]] bool isVertexPullingEnabled() const
+    {
+        return vertexDataAddress_ != 0;
+    }
+
     void createGraphicsPipeline()
     {
+        const std::string pullingVertexShaderSource = isVertexPullingEnabled()
+            ? "#version 450\n#extension GL_EXT_buffer_reference : require\n"
+                + TriangleVertexLayout::pullingShaderSource() + kPullingVertexShaderMain
+            : std::string {};
         vk::UniqueShaderModule vertexShader = vki::Shader::compileGlslToSpv(
             *device_,
-            kVertexShaderSource,
+            isVertexPullingEnabled() ? pullingVertexShaderSource.c_str() : kVertexShaderSource,
             vki::ShaderCompileInfo {
                 .shaderStage = GLSLANG_STAGE_VERTEX,
                 .inputIdentifier = "vertex shader",
@@ -381,7 +631,7 @@ private:
             fragmentShaderStageCreateInfo,
         };
 
-        std::vector<vk::DynamicState> dynamicStates {
+        std::array dynamicStates {
             vk::DynamicState::eViewport,
             vk::DynamicState::eScissor,
         };
@@ -418,7 +668,7 @@ private:
         };
 
         vk::PipelineMultisampleStateCreateInfo multisamplingState {
-            .rasterizationSamples = vk::SampleCountFlagBits::e1,
+            .rasterizationSamples = sampleCount_,
             .sampleShadingEnable = vk::False,
         };
 
@@ -436,9 +686,28 @@ private:
             .blendConstants { { 0.0f, 0.0f, 0.0f, 0.0f } },
         };
 
+        // Reversed-Z: depth is cleared to 0 and nearer fragments have a greater depth, which
+        // spreads the floating point precision evenly over the view distance. With a depth
+        // pre-pass, the depth is already final and only the fragments matching it are shaded.
+        vk::PipelineDepthStencilStateCreateInfo depthStencilState {
+            .depthTestEnable = vk::True,
+            .depthWriteEnable = EnableDepthPrepass ? vk::False : vk::True,
+            .depthCompareOp = EnableDepthPrepass ? vk::CompareOp::eEqual
+                                                 : vk::CompareOp::eGreaterOrEqual,
+            .depthBoundsTestEnable = vk::False,
+            .stencilTestEnable = vk::False,
+        };
+
+        // The vertex data address is pushed at offset 0 of the vertex stage push constants
+        vk::PushConstantRange vertexDataPushConstantRange {
+            .stageFlags = vk::ShaderStageFlagBits::eVertex,
+            .offset = 0,
+            .size = sizeof(vk::DeviceAddress),
+        };
         vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo {
             .setLayoutCount = 0,
-            .pushConstantRangeCount = 0,
+            .pushConstantRangeCount = isVertexPullingEnabled() ? 1u : 0u,
+            .pPushConstantRanges = &vertexDataPushConstantRange,
         };
 
         pipelineLayout_ = device_->createPipelineLayoutUnique(pipelineLayoutCreateInfo);
@@ -451,11 +720,12 @@ private:
             .pViewportState = &viewportState,
             .pRasterizationState = &rasterizerState,
             .pMultisampleState = &multisamplingState,
+            .pDepthStencilState = &depthStencilState,
             .pColorBlendState = &colorBlendingState,
             .pDynamicState = &dynamicState,
             .layout = *pipelineLayout_,
             .renderPass = *renderPass_,
-            .subpass = 0,
+            .subpass = EnableDepthPrepass ? 1u : 0u,
             .basePipelineHandle = nullptr,
         };
 
@@ -467,6 +737,37 @@ private:
             throw std::runtime_error("Failed to create graphics pipeline");
         }
         graphicsPipeline_ = std::move(pipelineCreationResult.value[0]);
+
+        if (EnableDepthPrepass) {
+            // Same vertex processing without fragment shading nor color output
+            vk::PipelineDepthStencilStateCreateInfo depthPrepassDepthStencilState {
+                .depthTestEnable = vk::True,
+                .depthWriteEnable = vk::True,
+                .depthCompareOp = vk::CompareOp::eGreaterOrEqual,
+                .depthBoundsTestEnable = vk::False,
+                .stencilTestEnable = vk::False,
+            };
+            vk::PipelineColorBlendStateCreateInfo depthPrepassColorBlendingState {
+                .logicOpEnable = vk::False,
+                .attachmentCount = 0,
+            };
+            vk::GraphicsPipelineCreateInfo depthPrepassPipelineCreateInfo
+                = graphicsPipelineCreateInfo;
+            depthPrepassPipelineCreateInfo.stageCount = 1;
+            depthPrepassPipelineCreateInfo.pStages = &vertexShaderStageCreateInfo;
+            depthPrepassPipelineCreateInfo.pDepthStencilState = &depthPrepassDepthStencilState;
+            depthPrepassPipelineCreateInfo.pColorBlendState = &depthPrepassColorBlendingState;
+            depthPrepassPipelineCreateInfo.subpass = 0;
+
+            auto depthPrepassPipelineCreationResult = device_->createGraphicsPipelinesUnique(
+                nullptr,
+                { depthPrepassPipelineCreateInfo },
+                nullptr);
+            if (depthPrepassPipelineCreationResult.result != vk::Result::eSuccess) {
+                throw std::runtime_error("Failed to create depth pre-pass pipeline");
+            }
+            depthPrepassPipeline_ = std::move(depthPrepassPipelineCreationResult.value[0]);
+        }
     }
 
     void createFramebuffers()
@@ -474,10 +775,22 @@ private:
         framebuffers_.resize(swapchainImageViews_.size());
 
         for (size_t i = 0; i < swapchainImageViews_.size(); i++) {
+            // Attachments in the order of the render pass ones
+            std::vector<vk::ImageView> attachments;
+            if (isMultisampled()) {
+                attachments = {
+                    *multisampledColorImageView_,
+                    *depthImageView_,
+                    *swapchainImageViews_[i],
+                };
+            } else {
+                attachments = { *swapchainImageViews_[i], *depthImageView_ };
+            }
+
             vk::FramebufferCreateInfo framebufferCreateInfo {
                 .renderPass = *renderPass_,
-                .attachmentCount = 1,
-                .pAttachments = &*swapchainImageViews_[i],
+                .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                .pAttachments = attachments.data(),
                 .width = swapchainExtent_.width,
                 .height = swapchainExtent_.height,
                 .layers = 1,
@@ -508,6 +821,10 @@ private:
             .commandBufferCount = MaxFramesInFlight,
         };
         commandBuffers_ = device_->allocateCommandBuffersUnique(commandBufferAllocInfo);
+
+        for (stdx::LinearArena& frameArena : frameArenas_) {
+            commandStreams_.emplace_back(frameArena);
+        }
     }
 
     void createSyncObjects()
@@ -540,8 +857,10 @@ private:
 
         device_->waitIdle();
 
+        // Only needed to create the swapchain, so allocated from the current frame arena
+        stdx::LinearArenaResource frameMemoryResource { frameArenas_[currentFrame_] };
         vki::SwapchainSupportDetails swapchainSupportDetails
-            = vki::querySwapchainSupport(physicalDevice_, *surface_);
+            = vki::querySwapchainSupport(physicalDevice_, *surface_, &frameMemoryResource);
         createSwapchain(swapchainSupportDetails);
     }
 
@@ -550,7 +869,11 @@ private:
         vk::CommandBufferBeginInfo commandBufferBeginInfo {};
         cmdBuffer.begin(commandBufferBeginInfo);
 
-        vk::ClearValue clearColor { .color { .float32 { { 0.0f, 0.0f, 0.0f, 1.0f } } } };
+        // Depth is cleared to the far plane, which is 0 with reversed-Z
+        std::array clearValues {
+            vk::ClearValue { .color { .float32 { { 0.0f, 0.0f, 0.0f, 1.0f } } } },
+            vk::ClearValue { .depthStencil { .depth = 0.0f, .stencil = 0 } },
+        };
         vk::RenderPassBeginInfo renderPassBeginInfo {
             .renderPass = *renderPass_,
             .framebuffer = *framebuffers_[imageIndex],
@@ -558,39 +881,56 @@ private:
                 .offset { .x = 0, .y = 0 },
                 .extent = swapchainExtent_,
             },
-            .clearValueCount = 1,
-            .pClearValues = &clearColor,
+            .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+            .pClearValues = clearValues.data(),
         };
 
+        // Build the frame draws as a sorted command stream, then let the state tracker translate it
+        // to Vulkan calls without redundant state changes
+        vki::CommandStream& commandStream = commandStreams_[currentFrame_];
+        commandStream.clear();
+        commandStream.push(
+            0,
+            {
+                .pipeline = *graphicsPipeline_,
+                .pipelineLayout = *pipelineLayout_,
+                .viewport {
+                    .x = 0.0f,
+                    .y = 0.0f,
+                    .width = static_cast<float>(swapchainExtent_.width),
+                    .height = static_cast<float>(swapchainExtent_.height),
+                    .minDepth = 0.0f,
+                    .maxDepth = 1.0f,
+                },
+                .scissor {
+                    .offset { .x = 0, .y = 0 },
+                    .extent = swapchainExtent_,
+                },
+                .vertexDataAddress = vertexDataAddress_,
+                .elementCount = 3,
+            });
+        commandStream.sort();
+
         cmdBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
         {
-
-            cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline_);
-
-            vk::Viewport viewport {
-                .x = 0.0f,
-                .y = 0.0f,
-                .width = static_cast<float>(swapchainExtent_.width),
-                .height = static_cast<float>(swapchainExtent_.height),
-                .minDepth = 0.0f,
-                .maxDepth = 1.0f,
-            };
-            cmdBuffer.setViewport(0, { viewport });
-
-            vk::Rect2D scissor {
-                .offset { .x = 0, .y = 0 },
-                .extent = swapchainExtent_,
-            };
-            cmdBuffer.setScissor(0, { scissor });
-
-            cmdBuffer.draw(3, 1, 0, 0);
+            renderStateTracker_.reset();
+            if (EnableDepthPrepass) {
+                for (const vki::CommandStream::Entry& entry : commandStream.entries()) {
+                    vki::DrawPacket depthPrepassPacket = *entry.packet;
+                    depthPrepassPacket.pipeline = *depthPrepassPipeline_;
+                    renderStateTracker_.apply(cmdBuffer, depthPrepassPacket);
+                }
+                cmdBuffer.nextSubpass(vk::SubpassContents::eInline);
+            }
+            commandStream.replay(cmdBuffer, renderStateTracker_);
         }
         cmdBuffer.endRenderPass();
 
         cmdBuffer.end();
     }
 
-    void drawFrame()
+    // Wait for the GPU to complete the previous frame using the current frame slot
+    [[nodiscard]] bool waitForFrameSlot()
     {
         vk::Result waitResult = device_->waitForFences(
             { *inFlightFences_[currentFrame_] },
@@ -598,9 +938,55 @@ private:
             std::numeric_limits<uint64_t>::max());
         if (waitResult != vk::Result::eSuccess) {
             spdlog::warn("waitForFences returned {}, skipping frame", to_string(waitResult));
+            return false;
+        }
+
+        if (submittedFrames_[currentFrame_].has_value()) {
+            framePacer_.onFrameCompleted(
+                submittedFrames_[currentFrame_]->start,
+                submittedFrames_[currentFrame_]->submission,
+                vki::FramePacer::Clock::now());
+            submittedFrames_[currentFrame_].reset();
+        }
+
+        // The previous use of this frame slot has retired, its temporaries can be discarded
+        frameArenas_[currentFrame_].reset();
+        return true;
+    }
+
+    void logFrameStats()
+    {
+        const vki::FramePacer::Clock::time_point now = vki::FramePacer::Clock::now();
+        if (now - lastFrameStatsLogTime_ < std::chrono::seconds { 1 }) {
             return;
         }
+        lastFrameStatsLogTime_ = now;
+
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+        const vki::FramePacerStats stats = framePacer_.takeStats();
+        spdlog::info(
+            "{} frames, input to GPU completion latency: {:.2f} ms average, {:.2f} ms max",
+            stats.frameCount,
+            Milliseconds { stats.averageLatency }.count(),
+            Milliseconds { stats.maxLatency }.count());
+
+        if (presentWaiter_.isRunning()) {
+            const vki::PresentLatencyStats presentStats = presentWaiter_.takeStats();
+            spdlog::info(
+                "Input to display latency: {:.2f} ms average, {:.2f} ms max, {}",
+                Milliseconds { presentStats.frameStartToDisplay.average() }.count(),
+                Milliseconds { presentStats.frameStartToDisplay.max }.count(),
+                presentStats.frameStartToDisplay.toString());
+            spdlog::info(
+                "Present to display latency: {:.2f} ms average, {:.2f} ms max, {}",
+                Milliseconds { presentStats.presentToDisplay.average() }.count(),
+                Milliseconds { presentStats.presentToDisplay.max }.count(),
+                presentStats.presentToDisplay.toString());
+        }
+    }
 
+    void drawFrame(vki::FramePacer::Clock::time_point frameStart)
+    {
         uint32_t imageIndex;
         vk::Result acquireNextImageResult = device_->acquireNextImageKHR(
             *swapchain_,
@@ -640,10 +1026,24 @@ private:
             .pSignalSemaphores = signalSemaphores,
         };
         graphicsQueue_.submit({ submitInfo }, *inFlightFences_[currentFrame_]);
+        const vki::FramePacer::Clock::time_point submission = vki::FramePacer::Clock::now();
+        framePacer_.onFrameSubmitted(frameStart, submission);
+        submittedFrames_[currentFrame_] = SubmittedFrame {
+            .start = frameStart,
+            .submission = submission,
+        };
 
         vk::SwapchainKHR swapchains[] = { *swapchain_ };
 
+        // Tag the present so that the present waiter can tell when it is displayed
+        const uint64_t presentId = presentWaiter_.nextPresentId();
+        vk::PresentIdKHR presentIdInfo {
+            .swapchainCount = 1,
+            .pPresentIds = &presentId,
+        };
+
         vk::PresentInfoKHR presentInfo {
+            .pNext = presentWaiter_.isRunning() ? &presentIdInfo : nullptr,
             .waitSemaphoreCount = 1,
             .pWaitSemaphores = signalSemaphores,
             .swapchainCount = 1,
@@ -651,6 +1051,10 @@ private:
             .pImageIndices = &imageIndex,
         };
         vk::Result presentationResult = presentationQueue_.presentKHR(&presentInfo);
+        if (presentationResult == vk::Result::eSuccess
+            || presentationResult == vk::Result::eSuboptimalKHR) {
+            presentWaiter_.onPresentQueued(presentId, frameStart);
+        }
         if (presentationResult == vk::Result::eErrorOutOfDateKHR
             || presentationResult == vk::Result::eSuboptimalKHR || framebufferResized_) {
             spdlog::warn(
@@ -667,14 +1071,25 @@ private:
     void mainLoop()
     {
         while (!glfwWindowShouldClose(window_)) {
+            // Block on the GPU and sleep before sampling the input rather than after, so that
+            // frames are rendered with the freshest input
+            const bool frameSlotAvailable = waitForFrameSlot();
+            presentWaiter_.waitForQueuedPresents(
+                MaxQueuedPresents,
+                std::chrono::milliseconds { 100 });
+            const vki::FramePacer::Clock::time_point frameStart = framePacer_.waitForNextFrame();
             glfwPollEvents();
-            drawFrame();
+            if (frameSlotAvailable) {
+                drawFrame(frameStart);
+            }
+            logFrameStats();
         }
         device_->waitIdle();
     }
 
     void cleanupVulkan()
     {
+        presentWaiter_.stop();
     }
 
     void cleanupWindow()
@@ -695,7 +1110,9 @@ private:
 
     vk::UniqueSurfaceKHR surface_;
     vk::PhysicalDevice physicalDevice_;
+    vk::PhysicalDeviceMemoryProperties memoryProperties_;
     vk::UniqueDevice device_;
+    vki::DeviceFeatureChain deviceFeatures_;
 
     QueueFamiliesInfo queueFamiliesInfo_;
     vk::Queue graphicsQueue_;
@@ -708,18 +1125,49 @@ private:
     std::vector<vk::UniqueImageView> swapchainImageViews_;
     std::vector<vk::UniqueFramebuffer> framebuffers_;
 
+    vk::SampleCountFlagBits sampleCount_ = vk::SampleCountFlagBits::e1;
+    vki::Image multisampledColorImage_;
+    vk::UniqueImageView multisampledColorImageView_;
+
+    vk::Format depthFormat_ = vk::Format::eUndefined;
+    vki::Image depthImage_;
+    vk::UniqueImageView depthImageView_;
+
+    // Triangle vertices for vertex pulling, address 0 when they are hardcoded in the shader
+    vki::Buffer vertexData_;
+    vk::DeviceAddress vertexDataAddress_ = 0;
+
     vk::UniqueRenderPass renderPass_;
     vk::UniquePipelineLayout pipelineLayout_;
     vk::UniquePipeline graphicsPipeline_;
+    vk::UniquePipeline depthPrepassPipeline_;
 
     vk::UniqueCommandPool commandPool_;
     std::vector<vk::UniqueCommandBuffer> commandBuffers_;
 
+    // Per frame in flight storage of the CPU temporaries, such as the command streams, reset once
+    // the frame fence is signaled
+    std::array<stdx::LinearArena, MaxFramesInFlight> frameArenas_;
+    std::vector<vki::CommandStream> commandStreams_;
+    vki::RenderStateTracker renderStateTracker_;
+
     std::vector<vk::UniqueSemaphore> imageAvailableSemaphores_;
     std::vector<vk::UniqueSemaphore> renderFinishedSemaphores_;
     std::vector<vk::UniqueFence> inFlightFences_;
     uint32_t currentFrame_ = 0;
 
+    vki::FramePacer framePacer_ { TargetFrameDuration };
+    struct SubmittedFrame {
+        vki::FramePacer::Clock::time_point start;
+        vki::FramePacer::Clock::time_point submission;
+    };
+    // Frame submitted in each frame slot, until its completion is reported
+    std::array<std::optional<SubmittedFrame>, MaxFramesInFlight> submittedFrames_;
+    vki::FramePacer::Clock::time_point lastFrameStatsLogTime_;
+
+    bool presentWaitSupported_ = false;
+    vki::PresentWaiter presentWaiter_;
+
     bool framebufferResized_ = false;
 };
 
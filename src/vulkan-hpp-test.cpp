@@ -4,6 +4,8 @@
 #include "glm.hpp"
 #include "vulkan.hpp"
 
+#include "VkIgnite/VertexLayout.hpp"
+
 #include <shaderc/shaderc.hpp>
 
 #include <algorithm>
@@ -52,29 +54,11 @@ struct Vertex {
     glm::vec3 color;
 };
 
-struct VertexInputDescription {
-    static constexpr inline std::array<vk::VertexInputBindingDescription, 1> bindings {
-        vk::VertexInputBindingDescription {
-            .binding = 0,
-            .stride = sizeof(Vertex),
-            .inputRate = vk::VertexInputRate::eVertex,
-        },
-    };
-    static constexpr inline std::array<vk::VertexInputAttributeDescription, 2> attributes {
-        vk::VertexInputAttributeDescription {
-            .location = 0,
-            .binding = 0,
-            .format = vk::Format::eR32G32B32Sfloat,
-            .offset = offsetof(Vertex, position),
-        },
-        vk::VertexInputAttributeDescription {
-            .location = 1,
-            .binding = 0,
-            .format = vk::Format::eR32G32B32Sfloat,
-            .offset = offsetof(Vertex, color),
-        },
-    };
-};
+using VertexInputDescription
+    = vki::VertexLayout<vki::VertexStreams::Interleaved, vki::vertex::Float3, vki::vertex::Float3>;
+static_assert(VertexInputDescription::bindings[0].stride == sizeof(Vertex));
+static_assert(VertexInputDescription::attributes[0].offset == offsetof(Vertex, position));
+static_assert(VertexInputDescription::attributes[1].offset == offsetof(Vertex, color));
 
 const std::array vertices {
     Vertex { .position = { 0.0f, -0.5f, 0.0f }, .color = { 1.0f, 0.0f, 0.0f } },
@@ -0,0 +1,217 @@
+#include "VkIgnite/CommandStream.hpp"
+#include "VkIgnite/CpuCulling.hpp"
+#include "VkIgnite/Frustum.hpp"
+
+#include "Stdx/LinearArena.hpp"
+
+#include "Pch/Glm.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <span>
+#include <vector>
+
+// Record the CPU side of simulated frames, culling objects and building, sorting and replaying a
+// command stream of their draws, and check that steady state frames do not allocate from the heap.
+// The command stream is replayed without a command buffer, so no GPU is needed.
+
+namespace {
+
+std::atomic<uint64_t> heapAllocationCount { 0 };
+
+void* allocate(size_t size)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Over-aligned allocations keep the pointer returned by malloc just before the aligned block
+void* allocateAligned(size_t size, std::align_val_t alignment)
+{
+    const auto alignmentValue = static_cast<size_t>(alignment);
+    auto* block = static_cast<std::byte*>(allocate(size + alignmentValue + sizeof(void*)));
+    const auto address = reinterpret_cast<uintptr_t>(block + sizeof(void*));
+    auto* aligned = reinterpret_cast<std::byte*>(
+        (address + alignmentValue - 1) & ~(uintptr_t { alignmentValue } - 1));
+    std::memcpy(aligned - sizeof(void*), &block, sizeof(void*));
+    return aligned;
+}
+
+void freeAligned(void* pointer)
+{
+    if (pointer != nullptr) {
+        void* block = nullptr;
+        std::memcpy(&block, static_cast<std::byte*>(pointer) - sizeof(void*), sizeof(void*));
+        std::free(block);
+    }
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t /*alignment*/) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t /*alignment*/) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t /*size*/, std::align_val_t /*alignment*/) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t /*size*/, std::align_val_t /*alignment*/) noexcept
+{
+    freeAligned(pointer);
+}
+
+namespace {
+
+constexpr uint32_t kFramesInFlight = 2;
+constexpr uint32_t kObjectCount = 10'000;
+constexpr uint32_t kPipelineCount = 4;
+// Frames allowed to allocate while the arenas and the containers reach their final capacity
+constexpr uint32_t kWarmUpFrames = 2 * kFramesInFlight;
+constexpr uint32_t kFrameCount = 100;
+
+// Handles are never dereferenced when replaying without a command buffer
+template<typename THandle>
+THandle makeFakeHandle(uint64_t value)
+{
+    return THandle { std::bit_cast<typename THandle::CType>(value) };
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    vki::BoundsStore bounds;
+    for (uint32_t i = 0; i < kObjectCount; i++) {
+        (void)bounds.add(glm::vec3(position(random), position(random), position(random)), 1.0f);
+    }
+    const vki::Frustum frustum {
+        .planes = {
+            glm::vec4(1.0f, 0.0f, 0.0f, 50.0f),
+            glm::vec4(-1.0f, 0.0f, 0.0f, 50.0f),
+            glm::vec4(0.0f, 1.0f, 0.0f, 50.0f),
+            glm::vec4(0.0f, -1.0f, 0.0f, 50.0f),
+            glm::vec4(0.0f, 0.0f, 1.0f, 50.0f),
+            glm::vec4(0.0f, 0.0f, -1.0f, 50.0f),
+        },
+    };
+
+    std::array<vk::Pipeline, kPipelineCount> pipelines;
+    for (uint32_t i = 0; i < kPipelineCount; i++) {
+        pipelines[i] = makeFakeHandle<vk::Pipeline>(i + 1);
+    }
+    const auto pipelineLayout = makeFakeHandle<vk::PipelineLayout>(100);
+    const auto vertexBuffer = makeFakeHandle<vk::Buffer>(200);
+
+    std::array<stdx::LinearArena, kFramesInFlight> frameArenas;
+    std::vector<vki::CommandStream> commandStreams;
+    for (stdx::LinearArena& frameArena : frameArenas) {
+        commandStreams.emplace_back(frameArena);
+    }
+    std::vector<uint16_t> visibilityMasks(bounds.chunks().size());
+    vki::RenderStateTracker renderStateTracker;
+
+    uint64_t steadyStateAllocationCount = 0;
+    for (uint32_t frame = 0; frame < kFrameCount; frame++) {
+        const uint64_t allocationCountBefore = heapAllocationCount.load();
+
+        const uint32_t frameIndex = frame % kFramesInFlight;
+        stdx::LinearArena& frameArena = frameArenas[frameIndex];
+        vki::CommandStream& commandStream = commandStreams[frameIndex];
+        frameArena.reset();
+        commandStream.clear();
+
+        vki::cullSpheres(frustum, bounds.chunks(), visibilityMasks);
+        for (uint32_t objectIndex : vki::collectVisibleObjects(visibilityMasks, frameArena)) {
+            const uint32_t pipelineIndex = objectIndex % kPipelineCount;
+            commandStream.push(
+                pipelineIndex,
+                {
+                    .pipeline = pipelines[pipelineIndex],
+                    .pipelineLayout = pipelineLayout,
+                    .viewport { .width = 800.0f, .height = 600.0f, .maxDepth = 1.0f },
+                    .scissor { .extent { .width = 800, .height = 600 } },
+                    .vertexBuffer = vertexBuffer,
+                    .elementCount = 36,
+                    .firstInstance = objectIndex,
+                });
+        }
+        commandStream.sort();
+        renderStateTracker.reset();
+        commandStream.replay(vk::CommandBuffer {}, renderStateTracker);
+
+        const uint64_t allocationCount = heapAllocationCount.load() - allocationCountBefore;
+        if (frame >= kWarmUpFrames) {
+            steadyStateAllocationCount += allocationCount;
+        }
+    }
+
+    std::cout << renderStateTracker.stats().draws << " draws per frame, "
+              << steadyStateAllocationCount << " heap allocations in "
+              << kFrameCount - kWarmUpFrames << " steady state frames\n";
+    if (renderStateTracker.stats().draws == 0) {
+        std::cerr << "No object visible, the frame does not exercise the command stream\n";
+        return EXIT_FAILURE;
+    }
+    return steadyStateAllocationCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,286 @@
+#include "VkIgnite/FrameGraph.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <source_location>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Compiles frame graphs and checks the scheduled barriers, culled passes and transient image
+// placements, which are plain data. No GPU is needed.
+
+static int failureCount = 0;
+
+static void expect(
+    bool condition,
+    std::string_view description,
+    std::source_location location = std::source_location::current())
+{
+    if (!condition) {
+        std::cerr << location.file_name() << ":" << location.line() << ": " << description
+                  << "\n";
+        failureCount++;
+    }
+}
+
+static void expectMemoryBarrier(
+    const vki::FrameGraphBarrierBatch& batch,
+    const vk::MemoryBarrier2& expected,
+    std::string_view description,
+    std::source_location location = std::source_location::current())
+{
+    expect(batch.imageBarriers.empty(), description, location);
+    expect(batch.memoryBarrier.has_value(), description, location);
+    if (batch.memoryBarrier.has_value()) {
+        expect(batch.memoryBarrier->srcStageMask == expected.srcStageMask, description, location);
+        expect(
+            batch.memoryBarrier->srcAccessMask == expected.srcAccessMask,
+            description,
+            location);
+        expect(batch.memoryBarrier->dstStageMask == expected.dstStageMask, description, location);
+        expect(
+            batch.memoryBarrier->dstAccessMask == expected.dstAccessMask,
+            description,
+            location);
+    }
+}
+
+// Buffer accesses, whose layout is ignored
+constexpr vki::ResourceAccess kTransferWrite {
+    .stageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+    .accessMask = vk::AccessFlagBits2::eTransferWrite,
+};
+constexpr vki::ResourceAccess kComputeReadWrite {
+    .stageMask = vk::PipelineStageFlagBits2::eComputeShader,
+    .accessMask = vk::AccessFlagBits2::eShaderStorageRead
+        | vk::AccessFlagBits2::eShaderStorageWrite,
+};
+
+static void testBufferHazards()
+{
+    vki::FrameGraph graph;
+    const vki::FrameGraphResourceId buffer = graph.importBuffer("indirect", {});
+    graph.addPass("clear").write(buffer, kTransferWrite);
+    graph.addPass("cull").readWrite(buffer, kComputeReadWrite);
+    graph.addPass("drawA").read(buffer, vki::access::IndirectCommandRead).sideEffects();
+    graph.addPass("drawB").read(buffer, vki::access::IndirectCommandRead).sideEffects();
+    graph.addPass("reset").write(buffer, kTransferWrite);
+    graph.compile();
+
+    const std::span<const vki::FrameGraphCompiledPass> passes = graph.compiledPasses();
+    expect(passes.size() == 5, "no pass culled");
+    if (passes.size() != 5) {
+        return;
+    }
+    expect(passes[0].barriers.empty(), "first write of an import without prior access");
+
+    using Stage = vk::PipelineStageFlagBits2;
+    using enum vk::AccessFlagBits2;
+    expectMemoryBarrier(
+        passes[1].barriers,
+        {
+            .srcStageMask = Stage::eAllTransfer,
+            .srcAccessMask = eTransferWrite,
+            .dstStageMask = Stage::eComputeShader,
+            .dstAccessMask = eShaderStorageRead | eShaderStorageWrite,
+        },
+        "RAW and WAW after the clear");
+    expectMemoryBarrier(
+        passes[2].barriers,
+        {
+            .srcStageMask = Stage::eComputeShader,
+            .srcAccessMask = eShaderStorageWrite,
+            .dstStageMask = Stage::eDrawIndirect,
+            .dstAccessMask = eIndirectCommandRead,
+        },
+        "RAW of the culling output");
+    expect(passes[3].barriers.empty(), "read after read needs no barrier");
+    expectMemoryBarrier(
+        passes[4].barriers,
+        {
+            .srcStageMask = Stage::eComputeShader | Stage::eDrawIndirect,
+            .srcAccessMask = eShaderStorageWrite,
+            .dstStageMask = Stage::eAllTransfer,
+            .dstAccessMask = eTransferWrite,
+        },
+        "WAR waits for the reads since the last write");
+    expect(graph.finalBarriers().empty(), "no final access requested");
+}
+
+static void testImageLayouts()
+{
+    vki::FrameGraph graph;
+    const vki::FrameGraphImageInfo imageInfo {
+        .format = vk::Format::eB8G8R8A8Srgb,
+        .extent = { .width = 800, .height = 600 },
+    };
+    const vki::FrameGraphResourceId swapchain = graph.importImage(
+        "swapchain",
+        imageInfo,
+        {
+            .initialAccess = vki::access::Acquire,
+            .finalAccess = vki::access::Present,
+        });
+    const vki::FrameGraphResourceId color = graph.createImage("color", imageInfo);
+    graph.addPass("draw").write(color, vki::access::ColorAttachment);
+    graph.addPass("post")
+        .read(color, vki::access::FragmentShaderSampled)
+        .write(swapchain, vki::access::ColorAttachment);
+    graph.compile();
+
+    const std::span<const vki::FrameGraphCompiledPass> passes = graph.compiledPasses();
+    expect(passes.size() == 2, "no pass culled");
+    if (passes.size() != 2) {
+        return;
+    }
+
+    using Stage = vk::PipelineStageFlagBits2;
+    using enum vk::AccessFlagBits2;
+    using enum vk::ImageLayout;
+    expect(
+        passes[0].barriers.imageBarriers
+            == std::vector<vki::FrameGraphImageBarrier> {
+                {
+                    .image = color,
+                    .srcStageMask = {},
+                    .srcAccessMask = {},
+                    .dstStageMask = Stage::eColorAttachmentOutput,
+                    .dstAccessMask = eColorAttachmentRead | eColorAttachmentWrite,
+                    .oldLayout = eUndefined,
+                    .newLayout = eColorAttachmentOptimal,
+                },
+            },
+        "overwritten image transitioned from UNDEFINED");
+    expect(!passes[0].barriers.memoryBarrier.has_value(), "no memory barrier before the draw");
+
+    expect(
+        passes[1].barriers.imageBarriers
+            == std::vector<vki::FrameGraphImageBarrier> {
+                {
+                    .image = color,
+                    .srcStageMask = Stage::eColorAttachmentOutput,
+                    .srcAccessMask = eColorAttachmentWrite,
+                    .dstStageMask = Stage::eFragmentShader,
+                    .dstAccessMask = eShaderSampledRead,
+                    .oldLayout = eColorAttachmentOptimal,
+                    .newLayout = eShaderReadOnlyOptimal,
+                },
+                {
+                    .image = swapchain,
+                    .srcStageMask = Stage::eColorAttachmentOutput,
+                    .srcAccessMask = {},
+                    .dstStageMask = Stage::eColorAttachmentOutput,
+                    .dstAccessMask = eColorAttachmentRead | eColorAttachmentWrite,
+                    .oldLayout = eUndefined,
+                    .newLayout = eColorAttachmentOptimal,
+                },
+            },
+        "RAW of the color image and swapchain image transitioned after the acquire");
+
+    expect(
+        graph.finalBarriers().imageBarriers
+            == std::vector<vki::FrameGraphImageBarrier> {
+                {
+                    .image = swapchain,
+                    .srcStageMask = Stage::eColorAttachmentOutput,
+                    .srcAccessMask = eColorAttachmentWrite,
+                    .dstStageMask = {},
+                    .dstAccessMask = {},
+                    .oldLayout = eColorAttachmentOptimal,
+                    .newLayout = ePresentSrcKHR,
+                },
+            },
+        "final present barrier");
+    expect(!graph.finalBarriers().memoryBarrier.has_value(), "no final memory barrier");
+
+    const std::span<const vki::FrameGraphLifetime> lifetimes = graph.transientLifetimes();
+    expect(
+        lifetimes.size() == 1 && lifetimes[0].image == color && lifetimes[0].firstPass == 0
+            && lifetimes[0].lastPass == 1,
+        "color image lifetime");
+}
+
+static void testCulling()
+{
+    vki::FrameGraph graph;
+    const vki::FrameGraphImageInfo imageInfo {
+        .format = vk::Format::eR8G8B8A8Unorm,
+        .extent = { .width = 64, .height = 64 },
+    };
+    const vki::FrameGraphResourceId unused = graph.createImage("unused", imageInfo);
+    const vki::FrameGraphResourceId captured = graph.createImage("captured", imageInfo);
+    graph.addPass("unusedOutput").write(unused, vki::access::ColorAttachment);
+    graph.addPass("capture").write(captured, vki::access::ColorAttachment).sideEffects();
+    graph.compile();
+
+    const std::span<const vki::FrameGraphCompiledPass> passes = graph.compiledPasses();
+    expect(passes.size() == 1, "pass with unused output culled");
+    expect(!passes.empty() && passes[0].pass == 1, "side effects pass kept");
+
+    const std::span<const vki::FrameGraphLifetime> lifetimes = graph.transientLifetimes();
+    expect(
+        lifetimes.size() == 1 && lifetimes[0].image == captured && lifetimes[0].firstPass == 0
+            && lifetimes[0].lastPass == 0,
+        "only the images of the kept passes have a lifetime");
+}
+
+static void testTransientAliasing()
+{
+    // The first and last requests never live at the same time, the middle one overlaps both
+    const std::array<vki::TransientAllocationRequest, 3> requests {
+        vki::TransientAllocationRequest {
+            .size = 100,
+            .alignment = 16,
+            .firstPass = 0,
+            .lastPass = 1,
+        },
+        vki::TransientAllocationRequest {
+            .size = 60,
+            .alignment = 16,
+            .firstPass = 1,
+            .lastPass = 2,
+        },
+        vki::TransientAllocationRequest {
+            .size = 80,
+            .alignment = 16,
+            .firstPass = 2,
+            .lastPass = 3,
+        },
+    };
+    const vki::TransientAliasingPlan plan = vki::planTransientAliasing(requests);
+
+    expect(plan.offsets.size() == requests.size(), "one offset per request");
+    if (plan.offsets.size() != requests.size()) {
+        return;
+    }
+    expect(plan.offsets[0] == 0, "largest request placed first");
+    expect(plan.offsets[2] == 0, "non overlapping lifetimes share memory");
+    expect(plan.offsets[1] == 112, "overlapping lifetimes placed after, aligned");
+    expect(plan.size == 172, "allocation covers the aliased requests");
+
+    const vki::TransientAliasingPlan emptyPlan = vki::planTransientAliasing({});
+    expect(emptyPlan.offsets.empty() && emptyPlan.size == 0, "nothing to place");
+}
+
+int main()
+{
+    try {
+        testBufferHazards();
+        testImageLayouts();
+        testCulling();
+        testTransientAliasing();
+    } catch (const std::exception& exception) {
+        std::cerr << "Unexpected exception: " << exception.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (failureCount > 0) {
+        std::cerr << failureCount << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
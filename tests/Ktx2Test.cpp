@@ -0,0 +1,134 @@
+#include "VkIgnite/Ktx2.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Parses the KTX2 fixtures generated by fixtures/generate_ktx2_fixtures.py, the fixture directory
+// being given as first argument. No GPU is needed.
+
+static int failureCount = 0;
+
+static void expect(
+    bool condition,
+    std::string_view description,
+    std::source_location location = std::source_location::current())
+{
+    if (!condition) {
+        std::cerr << location.file_name() << ":" << location.line() << ": " << description
+                  << "\n";
+        failureCount++;
+    }
+}
+
+static void testBc1(const std::string& fixtureDirectory)
+{
+    const vki::Ktx2Image image = vki::Ktx2Image::readFile(fixtureDirectory + "/bc1_8x4.ktx2");
+
+    expect(image.header.format == vk::Format::eBc1RgbUnormBlock, "BC1 format");
+    expect(image.extent() == vk::Extent2D { .width = 8, .height = 4 }, "8x4 extent");
+    expect(image.mipLevels() == 4, "full mip chain");
+
+    // Levels are stored from the smallest to the largest one, each one filled with its index
+    const std::span<const std::byte> levelData = image.levelData();
+    expect(levelData.size() == 16 + 3 * 8, "level data covers all the levels");
+    expect(levelData.front() == std::byte { 3 }, "level data starts with the smallest level");
+    expect(levelData.back() == std::byte { 0 }, "level data ends with the base level");
+
+    constexpr vk::DeviceSize bufferOffset = 256;
+    const std::vector<vk::BufferImageCopy> regions = image.copyRegions(bufferOffset);
+    expect(regions.size() == 4, "one region per level");
+    const std::array<vk::DeviceSize, 4> expectedOffsets { 24, 16, 8, 0 };
+    const std::array<vk::Extent3D, 4> expectedExtents {
+        vk::Extent3D { .width = 8, .height = 4, .depth = 1 },
+        vk::Extent3D { .width = 4, .height = 2, .depth = 1 },
+        vk::Extent3D { .width = 2, .height = 1, .depth = 1 },
+        vk::Extent3D { .width = 1, .height = 1, .depth = 1 },
+    };
+    for (uint32_t mipLevel = 0; mipLevel < regions.size(); mipLevel++) {
+        const vk::BufferImageCopy& region = regions[mipLevel];
+        expect(
+            region.bufferOffset == bufferOffset + expectedOffsets[mipLevel],
+            "region offset in the level data");
+        expect(
+            levelData[region.bufferOffset - bufferOffset] == static_cast<std::byte>(mipLevel),
+            "region offset points to its level");
+        expect(region.imageSubresource.mipLevel == mipLevel, "region mip level");
+        expect(region.imageExtent == expectedExtents[mipLevel], "region extent");
+        // copyBufferToImage requires offsets aligned to the texel block size and to 4
+        expect(region.bufferOffset % 8 == 0, "region offset aligned for BC1");
+    }
+}
+
+static void testRgba8(const std::string& fixtureDirectory)
+{
+    const vki::Ktx2Image image = vki::Ktx2Image::readFile(fixtureDirectory + "/rgba8_4x2.ktx2");
+
+    expect(image.header.format == vk::Format::eR8G8B8A8Unorm, "RGBA8 format");
+    expect(image.mipLevels() == 3, "full mip chain");
+    expect(image.levelData().size() == 32 + 8 + 4, "level data covers all the levels");
+
+    const std::vector<vk::BufferImageCopy> regions = image.copyRegions(0);
+    expect(regions.size() == 3, "one region per level");
+    expect(regions[0].bufferOffset == 12, "base level stored last");
+    expect(regions[1].bufferOffset == 4, "level 1 stored after level 2");
+    expect(regions[2].bufferOffset == 0, "smallest level stored first");
+    expect(
+        regions[1].imageExtent == vk::Extent3D { .width = 2, .height = 1, .depth = 1 },
+        "level 1 extent");
+
+    const vki::Ktx2Header header = vki::Ktx2Header::readFile(fixtureDirectory + "/rgba8_4x2.ktx2");
+    expect(header.pixelWidth == 4 && header.pixelHeight == 2, "header only read");
+}
+
+static void testMalformed(const std::string& fixtureDirectory)
+{
+    for (std::string_view fixture : {
+             "malformed_level_offset_overflow.ktx2",
+             "malformed_unknown_format.ktx2",
+             "malformed_too_many_levels.ktx2",
+             "malformed_huge_level_count.ktx2",
+             "malformed_truncated_level.ktx2",
+             "malformed_truncated_header.ktx2",
+         }) {
+        bool rejected = false;
+        try {
+            (void)vki::Ktx2Image::readFile(fixtureDirectory + "/" + std::string(fixture));
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        expect(rejected, fixture);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <fixture directory>\n";
+        return EXIT_FAILURE;
+    }
+    const std::string fixtureDirectory = argv[1];
+
+    try {
+        testBc1(fixtureDirectory);
+        testRgba8(fixtureDirectory);
+        testMalformed(fixtureDirectory);
+    } catch (const std::exception& exception) {
+        std::cerr << "Unexpected exception: " << exception.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (failureCount > 0) {
+        std::cerr << failureCount << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include "Stdx/MpscRing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <source_location>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Push from several producer threads into the ring read by a single consumer, and check that no
+// element is lost or duplicated, and that a full ring rejects exactly the elements it cannot hold.
+
+static int failureCount = 0;
+
+static void expect(
+    bool condition,
+    std::string_view description,
+    std::source_location location = std::source_location::current())
+{
+    if (!condition) {
+        std::cerr << location.file_name() << ":" << location.line() << ": " << description
+                  << "\n";
+        failureCount++;
+    }
+}
+
+constexpr uint32_t kProducerCount = 4;
+
+// Element pushed by a producer, the sequence number telling it from the other ones of the producer
+struct Element {
+    uint32_t producer = 0;
+    uint32_t sequence = 0;
+};
+
+// Start the producers together so that they contend on the ring
+static void runProducers(
+    uint32_t pushCount,
+    stdx::MpscRing<Element>& ring,
+    std::atomic<uint32_t>& rejectedCount)
+{
+    std::atomic<bool> start = false;
+    std::vector<std::jthread> producers;
+    for (uint32_t producer = 0; producer < kProducerCount; producer++) {
+        producers.emplace_back([&, producer] {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint32_t sequence = 0; sequence < pushCount; sequence++) {
+                if (!ring.tryPush({ .producer = producer, .sequence = sequence })) {
+                    rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    start.store(true, std::memory_order_release);
+}
+
+// Fewer elements than the capacity in flight, popped while the producers run
+static void testConcurrentConsumer()
+{
+    constexpr uint32_t kPushCount = 10000;
+    stdx::MpscRing<Element> ring { kProducerCount * kPushCount };
+    std::atomic<uint32_t> rejectedCount = 0;
+
+    std::vector<std::vector<bool>> received(
+        kProducerCount,
+        std::vector<bool>(kPushCount, false));
+    std::vector<uint32_t> nextSequences(kProducerCount, 0);
+    uint32_t receivedCount = 0;
+    uint32_t duplicateCount = 0;
+    uint32_t reorderedCount = 0;
+    std::jthread consumer { [&] {
+        Element element;
+        while (receivedCount < kProducerCount * kPushCount) {
+            if (!ring.tryPop(element)) {
+                std::this_thread::yield();
+                continue;
+            }
+            receivedCount++;
+            if (received[element.producer][element.sequence]) {
+                duplicateCount++;
+            }
+            received[element.producer][element.sequence] = true;
+            // The pushes of a producer are ordered
+            if (element.sequence != nextSequences[element.producer]) {
+                reorderedCount++;
+            }
+            nextSequences[element.producer] = element.sequence + 1;
+        }
+    } };
+
+    runProducers(kPushCount, ring, rejectedCount);
+    consumer.join();
+
+    expect(rejectedCount == 0, "no push rejected below the capacity");
+    expect(duplicateCount == 0, "no element popped twice");
+    expect(reorderedCount == 0, "elements of a producer popped in push order");
+    for (const std::vector<bool>& producerReceived : received) {
+        expect(std::ranges::all_of(producerReceived, std::identity {}), "every element popped");
+    }
+    Element element;
+    expect(!ring.tryPop(element), "ring empty after popping every element");
+}
+
+// More elements than the capacity pushed before the consumer pops
+static void testFullRing()
+{
+    constexpr uint32_t kPushCount = 100;
+    stdx::MpscRing<Element> ring { 200 };
+    expect(ring.capacity() == 256, "capacity rounded up to a power of two");
+    std::atomic<uint32_t> rejectedCount = 0;
+
+    runProducers(kPushCount, ring, rejectedCount);
+
+    const uint32_t pushCount = kProducerCount * kPushCount;
+    expect(rejectedCount == pushCount - ring.capacity(), "pushes past the capacity rejected");
+
+    std::vector<std::vector<bool>> received(
+        kProducerCount,
+        std::vector<bool>(kPushCount, false));
+    uint32_t receivedCount = 0;
+    uint32_t duplicateCount = 0;
+    Element element;
+    while (ring.tryPop(element)) {
+        receivedCount++;
+        if (received[element.producer][element.sequence]) {
+            duplicateCount++;
+        }
+        received[element.producer][element.sequence] = true;
+    }
+    expect(receivedCount == ring.capacity(), "every accepted element popped");
+    expect(duplicateCount == 0, "no element popped twice");
+
+    // The cells freed by the consumer are reused after the positions wrapped around
+    expect(ring.tryPush({ .producer = 0, .sequence = kPushCount }), "push after draining");
+    expect(
+        ring.tryPop(element) && element.producer == 0 && element.sequence == kPushCount,
+        "pop after draining");
+}
+
+int main()
+{
+    try {
+        testConcurrentConsumer();
+        testFullRing();
+    } catch (const std::exception& exception) {
+        std::cerr << "Unexpected exception: " << exception.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (failureCount > 0) {
+        std::cerr << failureCount << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
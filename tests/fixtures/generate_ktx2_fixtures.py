@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Generate the small KTX2 files used by Ktx2Test.cpp.
+
+Only the fields read by vki::Ktx2Image are filled, the data format descriptor and key/value data
+are left empty. Run from this directory to regenerate the fixtures.
+"""
+
+import struct
+
+IDENTIFIER = bytes([0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A])
+HEADER_SIZE = 80
+LEVEL_INDEX_ENTRY_SIZE = 24
+
+VK_FORMAT_R8G8B8A8_UNORM = 37
+VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131
+
+
+def header(vk_format, width, height, level_count, supercompression_scheme=0):
+    return IDENTIFIER + struct.pack(
+        "<9I4I2Q",
+        vk_format,
+        1,  # typeSize
+        width,
+        height,
+        0,  # pixelDepth
+        0,  # layerCount
+        1,  # faceCount
+        level_count,
+        supercompression_scheme,
+        0,  # dfdByteOffset
+        0,  # dfdByteLength
+        0,  # kvdByteOffset
+        0,  # kvdByteLength
+        0,  # sgdByteOffset
+        0,  # sgdByteLength
+    )
+
+
+def level_index(levels):
+    return b"".join(struct.pack("<3Q", offset, length, length) for offset, length in levels)
+
+
+def image(vk_format, width, height, level_sizes, alignment):
+    """Levels are stored from the smallest to the largest one, as the KTX2 spec requires."""
+    offset = HEADER_SIZE + LEVEL_INDEX_ENTRY_SIZE * len(level_sizes)
+    levels = [None] * len(level_sizes)
+    data = b""
+    for mip_level in reversed(range(len(level_sizes))):
+        padding = -(offset + len(data)) % alignment
+        data += bytes(padding)
+        levels[mip_level] = (offset + len(data), level_sizes[mip_level])
+        # Each level is filled with its index to check the copies
+        data += bytes([mip_level]) * level_sizes[mip_level]
+    return header(vk_format, width, height, len(level_sizes)) + level_index(levels) + data
+
+
+def write(filename, content):
+    with open(filename, "wb") as file:
+        file.write(content)
+
+
+# 8x4 BC1 texture with a full mip chain: 2x1, 1x1, 1x1 and 1x1 blocks of 8 bytes
+write("bc1_8x4.ktx2", image(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 8, 4, [16, 8, 8, 8], 8))
+
+# 4x2 RGBA8 texture with a full mip chain
+write("rgba8_4x2.ktx2", image(VK_FORMAT_R8G8B8A8_UNORM, 4, 2, [32, 8, 4], 4))
+
+# Level offset close to 2^64, wrapping around when its length is added
+write(
+    "malformed_level_offset_overflow.ktx2",
+    header(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 1)
+    + level_index([(2**64 - 8, 8)])
+    + bytes(8),
+)
+
+# Format unknown to Vulkan, which has no block size, so that an empty level has the expected size
+write(
+    "malformed_unknown_format.ktx2",
+    header(0x7FFF0000, 4, 4, 1) + level_index([(104, 0)]),
+)
+
+# More levels than a 4x4 extent allows, with an index entry for each of them
+write(
+    "malformed_too_many_levels.ktx2",
+    header(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 40)
+    + level_index([(HEADER_SIZE + 40 * LEVEL_INDEX_ENTRY_SIZE, 8)] * 40)
+    + bytes(8),
+)
+
+# Huge level count with a tiny file
+write(
+    "malformed_huge_level_count.ktx2",
+    header(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 0xFFFFFFFF),
+)
+
+# Level ending past the end of the file
+write(
+    "malformed_truncated_level.ktx2",
+    header(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 1) + level_index([(104, 8)]) + bytes(4),
+)
+
+# Header cut in the middle
+write("malformed_truncated_header.ktx2", header(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 4, 1)[:40])